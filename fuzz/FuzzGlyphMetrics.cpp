@@ -0,0 +1,29 @@
+/*
+ * FuzzGlyphMetrics.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdexcept>
+
+#include "GlyphMetrics.h"
+
+/*! \brief decodes arbitrary data as table of compact metrics
+ *
+ *  The first byte selects the encoding and whether the records contain the
+ *  page, the second byte the number of records, the rest is the table.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size < 2) {
+        return 0;
+    }
+    MetricsEncoding encoding = (data[0] & 1) ? MetricsEncoding::CompactDelta : MetricsEncoding::Compact;
+    bool withPage = data[0] & 2;
+    try {
+        decodeGlyphMetrics(data + 2, size - 2, data[1], encoding, withPage);
+    } catch (const std::runtime_error&) {
+    }
+    return 0;
+}
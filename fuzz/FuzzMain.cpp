@@ -0,0 +1,33 @@
+/*
+ * FuzzMain.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+/*! \brief runs a fuzz target on the given files, used for compilers without libFuzzer
+ *
+ *  This allows to reproduce crashes found by the fuzzer and to run a
+ *  corpus as regression test with any compiler.
+ */
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        std::ifstream fp(argv[i], std::ifstream::in | std::ifstream::binary);
+        if (fp.fail()) {
+            std::cerr << "File \"" << argv[i] << "\" could not be read." << std::endl;
+            return 1;
+        }
+        std::vector<uint8_t> data((std::istreambuf_iterator<char>(fp)), std::istreambuf_iterator<char>());
+        LLVMFuzzerTestOneInput(data.data(), data.size());
+        std::cout << argv[i] << ": ok" << std::endl;
+    }
+    return 0;
+}
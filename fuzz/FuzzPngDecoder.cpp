@@ -0,0 +1,20 @@
+/*
+ * FuzzPngDecoder.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdexcept>
+
+#include "PngEncoder.h"
+
+/*! \brief decodes arbitrary data as PNG image, malformed data has to be rejected with an exception */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    try {
+        decodePng(data, size);
+    } catch (const std::runtime_error&) {
+    }
+    return 0;
+}
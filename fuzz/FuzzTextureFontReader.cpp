@@ -0,0 +1,24 @@
+/*
+ * FuzzTextureFontReader.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdexcept>
+
+#include "TextureFontReader.h"
+
+/*! \brief parses arbitrary data as texture font, malformed data has to be rejected with an exception */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    try {
+        TextureFontReader reader(data, size);
+        reader.validate();
+        for (uint32_t level = 0; level < reader.getMipLevelCount(); level++) {
+            reader.getPixelData(level);
+        }
+    } catch (const std::runtime_error&) {
+    }
+    return 0;
+}
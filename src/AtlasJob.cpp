@@ -0,0 +1,256 @@
+/*
+ * AtlasJob.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "AtlasJob.h"
+
+#include <unistd.h>
+#include <atomic>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+#include <nlohmann/json.hpp>
+
+std::vector<std::filesystem::path> AtlasJob::getInputFiles() const {
+    std::vector<std::filesystem::path> files = {fontpath};
+    files.insert(files.end(), fallbackFontpaths.begin(), fallbackFontpaths.end());
+    if (!charsetPath.empty()) {
+        files.push_back(charsetPath);
+    }
+    return files;
+}
+
+std::u8string readCharsetFile(const std::filesystem::path& path) {
+    std::ifstream fp(path, std::ifstream::in | std::ifstream::binary);
+    if (fp.fail()) {
+        std::stringstream errorText;
+        errorText << "File \"" << path.native() << "\" could not be read.";
+        throw std::runtime_error(errorText.str());
+    }
+
+    std::string content((std::istreambuf_iterator<char>(fp)), std::istreambuf_iterator<char>());
+    std::u8string chars;
+    for (char c : content) {
+        if (c != '\n' && c != '\r') {
+            chars.push_back(static_cast<char8_t>(c));
+        }
+    }
+    return chars;
+}
+
+static AtlasJob parseAtlasJsonObject(const nlohmann::json& atlas, const std::filesystem::path& directory) {
+    auto resolve = [&directory](const std::string& file) {
+        return directory / std::filesystem::path(file);
+    };
+
+    AtlasJob job;
+    if (atlas.contains("output")) {
+        job.output = resolve(atlas.at("output").get<std::string>());
+    }
+    job.fontpath = resolve(atlas.at("font").get<std::string>());
+    job.faceIndex = atlas.value("face_index", 0u);
+    job.variation = parseFontVariation(atlas.value("instance", ""));
+    job.fontSize = atlas.at("size").get<double>();
+    for (const nlohmann::json& fallback : atlas.value("fallback_fonts", nlohmann::json::array())) {
+        job.fallbackFontpaths.push_back(resolve(fallback.get<std::string>()));
+    }
+    std::string chars = atlas.value("chars", "");
+    job.chars = std::u8string(chars.begin(), chars.end());
+    if (atlas.contains("charset")) {
+        job.charsetPath = resolve(atlas.at("charset").get<std::string>());
+    }
+    job.enableAntiAliasing = atlas.value("antialiasing", true);
+    job.enableHinting = atlas.value("hinting", true);
+    job.enableLcdRendering = atlas.value("lcd", false);
+    job.subpixelPhases = atlas.value("subpixel_phases", 1u);
+    if (job.subpixelPhases < 1 || job.subpixelPhases > 64) {
+        std::stringstream errorText;
+        errorText << "The number of sub pixel phases " << job.subpixelPhases << " is not between 1 and 64.";
+        throw std::runtime_error(errorText.str());
+    }
+    job.forcePowerOfTwo = atlas.value("power_of_two", false);
+    job.optimizePacking = atlas.value("optimize_packing", false);
+    job.optimizeTimeLimit = atlas.value("optimize_time_limit", 0u);
+    job.streaming = atlas.value("streaming", false);
+    return job;
+}
+
+std::vector<AtlasJob> readBatchFile(const std::filesystem::path& path) {
+    std::ifstream fp(path, std::ifstream::in | std::ifstream::binary);
+    if (fp.fail()) {
+        std::stringstream errorText;
+        errorText << "File \"" << path.native() << "\" could not be read.";
+        throw std::runtime_error(errorText.str());
+    }
+
+    std::vector<AtlasJob> jobs;
+    try {
+        nlohmann::json json = nlohmann::json::parse(fp);
+        for (const nlohmann::json& atlas : json.at("atlases")) {
+            AtlasJob job = parseAtlasJsonObject(atlas, path.parent_path());
+            if (job.output.empty()) {
+                throw std::runtime_error("Every atlas of a batch file needs an output file.");
+            }
+            if (!atlas.contains("instances")) {
+                jobs.push_back(job);
+                continue;
+            }
+
+            if (atlas.contains("instance")) {
+                throw std::runtime_error("An atlas of a batch file cannot have both \"instance\" and \"instances\".");
+            }
+            std::vector<FontVariation> instances;
+            for (const nlohmann::json& instance : atlas.at("instances")) {
+                instances.push_back(parseFontVariation(instance.get<std::string>()));
+            }
+            std::vector<AtlasJob> expanded = expandInstances(job, instances);
+            jobs.insert(jobs.end(), expanded.begin(), expanded.end());
+        }
+    } catch (nlohmann::json::exception& e) {
+        std::stringstream errorText;
+        errorText << "Batch file \"" << path.native() << "\" is invalid: " << e.what();
+        throw std::runtime_error(errorText.str());
+    }
+    return jobs;
+}
+
+AtlasJob parseAtlasJob(const std::string& json, const std::filesystem::path& directory) {
+    try {
+        return parseAtlasJsonObject(nlohmann::json::parse(json), directory);
+    } catch (nlohmann::json::exception& e) {
+        std::stringstream errorText;
+        errorText << "Atlas job is invalid: " << e.what();
+        throw std::runtime_error(errorText.str());
+    }
+}
+
+std::string writeAtlasJob(const AtlasJob& job) {
+    nlohmann::json json;
+    if (!job.output.empty()) {
+        json["output"] = job.output.string();
+    }
+    json["font"] = job.fontpath.string();
+    json["face_index"] = job.faceIndex;
+    json["instance"] = job.variation.toString();
+    json["size"] = job.fontSize;
+    json["fallback_fonts"] = nlohmann::json::array();
+    for (const std::filesystem::path& fallback : job.fallbackFontpaths) {
+        json["fallback_fonts"].push_back(fallback.string());
+    }
+    json["chars"] = std::string(job.chars.begin(), job.chars.end());
+    if (!job.charsetPath.empty()) {
+        json["charset"] = job.charsetPath.string();
+    }
+    json["antialiasing"] = job.enableAntiAliasing;
+    json["hinting"] = job.enableHinting;
+    json["lcd"] = job.enableLcdRendering;
+    json["subpixel_phases"] = job.subpixelPhases;
+    json["power_of_two"] = job.forcePowerOfTwo;
+    json["optimize_packing"] = job.optimizePacking;
+    json["optimize_time_limit"] = job.optimizeTimeLimit;
+    json["streaming"] = job.streaming;
+    return json.dump();
+}
+
+std::vector<AtlasJob> expandInstances(const AtlasJob& job, const std::vector<FontVariation>& instances) {
+    std::vector<AtlasJob> jobs;
+    for (const FontVariation& instance : instances) {
+        // the description is turned into a file name, "Semi Bold,wdth=80" becomes "SemiBold-wdth80"
+        std::string suffix;
+        for (char c : instance.toString()) {
+            if (c == ',') {
+                suffix.push_back('-');
+            } else if (c != '=' && c != ' ' && c != '/' && c != '\\') {
+                suffix.push_back(c);
+            }
+        }
+
+        AtlasJob instanceJob = job;
+        instanceJob.variation = instance;
+        if (!suffix.empty()) {
+            std::filesystem::path output = job.output.parent_path() / job.output.stem();
+            output += "-" + suffix;
+            output += job.output.extension();
+            instanceJob.output = output;
+        }
+        jobs.push_back(instanceJob);
+    }
+    return jobs;
+}
+
+FontVariant getFontVariant(const AtlasJob& job) {
+    FontVariant variant;
+    variant.fontpath = job.fontpath;
+    variant.faceIndex = job.faceIndex;
+    variant.variation = job.variation;
+    variant.fallbackFontpaths = job.fallbackFontpaths;
+    variant.fontSize = job.fontSize;
+    variant.chars = job.chars;
+    if (!job.charsetPath.empty()) {
+        variant.chars += readCharsetFile(job.charsetPath);
+    }
+    variant.enableAntiAliasing = job.enableAntiAliasing;
+    variant.enableHinting = job.enableHinting;
+    variant.enableLcdRendering = job.enableLcdRendering;
+    variant.subpixelPhases = job.subpixelPhases;
+    return variant;
+}
+
+AtlasOptions getAtlasOptions(const AtlasJob& job) {
+    AtlasOptions options;
+    options.optimizePacking = job.optimizePacking;
+    options.optimizeTimeLimit = job.optimizeTimeLimit;
+    options.streaming = job.streaming;
+    // block compressed formats store blocks of 4x4 pixels
+    std::string extension = job.output.extension().string();
+    if (extension == ".dds" || extension == ".ktx") {
+        options.sizeAlignment = 4;
+    }
+    return options;
+}
+
+std::shared_ptr<TextureFontCreator> createTextureFont(const AtlasJob& job, std::shared_ptr<GlyphCache> glyphCache) {
+    FontVariant variant = getFontVariant(job);
+    variant.glyphCache = glyphCache;
+
+    return std::shared_ptr<TextureFontCreator>(new TextureFontCreator({variant}, job.forcePowerOfTwo, getAtlasOptions(job)));
+}
+
+void writeFileAtomically(const std::filesystem::path& path, const std::function<void(const std::filesystem::path&)>& write) {
+    // unique for every write, so processes and threads writing the same file do not share a temporary file
+    static std::atomic<uint64_t> s_counter(0);
+    std::filesystem::path temporaryPath = path;
+    temporaryPath += "." + std::to_string(getpid()) + "-" + std::to_string(s_counter++) + ".tmp";
+
+    try {
+        write(temporaryPath);
+        std::filesystem::rename(temporaryPath, path);
+    } catch (...) {
+        std::error_code error;
+        std::filesystem::remove(temporaryPath, error);
+        throw;
+    }
+}
+
+void writeTextureFont(TextureFontCreator& creator, const std::filesystem::path& path) {
+    writeFileAtomically(path, [&creator, &path](const std::filesystem::path& temporaryPath) {
+        std::string extension = path.extension().string();
+        if (extension == ".stf") {
+            creator.writeToSimpleFile(temporaryPath);
+        } else if (extension == ".json") {
+            creator.writeToJsonFile(temporaryPath);
+        } else if (extension == ".png") {
+            creator.writeToPngFile(temporaryPath);
+        } else if (extension == ".dds") {
+            creator.writeToDdsFile(temporaryPath);
+        } else if (extension == ".ktx") {
+            creator.writeToKtxFile(temporaryPath, BlockFormat::EacR11);
+        } else {
+            creator.writeToFile(temporaryPath);
+        }
+    });
+}
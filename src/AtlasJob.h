@@ -0,0 +1,109 @@
+/*
+ * AtlasJob.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef ATLASJOB_H_
+#define ATLASJOB_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+#include <memory>
+#include <filesystem>
+
+#include "TextureFontCreator.h"
+
+/*! \brief Description of a texture font to build and the file to write it to */
+struct AtlasJob {
+    std::filesystem::path output; //!< output file, the format is chosen by the extension (.ytf, .stf, .json, .png, .dds or .ktx)
+    std::filesystem::path fontpath;
+    uint32_t faceIndex = 0; //!< index of the face in fontpath if it is a font collection (TTC)
+    FontVariation variation; //!< instance of fontpath if it is a variable font
+    std::vector<std::filesystem::path> fallbackFontpaths;
+    double fontSize = 16;
+    std::u8string chars; //!< characters to render
+    std::filesystem::path charsetPath; //!< optional UTF-8 file with further characters to render
+    bool enableAntiAliasing = true;
+    bool enableHinting = true;
+    bool enableLcdRendering = false; //!< see FontVariant::enableLcdRendering
+    uint32_t subpixelPhases = 1; //!< see FontVariant::subpixelPhases
+    bool forcePowerOfTwo = false;
+    bool optimizePacking = false; //!< see AtlasOptions::optimizePacking
+    uint32_t optimizeTimeLimit = 0; //!< see AtlasOptions::optimizeTimeLimit
+    bool streaming = false; //!< see AtlasOptions::streaming
+
+    /*! \brief returns all files the texture font is created from */
+    std::vector<std::filesystem::path> getInputFiles() const;
+};
+
+/*! \brief reads the characters of a UTF-8 encoded file, line breaks are ignored */
+std::u8string readCharsetFile(const std::filesystem::path& path);
+
+/*! \brief reads a JSON file describing several texture fonts
+ *
+ *  The file contains an object with an array "atlases", each entry has the
+ *  keys "output", "font", "size" and optionally "face_index", "instance",
+ *  "fallback_fonts", "chars", "charset", "antialiasing", "hinting", "lcd",
+ *  "subpixel_phases", "power_of_two", "optimize_packing",
+ *  "optimize_time_limit" and "streaming". Relative
+ *  paths are relative to the directory of the file. Instances of variable
+ *  fonts are given in the format of parseFontVariation().
+ *
+ *  An entry may give an array "instances" instead of "instance", it is
+ *  expanded into one job per instance, see expandInstances().
+ */
+std::vector<AtlasJob> readBatchFile(const std::filesystem::path& path);
+
+/*! \brief parses a single job in the format of an entry of a batch file, "output" is optional
+ *
+ *  \param directory relative paths are relative to this directory
+ */
+AtlasJob parseAtlasJob(const std::string& json, const std::filesystem::path& directory = std::filesystem::path());
+
+/*! \brief returns a job in the format of an entry of a batch file */
+std::string writeAtlasJob(const AtlasJob& job);
+
+/*! \brief creates a job for every instance of a variable font
+ *
+ *  The jobs only differ in the instance and the output file, the name of the
+ *  instance is appended to the name of the output file, e.g. font-Bold.ytf
+ *  or font-wght650.ytf. When the jobs are built together, they share the
+ *  loaded font.
+ */
+std::vector<AtlasJob> expandInstances(const AtlasJob& job, const std::vector<FontVariation>& instances);
+
+/*! \brief returns the font variant of a job, the characters of the charset file are included */
+FontVariant getFontVariant(const AtlasJob& job);
+
+/*! \brief returns the packing options of a job
+ *
+ *  The size of the image is aligned to 4 for block compressed output files
+ *  (.dds and .ktx).
+ */
+AtlasOptions getAtlasOptions(const AtlasJob& job);
+
+/*! \brief creates the texture font of a job
+ *
+ *  \param glyphCache if set, characters of the previous build of this job are reused
+ */
+std::shared_ptr<TextureFontCreator> createTextureFont(const AtlasJob& job, std::shared_ptr<GlyphCache> glyphCache = nullptr);
+
+/*! \brief writes a file atomically
+ *
+ *  The write function is called with a unique temporary path in the same
+ *  directory, the file is renamed to path afterwards. The write function must
+ *  throw if the file could not be written completely, the file is not renamed
+ *  then and the temporary file is removed.
+ */
+void writeFileAtomically(const std::filesystem::path& path, const std::function<void(const std::filesystem::path&)>& write);
+
+/*! \brief writes a texture font in the format given by the extension of the path
+ *
+ *  The file is written to a temporary file in the same directory first and
+ *  renamed afterwards, so readers never see a partially written file.
+ */
+void writeTextureFont(TextureFontCreator& creator, const std::filesystem::path& path);
+
+#endif /* ATLASJOB_H_ */
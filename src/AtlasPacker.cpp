@@ -0,0 +1,364 @@
+/*
+ * AtlasPacker.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "AtlasPacker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <tuple>
+
+#include "Instrumentation.h"
+#include "ParallelFor.h"
+
+// All algorithms work on rectangles enlarged by the padding in an image
+// enlarged by the padding, so the padding ends up between the rectangles only.
+
+std::string getPackingOrderName(PackingOrder order) {
+    switch (order) {
+    case PackingOrder::Height: return "height";
+    case PackingOrder::Width: return "width";
+    case PackingOrder::Area: return "area";
+    case PackingOrder::Perimeter: return "perimeter";
+    }
+    return "unknown";
+}
+
+std::string getPackingAlgorithmName(PackingAlgorithm algorithm) {
+    switch (algorithm) {
+    case PackingAlgorithm::Shelf: return "shelf";
+    case PackingAlgorithm::Skyline: return "skyline";
+    case PackingAlgorithm::MaxRectsBestShortSideFit: return "MaxRects best short side fit";
+    case PackingAlgorithm::MaxRectsBestLongSideFit: return "MaxRects best long side fit";
+    case PackingAlgorithm::MaxRectsBestAreaFit: return "MaxRects best area fit";
+    case PackingAlgorithm::MaxRectsBottomLeft: return "MaxRects bottom left";
+    }
+    return "unknown";
+}
+
+std::vector<uint32_t> getPackingOrder(const std::vector<PackingRectangle>& rectangles, PackingOrder order) {
+    auto key = [order](const PackingRectangle& rect) {
+        uint64_t width = rect.width;
+        uint64_t height = rect.height;
+        switch (order) {
+        case PackingOrder::Height: return std::make_pair(height, width);
+        case PackingOrder::Width: return std::make_pair(width, height);
+        case PackingOrder::Area: return std::make_pair(width * height, std::max(width, height));
+        case PackingOrder::Perimeter: return std::make_pair(width + height, std::max(width, height));
+        }
+        return std::make_pair(height, width);
+    };
+
+    std::vector<uint32_t> indices(rectangles.size());
+    for (uint32_t i = 0; i < indices.size(); i++) {
+        indices[i] = i;
+    }
+    std::stable_sort(indices.begin(), indices.end(), [&](uint32_t a, uint32_t b) {
+        return key(rectangles[a]) > key(rectangles[b]);
+    });
+    return indices;
+}
+
+static bool packShelf(std::vector<PackingRectangle>& rectangles, const std::vector<uint32_t>& order, uint64_t size, uint32_t padding) {
+    uint64_t left = 0;
+    uint64_t top = 0;
+    uint64_t shelfHeight = 0;
+    for (uint32_t index : order) {
+        PackingRectangle& rect = rectangles[index];
+        uint64_t width = rect.width + padding;
+        uint64_t height = rect.height + padding;
+        if (left + width > size) {
+            top += shelfHeight;
+            left = 0;
+            shelfHeight = 0;
+        }
+        if (width > size || top + height > size) {
+            return false;
+        }
+
+        rect.left = left;
+        rect.top = top;
+        left += width;
+        shelfHeight = std::max(shelfHeight, height);
+    }
+    return true;
+}
+
+static bool packSkyline(std::vector<PackingRectangle>& rectangles, const std::vector<uint32_t>& order, uint64_t size, uint32_t padding) {
+    // the outline of the placed rectangles seen from the bottom of the image
+    struct Segment {
+        uint64_t left;
+        uint64_t top;
+        uint64_t width;
+    };
+    std::vector<Segment> skyline = {{0, 0, size}};
+
+    for (uint32_t index : order) {
+        PackingRectangle& rect = rectangles[index];
+        uint64_t width = rect.width + padding;
+        uint64_t height = rect.height + padding;
+
+        // lowest bottom edge, then leftmost position
+        size_t bestSegment = skyline.size();
+        uint64_t bestBottom = std::numeric_limits<uint64_t>::max();
+        uint64_t bestTop = 0;
+        for (size_t i = 0; i < skyline.size() && skyline[i].left + width <= size; i++) {
+            uint64_t top = 0;
+            uint64_t covered = 0;
+            for (size_t j = i; covered < width; j++) {
+                top = std::max(top, skyline[j].top);
+                covered += skyline[j].width;
+            }
+            if (top + height <= size && top + height < bestBottom) {
+                bestSegment = i;
+                bestBottom = top + height;
+                bestTop = top;
+            }
+        }
+        if (bestSegment == skyline.size()) {
+            return false;
+        }
+
+        uint64_t left = skyline[bestSegment].left;
+        rect.left = left;
+        rect.top = bestTop;
+
+        // the new segment replaces the parts of the skyline below the rectangle
+        skyline.insert(skyline.begin() + bestSegment, Segment{left, bestBottom, width});
+        size_t next = bestSegment + 1;
+        while (next < skyline.size() && skyline[next].left < left + width) {
+            uint64_t end = skyline[next].left + skyline[next].width;
+            if (end <= left + width) {
+                skyline.erase(skyline.begin() + next);
+            } else {
+                skyline[next].width = end - (left + width);
+                skyline[next].left = left + width;
+                break;
+            }
+        }
+
+        // merge neighbours of the same height
+        for (size_t i = 1; i < skyline.size(); ) {
+            if (skyline[i - 1].top == skyline[i].top) {
+                skyline[i - 1].width += skyline[i].width;
+                skyline.erase(skyline.begin() + i);
+            } else {
+                i++;
+            }
+        }
+    }
+    return true;
+}
+
+namespace { // anonymous namespace
+
+struct FreeRectangle {
+    uint64_t left;
+    uint64_t top;
+    uint64_t width;
+    uint64_t height;
+
+    bool contains(const FreeRectangle& other) const {
+        return other.left >= left && other.top >= top &&
+               other.left + other.width <= left + width &&
+               other.top + other.height <= top + height;
+    }
+
+    bool intersects(const FreeRectangle& other) const {
+        return other.left < left + width && left < other.left + other.width &&
+               other.top < top + height && top < other.top + other.height;
+    }
+};
+
+} // anonymous namespace
+
+static bool packMaxRects(std::vector<PackingRectangle>& rectangles, const std::vector<uint32_t>& order, uint64_t size, uint32_t padding,
+                         PackingAlgorithm algorithm) {
+    std::vector<FreeRectangle> freeRectangles = {{0, 0, size, size}};
+
+    for (uint32_t index : order) {
+        PackingRectangle& rect = rectangles[index];
+        uint64_t width = rect.width + padding;
+        uint64_t height = rect.height + padding;
+
+        // smallest score wins, ties are won by the free rectangle found first
+        size_t best = freeRectangles.size();
+        std::pair<uint64_t, uint64_t> bestScore;
+        for (size_t i = 0; i < freeRectangles.size(); i++) {
+            const FreeRectangle& free = freeRectangles[i];
+            if (free.width < width || free.height < height) {
+                continue;
+            }
+
+            uint64_t shortSide = std::min(free.width - width, free.height - height);
+            uint64_t longSide = std::max(free.width - width, free.height - height);
+            std::pair<uint64_t, uint64_t> score;
+            switch (algorithm) {
+            case PackingAlgorithm::MaxRectsBestLongSideFit:
+                score = {longSide, shortSide};
+                break;
+            case PackingAlgorithm::MaxRectsBestAreaFit:
+                score = {free.width * free.height - width * height, shortSide};
+                break;
+            case PackingAlgorithm::MaxRectsBottomLeft:
+                score = {free.top + height, free.left};
+                break;
+            default:
+                score = {shortSide, longSide};
+                break;
+            }
+            if (best == freeRectangles.size() || score < bestScore) {
+                best = i;
+                bestScore = score;
+            }
+        }
+        if (best == freeRectangles.size()) {
+            return false;
+        }
+
+        FreeRectangle placed = {freeRectangles[best].left, freeRectangles[best].top, width, height};
+        rect.left = placed.left;
+        rect.top = placed.top;
+
+        // split the free rectangles overlapping the placed one into the maximal rectangles around it
+        std::vector<FreeRectangle> kept;
+        std::vector<FreeRectangle> created;
+        for (const FreeRectangle& free : freeRectangles) {
+            if (!free.intersects(placed)) {
+                kept.push_back(free);
+                continue;
+            }
+            if (placed.left > free.left) {
+                created.push_back({free.left, free.top, placed.left - free.left, free.height});
+            }
+            if (placed.left + placed.width < free.left + free.width) {
+                created.push_back({placed.left + placed.width, free.top, free.left + free.width - placed.left - placed.width, free.height});
+            }
+            if (placed.top > free.top) {
+                created.push_back({free.left, free.top, free.width, placed.top - free.top});
+            }
+            if (placed.top + placed.height < free.top + free.height) {
+                created.push_back({free.left, placed.top + placed.height, free.width, free.top + free.height - placed.top - placed.height});
+            }
+        }
+
+        // remove rectangles contained in others, the kept rectangles do not contain each other already
+        std::vector<FreeRectangle> added;
+        for (size_t i = 0; i < created.size(); i++) {
+            bool contained = std::any_of(kept.begin(), kept.end(), [&](const FreeRectangle& other) { return other.contains(created[i]); });
+            for (size_t j = 0; j < created.size() && !contained; j++) {
+                // of two equal rectangles the first one is kept
+                contained = j != i && created[j].contains(created[i]) && (j < i || !created[i].contains(created[j]));
+            }
+            if (!contained) {
+                added.push_back(created[i]);
+            }
+        }
+        freeRectangles.clear();
+        for (const FreeRectangle& free : kept) {
+            if (std::none_of(added.begin(), added.end(), [&](const FreeRectangle& other) { return other.contains(free); })) {
+                freeRectangles.push_back(free);
+            }
+        }
+        freeRectangles.insert(freeRectangles.end(), added.begin(), added.end());
+    }
+    return true;
+}
+
+bool packRectangles(std::vector<PackingRectangle>& rectangles, const std::vector<uint32_t>& order,
+                    uint32_t size, uint32_t padding, PackingAlgorithm algorithm) {
+    Instrumentation::addCount("packing attempts");
+
+    uint64_t paddedSize = static_cast<uint64_t>(size) + padding;
+    switch (algorithm) {
+    case PackingAlgorithm::Shelf:
+        return packShelf(rectangles, order, paddedSize, padding);
+    case PackingAlgorithm::Skyline:
+        return packSkyline(rectangles, order, paddedSize, padding);
+    default:
+        return packMaxRects(rectangles, order, paddedSize, padding, algorithm);
+    }
+}
+
+PackingResult optimizePacking(const std::vector<PackingRectangle>& rectangles, uint32_t padding, uint32_t maximumSize,
+                              bool forcePowerOfTwo, std::chrono::milliseconds timeLimit) {
+    ScopedTimer timer("optimize packing");
+
+    const std::vector<PackingOrder> orders = {PackingOrder::Height, PackingOrder::Width, PackingOrder::Area, PackingOrder::Perimeter};
+    const std::vector<PackingAlgorithm> algorithms = {
+        PackingAlgorithm::Shelf, PackingAlgorithm::Skyline,
+        PackingAlgorithm::MaxRectsBestShortSideFit, PackingAlgorithm::MaxRectsBestLongSideFit,
+        PackingAlgorithm::MaxRectsBestAreaFit, PackingAlgorithm::MaxRectsBottomLeft};
+
+    std::vector<std::vector<uint32_t>> orderIndices;
+    for (PackingOrder order : orders) {
+        orderIndices.push_back(getPackingOrder(rectangles, order));
+    }
+
+    // no packing is smaller than the area of all rectangles or than the largest rectangle
+    uint64_t area = 0;
+    uint32_t minimumSize = 1;
+    for (const PackingRectangle& rect : rectangles) {
+        area += static_cast<uint64_t>(rect.width + padding) * (rect.height + padding);
+        minimumSize = std::max({minimumSize, rect.width, rect.height});
+    }
+    uint64_t areaSize = static_cast<uint64_t>(std::ceil(std::sqrt(static_cast<double>(area))));
+    if (areaSize > padding) {
+        minimumSize = std::max<uint64_t>(minimumSize, areaSize - padding);
+    }
+
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + timeLimit;
+    auto isTimeUp = [&]() {
+        return timeLimit.count() > 0 && std::chrono::steady_clock::now() > deadline;
+    };
+
+    std::vector<PackingResult> results(orders.size() * algorithms.size());
+    parallelFor(results.size(), 0, [&](size_t index) {
+        PackingResult& result = results[index];
+        result.order = orders[index / algorithms.size()];
+        result.algorithm = algorithms[index % algorithms.size()];
+        const std::vector<uint32_t>& order = orderIndices[index / algorithms.size()];
+
+        std::vector<PackingRectangle> packed = rectangles;
+        auto tryPack = [&](uint32_t size) {
+            if (!packRectangles(packed, order, size, padding, result.algorithm)) {
+                return false;
+            }
+            result.size = size;
+            result.rectangles = packed;
+            return true;
+        };
+
+        if (forcePowerOfTwo) {
+            for (uint64_t size = 1; size <= maximumSize && !isTimeUp(); size *= 2) {
+                if (size >= minimumSize && tryPack(size)) {
+                    break;
+                }
+            }
+        } else {
+            uint32_t lower = minimumSize;
+            uint32_t upper = maximumSize;
+            while (lower <= upper && !isTimeUp()) {
+                uint32_t size = lower + (upper - lower) / 2;
+                if (tryPack(size)) {
+                    upper = size - 1;
+                } else {
+                    lower = size + 1;
+                }
+            }
+        }
+    });
+
+    PackingResult best;
+    for (PackingResult& result : results) {
+        if (result.size != 0 && (best.size == 0 || result.size < best.size)) {
+            best = std::move(result);
+        }
+    }
+    timer.setArgument("candidates", results.size());
+    timer.setArgument("size", best.size);
+    return best;
+}
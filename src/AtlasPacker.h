@@ -0,0 +1,85 @@
+/*
+ * AtlasPacker.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef ATLASPACKER_H_
+#define ATLASPACKER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+/*! \brief Rectangle placed into a square image, e.g. the cell of a character */
+struct PackingRectangle {
+    uint32_t width;
+    uint32_t height;
+    int32_t left = 0; //!< position set by packing
+    int32_t top = 0;
+};
+
+/*! \brief Order the rectangles are placed in, all orders put large rectangles first */
+enum class PackingOrder {
+    Height,
+    Width,
+    Area,
+    Perimeter
+};
+
+/*! \brief Packing algorithms, the MaxRects variants differ in the free rectangle chosen for a rectangle */
+enum class PackingAlgorithm {
+    Shelf,                    //!< rows with the height of their highest rectangle
+    Skyline,                  //!< lowest position on the outline of the placed rectangles
+    MaxRectsBestShortSideFit, //!< free rectangle leaving the shortest remaining side
+    MaxRectsBestLongSideFit,  //!< free rectangle leaving the shortest remaining long side
+    MaxRectsBestAreaFit,      //!< smallest free rectangle
+    MaxRectsBottomLeft        //!< free rectangle giving the lowest position
+};
+
+std::string getPackingOrderName(PackingOrder order);
+std::string getPackingAlgorithmName(PackingAlgorithm algorithm);
+
+/*! \brief returns the indices of the rectangles sorted by the order, ties keep their index order */
+std::vector<uint32_t> getPackingOrder(const std::vector<PackingRectangle>& rectangles, PackingOrder order);
+
+/*! \brief places the rectangles in the given order into a square image
+ *
+ *  Sets left and top of all rectangles. Rectangles are separated by the
+ *  padding, there is no padding at the edges of the image.
+ *
+ *  \param order indices of the rectangles in the order they are placed
+ *  \param size width and height of the image
+ *  \return false if the rectangles do not fit into the image
+ */
+bool packRectangles(std::vector<PackingRectangle>& rectangles, const std::vector<uint32_t>& order,
+                    uint32_t size, uint32_t padding, PackingAlgorithm algorithm);
+
+/*! \brief Smallest packing found by optimizePacking() */
+struct PackingResult {
+    uint32_t size = 0; //!< width and height of the image, 0 if no packing was found
+    PackingOrder order = PackingOrder::Height;
+    PackingAlgorithm algorithm = PackingAlgorithm::Shelf;
+    std::vector<PackingRectangle> rectangles; //!< the rectangles with their positions
+};
+
+/*! \brief searches the smallest image over all orders and packing algorithms
+ *
+ *  Every combination of order and algorithm is a candidate. Candidates run
+ *  in parallel on all cores, each searches the smallest size it fits into
+ *  by bisection. The smallest candidate wins, ties are won by the candidate
+ *  coming first in the declaration order of PackingOrder and then
+ *  PackingAlgorithm, so the result does not depend on the number of cores.
+ *
+ *  \param maximumSize largest size to consider, usually the size of a known packing
+ *  \param forcePowerOfTwo only consider sizes which are a power of two
+ *  \param timeLimit time the search may take, 0 for no limit. When it is
+ *         reached every candidate keeps the smallest size found so far, so the
+ *         result may then depend on the speed of the machine
+ */
+PackingResult optimizePacking(const std::vector<PackingRectangle>& rectangles, uint32_t padding, uint32_t maximumSize,
+                              bool forcePowerOfTwo, std::chrono::milliseconds timeLimit);
+
+#endif /* ATLASPACKER_H_ */
@@ -0,0 +1,321 @@
+/*
+ * AtlasReport.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "AtlasReport.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <list>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+#include "TextureFontCreator.h"
+
+namespace { // anonymous namespace
+
+/*! \brief Least recently used cache of tiles, only the keys are stored */
+class TileCache {
+public:
+    TileCache(uint32_t capacity) : m_capacity(capacity) {}
+
+    /*! \brief accesses a tile, returns true if it was in the cache */
+    bool access(uint64_t tile) {
+        auto found = m_positions.find(tile);
+        if (found != m_positions.end()) {
+            m_tiles.splice(m_tiles.begin(), m_tiles, found->second);
+            return true;
+        }
+        if (m_capacity == 0) {
+            return false;
+        }
+        if (m_tiles.size() == m_capacity) {
+            m_positions.erase(m_tiles.back());
+            m_tiles.pop_back();
+        }
+        m_tiles.push_front(tile);
+        m_positions[tile] = m_tiles.begin();
+        return false;
+    }
+
+private:
+    uint32_t m_capacity;
+    std::list<uint64_t> m_tiles; //!< most recently used tile first
+    std::unordered_map<uint64_t, std::list<uint64_t>::iterator> m_positions;
+};
+
+/*! \brief calls function with the column and row of every tile a character overlaps */
+template<typename Function>
+void forEachTile(const TextureFontCharacter& character, uint32_t tileSize, Function function) {
+    uint32_t firstColumn = character.left / tileSize;
+    uint32_t lastColumn = (character.left + character.width - 1) / tileSize;
+    uint32_t firstRow = character.top / tileSize;
+    uint32_t lastRow = (character.top + character.height - 1) / tileSize;
+    for (uint32_t row = firstRow; row <= lastRow; row++) {
+        for (uint32_t column = firstColumn; column <= lastColumn; column++) {
+            function(column, row);
+        }
+    }
+}
+
+/*! \brief key of a character in the lookup table of the layout */
+uint64_t characterKey(uint32_t unicode, uint32_t phase) {
+    return (static_cast<uint64_t>(phase) << 32) | unicode;
+}
+
+/*! \brief creates the report of a texture font, see createAtlasReport()
+ *
+ *  \param report contains the pages with their width and height
+ *  \param border width of the extruded border of the characters
+ */
+void fillAtlasReport(AtlasReport& report, uint32_t border, const std::vector<TextureFontVariant>& variants,
+                     const std::vector<std::u8string>& corpus, const AtlasReportOptions& options) {
+    if (options.tileSize == 0) {
+        throw std::runtime_error("The tile size must not be 0.");
+    }
+    if (options.variant >= variants.size()) {
+        std::stringstream errorText;
+        errorText << "The texture font has no variant " << options.variant << ".";
+        throw std::runtime_error(errorText.str());
+    }
+
+    for (AtlasPageReport& page : report.pages) {
+        page.tileColumns = (page.width + options.tileSize - 1) / options.tileSize;
+        page.tileRows = (page.height + options.tileSize - 1) / options.tileSize;
+        page.tileGlyphs.resize(static_cast<size_t>(page.tileColumns) * page.tileRows);
+    }
+
+    // shelves are found by the top of the cells, the extruded border belongs to the cell
+    std::vector<std::map<uint32_t, AtlasPageReport::Shelf>> shelves(report.pages.size());
+    std::vector<std::map<uint32_t, uint64_t>> cellAreas(report.pages.size());
+    for (const TextureFontVariant& variant : variants) {
+        for (const TextureFontCharacter& character : variant.characters) {
+            if (character.width == 0 || character.height == 0) {
+                continue;
+            }
+            AtlasPageReport& page = report.pages.at(character.page);
+            page.glyphs++;
+            page.glyphArea += static_cast<uint64_t>(character.width) * character.height;
+
+            uint32_t cellTop = character.top - border;
+            uint32_t cellWidth = character.width + 2 * border;
+            uint32_t cellHeight = character.height + 2 * border;
+            AtlasPageReport::Shelf& shelf = shelves[character.page][cellTop];
+            shelf.top = cellTop;
+            shelf.height = std::max(shelf.height, cellHeight);
+            shelf.glyphs++;
+            cellAreas[character.page][cellTop] += static_cast<uint64_t>(cellWidth) * cellHeight;
+
+            forEachTile(character, options.tileSize, [&page](uint32_t column, uint32_t row) {
+                page.tileGlyphs[row * page.tileColumns + column]++;
+            });
+        }
+    }
+
+    for (size_t index = 0; index < report.pages.size(); index++) {
+        AtlasPageReport& page = report.pages[index];
+        uint64_t area = static_cast<uint64_t>(page.width) * page.height;
+        page.fillRatio = (area > 0) ? static_cast<double>(page.glyphArea) / area : 0;
+        for (auto& [top, shelf] : shelves[index]) {
+            uint64_t shelfArea = static_cast<uint64_t>(page.width) * shelf.height;
+            uint64_t cellArea = cellAreas[index][top];
+            shelf.wastedArea = (shelfArea > cellArea) ? shelfArea - cellArea : 0;
+            page.wastedArea += shelf.wastedArea;
+            page.shelves.push_back(shelf);
+        }
+    }
+
+    // lay out the corpus like TextureFontCreator::renderText()
+    const TextureFontVariant& variant = variants[options.variant];
+    uint32_t phases = std::max(1u, variant.subpixelPhases);
+    std::unordered_map<uint64_t, const TextureFontCharacter*> characters;
+    for (const TextureFontCharacter& character : variant.characters) {
+        characters.emplace(characterKey(character.unicode, character.phase), &character);
+    }
+
+    AtlasCacheReport& cache = report.cache;
+    TileCache tileCache(options.cacheTiles);
+    std::set<uint64_t> workingSet;
+    uint64_t lineWorkingSets = 0;
+    for (const std::u8string& line : corpus) {
+        std::set<uint64_t> lineWorkingSet;
+        double pen = 0;
+        for (char32_t unicode : toU32String(line)) {
+            int32_t left = floor(pen);
+            uint32_t phase = (pen - left) * phases;
+
+            auto found = characters.find(characterKey(unicode, phase));
+            if (found == characters.end()) {
+                cache.missingCharacters++;
+                continue;
+            }
+            const TextureFontCharacter& character = *found->second;
+
+            if (character.width > 0 && character.height > 0) {
+                cache.glyphs++;
+                const AtlasPageReport& page = report.pages.at(character.page);
+                forEachTile(character, options.tileSize, [&](uint32_t column, uint32_t row) {
+                    uint64_t tile = (static_cast<uint64_t>(character.page) << 32) | (row * page.tileColumns + column);
+                    cache.tileAccesses++;
+                    if (!tileCache.access(tile)) {
+                        cache.misses++;
+                    }
+                    lineWorkingSet.insert(tile);
+                    workingSet.insert(tile);
+                });
+            }
+
+            if (phases > 1) {
+                pen += character.horiAdvance;
+            } else {
+                pen += ceil(character.horiAdvance);
+            }
+        }
+        cache.lines++;
+        cache.maxLineWorkingSet = std::max<uint32_t>(cache.maxLineWorkingSet, lineWorkingSet.size());
+        lineWorkingSets += lineWorkingSet.size();
+    }
+    cache.workingSet = workingSet.size();
+    cache.hitRatio = (cache.tileAccesses > 0) ? 1.0 - static_cast<double>(cache.misses) / cache.tileAccesses : 0;
+    cache.meanLineWorkingSet = (cache.lines > 0) ? static_cast<double>(lineWorkingSets) / cache.lines : 0;
+}
+
+} // anonymous namespace
+
+AtlasReport createAtlasReport(TextureFontReader& reader, const std::vector<std::u8string>& corpus, const AtlasReportOptions& options) {
+    AtlasReport report;
+    report.pages.resize(reader.hasColorPage() ? 2 : 1);
+    report.pages[0].width = reader.getWidth();
+    report.pages[0].height = reader.getHeight();
+    if (reader.hasColorPage()) {
+        report.pages[1].width = reader.getColorPageWidth();
+        report.pages[1].height = reader.getColorPageHeight();
+    }
+    fillAtlasReport(report, reader.getExtrude(), reader.getVariants(), corpus, options);
+    return report;
+}
+
+AtlasReport createAtlasReport(TextureFontCreator& creator, const std::vector<std::u8string>& corpus, const AtlasReportOptions& options) {
+    AtlasReport report;
+    report.pages.resize(creator.getColorPage() ? 2 : 1);
+    report.pages[0].width = creator.getImage()->getWidth();
+    report.pages[0].height = creator.getImage()->getHeight();
+    if (creator.getColorPage()) {
+        report.pages[1].width = creator.getColorPage()->getWidth();
+        report.pages[1].height = creator.getColorPage()->getHeight();
+    }
+
+    // the characters as a reader of the texture font would see them
+    std::vector<TextureFontVariant> variants(creator.getVariants().size());
+    for (size_t index = 0; index < variants.size(); index++) {
+        variants[index].subpixelPhases = creator.getVariants()[index].subpixelPhases;
+    }
+    for (const ImageOffset& imgOff : creator.getImageCharacters()) {
+        const ImageCharacter& imgChar = *imgOff.imgChar;
+        TextureFontCharacter character;
+        character.unicode = imgChar.unicode;
+        character.bitmapLeft = imgChar.bitmap_left;
+        character.bitmapTop = imgChar.bitmap_top;
+        character.horiAdvance = imgChar.horiAdvance;
+        character.vertAdvance = imgChar.vertAdvance;
+        character.left = imgOff.left;
+        character.top = imgOff.top;
+        character.width = imgChar.width;
+        character.height = imgChar.height;
+        character.face = imgChar.face;
+        character.phase = imgChar.phase;
+        character.page = imgOff.page;
+        variants.at(imgOff.variant).characters.push_back(character);
+    }
+
+    fillAtlasReport(report, creator.getAtlasOptions().extrude, variants, corpus, options);
+    return report;
+}
+
+std::string writeAtlasReport(const AtlasReport& report, const AtlasReportOptions& options) {
+    nlohmann::json json;
+    json["tile_size"] = options.tileSize;
+    json["pages"] = nlohmann::json::array();
+    for (const AtlasPageReport& page : report.pages) {
+        nlohmann::json jsonPage;
+        jsonPage["width"] = page.width;
+        jsonPage["height"] = page.height;
+        jsonPage["glyphs"] = page.glyphs;
+        jsonPage["glyph_area"] = page.glyphArea;
+        jsonPage["fill_ratio"] = page.fillRatio;
+        jsonPage["wasted_area"] = page.wastedArea;
+
+        jsonPage["shelves"] = nlohmann::json::array();
+        for (const AtlasPageReport::Shelf& shelf : page.shelves) {
+            nlohmann::json jsonShelf;
+            jsonShelf["top"] = shelf.top;
+            jsonShelf["height"] = shelf.height;
+            jsonShelf["glyphs"] = shelf.glyphs;
+            jsonShelf["wasted_area"] = shelf.wastedArea;
+            jsonPage["shelves"].push_back(jsonShelf);
+        }
+
+        uint32_t usedTiles = 0;
+        uint32_t maxGlyphs = 0;
+        uint64_t tileGlyphs = 0;
+        for (uint32_t glyphs : page.tileGlyphs) {
+            usedTiles += (glyphs > 0) ? 1 : 0;
+            maxGlyphs = std::max(maxGlyphs, glyphs);
+            tileGlyphs += glyphs;
+        }
+        jsonPage["tiles"]["columns"] = page.tileColumns;
+        jsonPage["tiles"]["rows"] = page.tileRows;
+        jsonPage["tiles"]["used"] = usedTiles;
+        jsonPage["tiles"]["max_glyphs"] = maxGlyphs;
+        jsonPage["tiles"]["mean_glyphs"] = (usedTiles > 0) ? static_cast<double>(tileGlyphs) / usedTiles : 0;
+        jsonPage["tiles"]["glyphs"] = page.tileGlyphs;
+        json["pages"].push_back(jsonPage);
+    }
+
+    const AtlasCacheReport& cache = report.cache;
+    json["cache"]["tiles"] = options.cacheTiles;
+    json["cache"]["variant"] = options.variant;
+    json["cache"]["lines"] = cache.lines;
+    json["cache"]["glyphs"] = cache.glyphs;
+    json["cache"]["missing_characters"] = cache.missingCharacters;
+    json["cache"]["tile_accesses"] = cache.tileAccesses;
+    json["cache"]["misses"] = cache.misses;
+    json["cache"]["hit_ratio"] = cache.hitRatio;
+    json["cache"]["working_set"] = cache.workingSet;
+    json["cache"]["max_line_working_set"] = cache.maxLineWorkingSet;
+    json["cache"]["mean_line_working_set"] = cache.meanLineWorkingSet;
+    return json.dump(4);
+}
+
+std::vector<std::u8string> readCorpusFile(const std::filesystem::path& path) {
+    std::ifstream fp(path, std::ifstream::in | std::ifstream::binary);
+    if (fp.fail()) {
+        std::stringstream errorText;
+        errorText << "File \"" << path.native() << "\" could not be read.";
+        throw std::runtime_error(errorText.str());
+    }
+
+    std::string content((std::istreambuf_iterator<char>(fp)), std::istreambuf_iterator<char>());
+    std::vector<std::u8string> corpus;
+    std::u8string line;
+    for (char c : content) {
+        if (c == '\n') {
+            corpus.push_back(line);
+            line.clear();
+        } else if (c != '\r') {
+            line.push_back(static_cast<char8_t>(c));
+        }
+    }
+    if (!line.empty()) {
+        corpus.push_back(line);
+    }
+    return corpus;
+}
@@ -0,0 +1,99 @@
+/*
+ * AtlasReport.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef ATLASREPORT_H_
+#define ATLASREPORT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "TextureFontReader.h"
+#include "TextureFontCreator.h"
+
+/*! \brief Options for analyzing a texture font */
+struct AtlasReportOptions {
+    uint32_t tileSize = 64; //!< width and height of the tiles the images are divided into
+    uint32_t cacheTiles = 16; //!< number of tiles the simulated texture cache holds
+    uint32_t variant = 0; //!< font variant the corpus is laid out with
+};
+
+/*! \brief Quality of a single image of a texture font */
+struct AtlasPageReport {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t glyphs = 0; //!< number of characters with pixels stored in the image
+    uint64_t glyphArea = 0; //!< pixels covered by characters
+    double fillRatio = 0; //!< glyphArea divided by the area of the image
+
+    /*! \brief A row of characters whose cells start at the same top offset */
+    struct Shelf {
+        uint32_t top = 0; //!< top of the cells, including their extruded border
+        uint32_t height = 0; //!< height of the highest cell
+        uint32_t glyphs = 0;
+        uint64_t wastedArea = 0; //!< pixels of the row across the image not covered by cells
+    };
+    std::vector<Shelf> shelves;
+    uint64_t wastedArea = 0; //!< sum of the wasted area of all shelves
+
+    uint32_t tileColumns = 0;
+    uint32_t tileRows = 0;
+    std::vector<uint32_t> tileGlyphs; //!< number of characters overlapping every tile, row by row
+};
+
+/*! \brief Result of laying out a corpus and feeding the touched tiles to a simulated cache */
+struct AtlasCacheReport {
+    uint32_t lines = 0; //!< number of laid out strings
+    uint64_t glyphs = 0; //!< number of laid out characters with pixels
+    uint64_t missingCharacters = 0; //!< characters of the corpus not in the texture font
+    uint64_t tileAccesses = 0; //!< tiles touched by all laid out characters
+    uint64_t misses = 0; //!< tile accesses not served by the simulated cache
+    double hitRatio = 0;
+    uint32_t workingSet = 0; //!< distinct tiles touched by the whole corpus
+    uint32_t maxLineWorkingSet = 0; //!< most distinct tiles touched by a single string
+    double meanLineWorkingSet = 0; //!< mean number of distinct tiles touched by a string
+};
+
+/*! \brief Runtime behaviour of a texture font, see createAtlasReport() */
+struct AtlasReport {
+    std::vector<AtlasPageReport> pages; //!< the image, followed by the color page if there is one
+    AtlasCacheReport cache;
+};
+
+/*! \brief analyzes how a texture font is packed and how it behaves when text is rendered with it
+ *
+ *  For every image the fill ratio, the area wasted by every shelf and the
+ *  number of characters per tile are determined. Shelves are the rows of
+ *  characters starting at the same top offset, which matches the default
+ *  shelf packing; packings found by AtlasOptions::optimizePacking show up
+ *  as many small shelves.
+ *
+ *  Every string of the corpus is laid out like TextureFontCreator::renderText()
+ *  does, and the tiles touched by its characters are fed in order to a
+ *  least recently used cache of options.cacheTiles tiles, which models the
+ *  texture cache of the GPU or a virtual texture streaming the tiles.
+ *
+ *  \param reader the texture font to analyze
+ *  \param corpus the strings to lay out, e.g. the lines of a representative text
+ */
+AtlasReport createAtlasReport(TextureFontReader& reader, const std::vector<std::u8string>& corpus, const AtlasReportOptions& options = AtlasReportOptions());
+
+/*! \brief analyzes a texture font that was just created, see createAtlasReport()
+ *
+ *  The report is the same as for a reader of a file written by the creator,
+ *  but the texture font does not have to be written and parsed first.
+ */
+AtlasReport createAtlasReport(TextureFontCreator& creator, const std::vector<std::u8string>& corpus, const AtlasReportOptions& options = AtlasReportOptions());
+
+/*! \brief returns a report in JSON format, e.g. to compare the quality of texture fonts in a build */
+std::string writeAtlasReport(const AtlasReport& report, const AtlasReportOptions& options = AtlasReportOptions());
+
+/*! \brief reads a UTF-8 encoded file, every line is a string of the corpus */
+std::vector<std::u8string> readCorpusFile(const std::filesystem::path& path);
+
+#endif /* ATLASREPORT_H_ */
@@ -0,0 +1,424 @@
+/*
+ * AtlasServer.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "AtlasServer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "ContentHash.h"
+#include "Instrumentation.h"
+
+static const size_t MAX_REQUEST_SIZE = 16 * 1024 * 1024;
+
+static const char* getFormatName(TextureFontFormat format) {
+    switch (format) {
+        case TextureFontFormat::Binary: return "ytf";
+        case TextureFontFormat::Simple: return "stf";
+        case TextureFontFormat::Json: return "json";
+    }
+    return "";
+}
+
+static TextureFontFormat parseFormatName(const std::string& name) {
+    for (TextureFontFormat format : {TextureFontFormat::Binary, TextureFontFormat::Simple, TextureFontFormat::Json}) {
+        if (name == getFormatName(format)) {
+            return format;
+        }
+    }
+    std::stringstream errorText;
+    errorText << "Unknown texture font format \"" << name << "\".";
+    throw std::runtime_error(errorText.str());
+}
+
+/*! \brief fills the address of a Unix domain socket */
+static sockaddr_un getSocketAddress(const std::filesystem::path& path) {
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.native().size() >= sizeof(address.sun_path)) {
+        std::stringstream errorText;
+        errorText << "Socket path \"" << path.native() << "\" is too long.";
+        throw std::runtime_error(errorText.str());
+    }
+    strcpy(address.sun_path, path.c_str());
+    return address;
+}
+
+/*! \brief connects to a Unix domain socket, returns -1 on failure */
+static int connectSocket(const std::filesystem::path& path) {
+    sockaddr_un address = getSocketAddress(path);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/*! \brief sends the whole buffer, returns false if the connection was closed */
+static bool sendAll(int fd, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t sent = send(fd, bytes, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        bytes += sent;
+        size -= sent;
+    }
+    return true;
+}
+
+/*! \brief receives data until buffer contains the given number of lines, returns false if the connection was closed before */
+static bool receiveLines(int fd, std::string& buffer, size_t lines) {
+    while (std::count(buffer.begin(), buffer.end(), '\n') < static_cast<ptrdiff_t>(lines)) {
+        if (buffer.size() > MAX_REQUEST_SIZE) {
+            return false;
+        }
+        char chunk[4096];
+        ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        buffer.append(chunk, received);
+    }
+    return true;
+}
+
+AtlasServer::AtlasServer(const std::filesystem::path& socketPath, uint32_t workers, size_t cacheSize) :
+    m_socketPath(socketPath),
+    m_stopping(false),
+    m_cacheCapacity(cacheSize),
+    m_cacheSize(0)
+{
+    sockaddr_un address = getSocketAddress(socketPath);
+
+    // a socket file without a server behind it is left over from a crashed server
+    int existing = connectSocket(socketPath);
+    if (existing >= 0) {
+        close(existing);
+        std::stringstream errorText;
+        errorText << "Another server is already listening on \"" << socketPath.native() << "\".";
+        throw std::runtime_error(errorText.str());
+    }
+    unlink(socketPath.c_str());
+
+    m_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_socket < 0 || bind(m_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(m_socket, 64) != 0) {
+        std::stringstream errorText;
+        errorText << "Could not create socket \"" << socketPath.native() << "\": " << strerror(errno);
+        if (m_socket >= 0) {
+            close(m_socket);
+        }
+        throw std::runtime_error(errorText.str());
+    }
+
+    if (workers == 0) {
+        workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (uint32_t i = 0; i < workers; i++) {
+        m_workers.emplace_back(&AtlasServer::workerLoop, this);
+    }
+}
+
+AtlasServer::~AtlasServer() {
+    stop();
+
+    {
+        std::unique_lock<std::mutex> lock(m_connectionMutex);
+        m_connectionsFinished.wait(lock, [this]() { return m_connections.empty(); });
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_queueChanged.notify_all();
+    }
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+
+    close(m_socket);
+    unlink(m_socketPath.c_str());
+}
+
+void AtlasServer::run() {
+    while (!m_stopping) {
+        int fd = accept4(m_socket, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (m_stopping) {
+                break;
+            }
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            std::stringstream errorText;
+            errorText << "Accepting a connection failed: " << strerror(errno);
+            throw std::runtime_error(errorText.str());
+        }
+
+        // clients sending nothing must not block a connection forever
+        timeval timeout = {60, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        std::lock_guard<std::mutex> lock(m_connectionMutex);
+        m_connections.insert(fd);
+        std::thread([this, fd]() {
+            handleConnection(fd);
+
+            std::lock_guard<std::mutex> lock(m_connectionMutex);
+            m_connections.erase(fd);
+            close(fd);
+            m_connectionsFinished.notify_all();
+        }).detach();
+    }
+}
+
+void AtlasServer::stop() {
+    m_stopping = true;
+    shutdown(m_socket, SHUT_RDWR);
+
+    std::lock_guard<std::mutex> lock(m_connectionMutex);
+    for (int fd : m_connections) {
+        shutdown(fd, SHUT_RDWR);
+    }
+}
+
+void AtlasServer::handleConnection(int fd) {
+    ScopedTimer timer("serve request");
+
+    std::string request;
+    if (!receiveLines(fd, request, 2)) {
+        return;
+    }
+
+    std::string response;
+    FileData data;
+    try {
+        size_t firstLineEnd = request.find('\n');
+        size_t secondLineEnd = request.find('\n', firstLineEnd + 1);
+        std::string command = request.substr(0, firstLineEnd);
+        if (command.compare(0, 6, "BUILD ") != 0) {
+            throw std::runtime_error("Unknown command.");
+        }
+        TextureFontFormat format = parseFormatName(command.substr(6));
+        AtlasJob job = parseAtlasJob(request.substr(firstLineEnd + 1, secondLineEnd - firstLineEnd - 1));
+
+        data = build(job, format);
+        response = "OK " + std::to_string(data->size()) + "\n";
+    } catch (std::exception& e) {
+        std::string message = e.what();
+        std::replace(message.begin(), message.end(), '\n', ' ');
+        response = "ERROR " + message + "\n";
+    }
+
+    if (sendAll(fd, response.data(), response.size()) && data) {
+        sendAll(fd, data->data(), data->size());
+    }
+}
+
+void AtlasServer::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_queueMutex);
+            m_queueChanged.wait(lock, [this]() { return !m_queue.empty() || m_stopping; });
+            if (m_queue.empty()) {
+                return;
+            }
+            task = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        task();
+    }
+}
+
+uint64_t AtlasServer::getFontHash(const std::filesystem::path& path) {
+    std::filesystem::file_time_type modificationTime = std::filesystem::last_write_time(path);
+    uintmax_t size = std::filesystem::file_size(path);
+    {
+        std::lock_guard<std::mutex> lock(m_cacheMutex);
+        auto it = m_fontHashes.find(path);
+        if (it != m_fontHashes.end() && it->second.modificationTime == modificationTime && it->second.size == size) {
+            return it->second.hash;
+        }
+    }
+
+    FontHash fontHash = {modificationTime, size, hashFile(path)};
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    m_fontHashes[path] = fontHash;
+    return fontHash.hash;
+}
+
+std::string AtlasServer::getCacheKey(const AtlasJob& job, TextureFontFormat format) {
+    ContentHash hash;
+    hash.updateValue(format);
+    hash.updateValue(getFontHash(job.fontpath));
+    hash.updateValue(static_cast<uint64_t>(job.fallbackFontpaths.size()));
+    for (const std::filesystem::path& fallback : job.fallbackFontpaths) {
+        hash.updateValue(getFontHash(fallback));
+    }
+    hash.updateValue(job.faceIndex);
+    std::string instance = job.variation.toString();
+    hash.updateValue(static_cast<uint64_t>(instance.size()));
+    hash.update(instance);
+    hash.updateValue(job.fontSize);
+    hash.updateValue(job.enableAntiAliasing);
+    hash.updateValue(job.enableHinting);
+    hash.updateValue(job.enableLcdRendering);
+    hash.updateValue(job.subpixelPhases);
+    hash.updateValue(job.forcePowerOfTwo);
+    hash.updateValue(job.optimizePacking);
+    hash.updateValue(job.optimizeTimeLimit);
+    hash.updateValue(job.streaming);
+    hash.update(job.chars);
+    return hash.getHexValue();
+}
+
+void AtlasServer::addToCache(const std::string& key, FileData data) {
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    m_pending.erase(key);
+    if (data->size() > m_cacheCapacity || m_cacheIndex.count(key)) {
+        return;
+    }
+
+    m_cache.push_front({key, data});
+    m_cacheIndex[key] = m_cache.begin();
+    m_cacheSize += data->size();
+    while (m_cacheSize > m_cacheCapacity) {
+        m_cacheSize -= m_cache.back().second->size();
+        m_cacheIndex.erase(m_cache.back().first);
+        m_cache.pop_back();
+    }
+}
+
+std::shared_ptr<const std::vector<uint8_t>> AtlasServer::build(const AtlasJob& job, TextureFontFormat format) {
+    // the characters are part of the cache key, so the character set file is read first
+    AtlasJob resolvedJob = job;
+    if (!resolvedJob.charsetPath.empty()) {
+        resolvedJob.chars += readCharsetFile(resolvedJob.charsetPath);
+        resolvedJob.charsetPath.clear();
+    }
+    std::string key = getCacheKey(resolvedJob, format);
+
+    std::shared_future<FileData> future;
+    {
+        std::lock_guard<std::mutex> lock(m_cacheMutex);
+        auto cached = m_cacheIndex.find(key);
+        if (cached != m_cacheIndex.end()) {
+            Instrumentation::addCount("cache hits");
+            m_cache.splice(m_cache.begin(), m_cache, cached->second);
+            return cached->second->second;
+        }
+
+        auto pending = m_pending.find(key);
+        if (pending != m_pending.end()) {
+            Instrumentation::addCount("coalesced requests");
+            future = pending->second;
+        } else {
+            auto promise = std::make_shared<std::promise<FileData>>();
+            future = promise->get_future().share();
+            m_pending[key] = future;
+
+            std::lock_guard<std::mutex> queueLock(m_queueMutex);
+            m_queue.push_back([this, resolvedJob, format, key, promise]() {
+                try {
+                    std::shared_ptr<TextureFontCreator> creator = createTextureFont(resolvedJob);
+                    std::ostringstream stream;
+                    switch (format) {
+                        case TextureFontFormat::Binary: creator->writeToFile(stream); break;
+                        case TextureFontFormat::Simple: creator->writeToSimpleFile(stream); break;
+                        case TextureFontFormat::Json: creator->writeToJsonFile(stream); break;
+                    }
+                    std::string content = stream.str();
+                    FileData data(new std::vector<uint8_t>(content.begin(), content.end()));
+                    addToCache(key, data);
+                    promise->set_value(data);
+                } catch (...) {
+                    {
+                        std::lock_guard<std::mutex> lock(m_cacheMutex);
+                        m_pending.erase(key);
+                    }
+                    promise->set_exception(std::current_exception());
+                }
+            });
+            m_queueChanged.notify_one();
+        }
+    }
+    return future.get();
+}
+
+std::vector<uint8_t> requestTextureFont(const std::filesystem::path& socketPath, const AtlasJob& job, TextureFontFormat format) {
+    // the server may run in another directory
+    AtlasJob absoluteJob = job;
+    absoluteJob.fontpath = std::filesystem::absolute(job.fontpath);
+    for (std::filesystem::path& fallback : absoluteJob.fallbackFontpaths) {
+        fallback = std::filesystem::absolute(fallback);
+    }
+    if (!job.charsetPath.empty()) {
+        absoluteJob.charsetPath = std::filesystem::absolute(job.charsetPath);
+    }
+    absoluteJob.output.clear();
+
+    int fd = connectSocket(socketPath);
+    if (fd < 0) {
+        std::stringstream errorText;
+        errorText << "Could not connect to \"" << socketPath.native() << "\": " << strerror(errno);
+        throw std::runtime_error(errorText.str());
+    }
+
+    std::string request = std::string("BUILD ") + getFormatName(format) + "\n" + writeAtlasJob(absoluteJob) + "\n";
+    std::string response;
+    if (!sendAll(fd, request.data(), request.size()) || !receiveLines(fd, response, 1)) {
+        close(fd);
+        throw std::runtime_error("Connection to the server was closed.");
+    }
+
+    size_t headerEnd = response.find('\n');
+    std::string header = response.substr(0, headerEnd);
+    if (header.compare(0, 6, "ERROR ") == 0) {
+        close(fd);
+        throw std::runtime_error(header.substr(6));
+    }
+    if (header.compare(0, 3, "OK ") != 0) {
+        close(fd);
+        throw std::runtime_error("Invalid response from the server.");
+    }
+
+    size_t size = std::stoull(header.substr(3));
+    std::vector<uint8_t> data(response.begin() + headerEnd + 1, response.end());
+    data.reserve(size);
+    while (data.size() < size) {
+        char chunk[65536];
+        ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            close(fd);
+            throw std::runtime_error("Connection to the server was closed.");
+        }
+        data.insert(data.end(), chunk, chunk + received);
+    }
+    close(fd);
+    return data;
+}
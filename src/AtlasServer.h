@@ -0,0 +1,117 @@
+/*
+ * AtlasServer.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef ATLASSERVER_H_
+#define ATLASSERVER_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <filesystem>
+
+#include "AtlasJob.h"
+#include "TextureFontReader.h"
+
+/*! \brief Builds texture fonts for local clients connecting to a Unix domain socket
+ *
+ *  Every connection sends a single request and receives the texture font
+ *  file. The protocol consists of text lines:
+ *
+ *      request:  BUILD <format>\n<job>\n
+ *      response: OK <size>\n<size bytes of the file>
+ *                ERROR <message>\n
+ *
+ *  where format is ytf, json or stf and job is a single line of JSON as
+ *  written by writeAtlasJob(), with absolute paths.
+ *
+ *  Texture fonts are built by a pool of worker threads. Finished files are
+ *  kept in a least recently used cache, keyed by the hash of the font files
+ *  and all parameters. Identical requests arriving while a texture font is
+ *  built wait for this build instead of starting another one.
+ */
+class AtlasServer {
+public:
+    /*! \brief Constructor, creates the socket
+     *
+     *  \param socketPath path of the Unix domain socket, a stale socket file is replaced
+     *  \param workers number of worker threads, 0 uses all cores
+     *  \param cacheSize maximum size of all cached files in bytes
+     */
+    AtlasServer(const std::filesystem::path& socketPath, uint32_t workers = 0, size_t cacheSize = 256 * 1024 * 1024);
+    virtual ~AtlasServer();
+
+    AtlasServer(const AtlasServer&) = delete;
+    AtlasServer& operator=(const AtlasServer&) = delete;
+
+    /*! \brief accepts connections until stop() is called */
+    void run();
+
+    /*! \brief makes run() return, open connections are closed */
+    void stop();
+
+    /*! \brief returns the texture font file of a job, from the cache if possible
+     *
+     *  This is what connections use, it can be called from any thread.
+     */
+    std::shared_ptr<const std::vector<uint8_t>> build(const AtlasJob& job, TextureFontFormat format);
+
+private:
+    typedef std::shared_ptr<const std::vector<uint8_t>> FileData;
+
+    /*! \brief hash of a font file, kept as long as the file is not modified */
+    struct FontHash {
+        std::filesystem::file_time_type modificationTime;
+        uintmax_t size;
+        uint64_t hash;
+    };
+
+    void handleConnection(int fd);
+    void workerLoop();
+    uint64_t getFontHash(const std::filesystem::path& path);
+    std::string getCacheKey(const AtlasJob& job, TextureFontFormat format);
+    void addToCache(const std::string& key, FileData data);
+
+    std::filesystem::path m_socketPath;
+    int m_socket;
+    std::atomic<bool> m_stopping;
+
+    std::mutex m_connectionMutex;
+    std::condition_variable m_connectionsFinished;
+    std::set<int> m_connections; //!< sockets of open connections
+
+    std::mutex m_queueMutex;
+    std::condition_variable m_queueChanged;
+    std::deque<std::function<void()>> m_queue;
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_cacheMutex;
+    size_t m_cacheCapacity;
+    size_t m_cacheSize;
+    std::list<std::pair<std::string, FileData>> m_cache; //!< most recently used first
+    std::unordered_map<std::string, std::list<std::pair<std::string, FileData>>::iterator> m_cacheIndex;
+    std::map<std::string, std::shared_future<FileData>> m_pending; //!< builds in progress
+    std::map<std::filesystem::path, FontHash> m_fontHashes;
+};
+
+/*! \brief requests a texture font from an AtlasServer
+ *
+ *  \return the content of the texture font file
+ */
+std::vector<uint8_t> requestTextureFont(const std::filesystem::path& socketPath, const AtlasJob& job, TextureFontFormat format);
+
+#endif /* ATLASSERVER_H_ */
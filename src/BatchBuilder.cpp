@@ -0,0 +1,247 @@
+/*
+ * BatchBuilder.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "BatchBuilder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+
+#include "FontSession.h"
+#include "FreeTypeRender.h"
+#include "Instrumentation.h"
+#include "TaskScheduler.h"
+
+namespace { // anonymous namespace
+
+/*! \brief State of a single job while the batch is built */
+struct JobState {
+    const AtlasJob* job;
+    FontVariant variant;
+    std::vector<char32_t> missingCharacters; //!< characters not found in the glyph cache
+    size_t memory = 0; //!< estimated memory needed to build the texture font
+    size_t reservedMemory = 0; //!< part of the memory budget reserved by the job
+    std::atomic<uint32_t> remainingChunks;
+    std::mutex errorMutex; //!< guards error while the chunks of the job are rendered
+    std::string error;
+
+    /*! \brief keeps the first error of the job */
+    void setError(const std::string& message) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (error.empty()) {
+            error = message;
+        }
+    }
+};
+
+/*! \brief estimates the memory of the character images plus the texture font image in bytes
+ *
+ *  \param streaming the characters are rendered straight into the image, see AtlasOptions::streaming
+ */
+size_t estimateMemory(const FontVariant& variant, size_t characterCount, bool streaming) {
+    double cellSize = variant.fontSize * 1.25 + 2;
+    double channels = variant.enableLcdRendering ? 4 : 1; // grayscale plus RGB image
+    double images = streaming ? 1 : 2;
+    return static_cast<size_t>(images * characterCount * variant.subpixelPhases * cellSize * cellSize * channels);
+}
+
+/*! \brief Font sessions not in use, shared by all jobs using the same fonts */
+class SessionPool {
+public:
+    /*! \brief takes an idle session of the fonts of the variant, loads the fonts if there is none */
+    std::shared_ptr<FontSession> acquire(const FontVariant& variant) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::vector<std::shared_ptr<FontSession>>& idle = m_idle[getKey(variant)];
+            if (!idle.empty()) {
+                std::shared_ptr<FontSession> session = idle.back();
+                idle.pop_back();
+                Instrumentation::addCount("font sessions reused");
+                return session;
+            }
+        }
+
+        // other tasks keep running while the fonts are loaded
+        std::vector<std::filesystem::path> fontpaths = {variant.fontpath};
+        fontpaths.insert(fontpaths.end(), variant.fallbackFontpaths.begin(), variant.fallbackFontpaths.end());
+        return std::make_shared<FontSession>(fontpaths, variant.faceIndex);
+    }
+
+    /*! \brief returns a session taken by acquire(), it must not be used afterwards */
+    void release(const FontVariant& variant, std::shared_ptr<FontSession> session) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_idle[getKey(variant)].push_back(session);
+    }
+
+private:
+    static std::string getKey(const FontVariant& variant) {
+        std::string key = std::to_string(variant.faceIndex) + "\n" + variant.fontpath.string();
+        for (const std::filesystem::path& fallback : variant.fallbackFontpaths) {
+            key += "\n" + fallback.string();
+        }
+        return key;
+    }
+
+    std::mutex m_mutex;
+    std::map<std::string, std::vector<std::shared_ptr<FontSession>>> m_idle; //!< idle sessions by fonts
+};
+
+/*! \brief renders characters of a job into its glyph cache using a session of the pool */
+void renderChunk(JobState& state, SessionPool& sessions, size_t begin, size_t end) {
+    ScopedTimer timer("render chunk");
+    timer.setArgument("characters", end - begin);
+
+    const FontVariant& variant = state.variant;
+    std::vector<std::shared_ptr<ImageCharacter>> characters;
+    std::shared_ptr<FontSession> session;
+    try {
+        session = sessions.acquire(variant);
+        FreeTypeRender renderer(session, variant.fontSize, variant.enableAntiAliasing, variant.enableHinting, variant.enableLcdRendering,
+                                variant.variation);
+        for (size_t index = begin; index < end; index++) {
+            for (uint32_t phase = 0; phase < variant.subpixelPhases; phase++) {
+                characters.push_back(renderer.renderUnicodeCharacter(state.missingCharacters[index], phase, variant.subpixelPhases));
+            }
+        }
+    } catch (std::exception& e) {
+        // the texture font of the job is not built, the characters rendered so far are kept in the cache
+        state.setError(e.what());
+    }
+    if (session) {
+        sessions.release(variant, session);
+    }
+    variant.glyphCache->insert(variant, characters);
+}
+
+} // anonymous namespace
+
+std::vector<std::string> buildBatch(const std::vector<AtlasJob>& jobs, const BatchOptions& options,
+                                    const std::vector<bool>& selected,
+                                    const std::vector<std::shared_ptr<GlyphCache>>& glyphCaches) {
+    std::vector<std::unique_ptr<JobState>> states;
+    for (size_t index = 0; index < jobs.size(); index++) {
+        states.push_back(std::make_unique<JobState>());
+        JobState& state = *states.back();
+        state.job = &jobs[index];
+        state.remainingChunks = 0;
+        if (!selected.empty() && !selected[index]) {
+            continue;
+        }
+
+        try {
+            state.variant = getFontVariant(jobs[index]);
+            state.variant.glyphCache = glyphCaches.empty() ? std::make_shared<GlyphCache>() : glyphCaches[index];
+
+            std::u32string str = toU32String(state.variant.chars);
+            std::set<char32_t> characterSet(str.begin(), str.end());
+            for (char32_t unicode : characterSet) {
+                // streamed texture fonts render their characters themselves, one at a time
+                if (jobs[index].streaming) {
+                    break;
+                }
+                for (uint32_t phase = 0; phase < state.variant.subpixelPhases; phase++) {
+                    if (!state.variant.glyphCache->find(state.variant, unicode, phase)) {
+                        state.missingCharacters.push_back(unicode);
+                        break;
+                    }
+                }
+            }
+            state.memory = estimateMemory(state.variant, characterSet.size(), jobs[index].streaming);
+            if (options.memoryBudget > 0) {
+                state.reservedMemory = std::min(state.memory, options.memoryBudget);
+            }
+        } catch (std::exception& e) {
+            state.error = e.what();
+            state.variant.glyphCache = nullptr;
+        }
+    }
+
+    // expensive jobs first, so their chunks keep all threads busy while the small jobs fill the gaps
+    std::vector<size_t> queued;
+    for (size_t index = 0; index < jobs.size(); index++) {
+        if (states[index]->variant.glyphCache) {
+            queued.push_back(index); // selected and not failed
+        }
+    }
+    std::stable_sort(queued.begin(), queued.end(), [&states](size_t a, size_t b) {
+        return states[a]->memory > states[b]->memory;
+    });
+
+    std::mutex memoryMutex;
+    std::condition_variable memoryReleased;
+    size_t usedMemory = 0;
+
+    SessionPool sessions;
+    TaskScheduler scheduler(options.threads);
+    uint32_t chunkSize = std::max(1u, options.chunkSize);
+
+    while (!queued.empty()) {
+        // start the most expensive job fitting into the remaining memory budget, jobs exceeding it run alone
+        auto next = queued.begin();
+        if (options.memoryBudget > 0) {
+            std::unique_lock<std::mutex> lock(memoryMutex);
+            memoryReleased.wait(lock, [&]() {
+                next = std::find_if(queued.begin(), queued.end(), [&](size_t index) {
+                    return usedMemory == 0 || usedMemory + states[index]->reservedMemory <= options.memoryBudget;
+                });
+                return next != queued.end();
+            });
+            usedMemory += states[*next]->reservedMemory;
+        }
+        JobState& state = *states[*next];
+        queued.erase(next);
+
+        auto assemble = [&state, &sessions, &glyphCaches, &memoryMutex, &memoryReleased, &usedMemory]() {
+            // all chunks are finished, the error of a failed chunk is reported instead of building
+            if (state.error.empty()) {
+                try {
+                    // characters missing in the glyph cache are rendered from a session of the pool
+                    FontVariant variant = state.variant;
+                    variant.session = sessions.acquire(variant);
+                    TextureFontCreator creator({variant}, state.job->forcePowerOfTwo, getAtlasOptions(*state.job));
+                    sessions.release(variant, variant.session);
+                    writeTextureFont(creator, state.job->output);
+                } catch (std::exception& e) {
+                    state.error = e.what();
+                }
+            }
+            if (glyphCaches.empty()) {
+                state.variant.glyphCache = nullptr;
+            }
+
+            std::lock_guard<std::mutex> lock(memoryMutex);
+            usedMemory -= state.reservedMemory;
+            memoryReleased.notify_all();
+        };
+
+        size_t characterCount = state.missingCharacters.size();
+        state.remainingChunks = (characterCount + chunkSize - 1) / chunkSize;
+        if (state.remainingChunks == 0) {
+            scheduler.submit(assemble);
+            continue;
+        }
+        for (size_t begin = 0; begin < characterCount; begin += chunkSize) {
+            size_t end = std::min(characterCount, begin + chunkSize);
+            scheduler.submit([&state, &sessions, &scheduler, assemble, begin, end]() {
+                renderChunk(state, sessions, begin, end);
+                // the last finished chunk packs the texture font
+                if (--state.remainingChunks == 0) {
+                    scheduler.submit(assemble);
+                }
+            });
+        }
+    }
+    scheduler.wait();
+
+    std::vector<std::string> errors;
+    for (const std::unique_ptr<JobState>& state : states) {
+        errors.push_back(state->error);
+    }
+    return errors;
+}
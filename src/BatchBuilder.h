@@ -0,0 +1,56 @@
+/*
+ * BatchBuilder.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef BATCHBUILDER_H_
+#define BATCHBUILDER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "AtlasJob.h"
+#include "GlyphCache.h"
+
+/*! \brief Options for building several texture fonts at once */
+struct BatchOptions {
+    uint32_t threads = 0; //!< number of threads, 0 uses all cores
+
+    /*! \brief estimated memory all texture fonts built at the same time may use, 0 for no limit
+     *
+     *  Texture fonts estimated to need more than the budget are built alone.
+     *  A texture font not fitting into the remaining budget does not hold
+     *  back cheaper ones that fit.
+     */
+    size_t memoryBudget = 0;
+
+    uint32_t chunkSize = 128; //!< number of characters rendered by a single task
+};
+
+/*! \brief Builds and writes the texture fonts of several jobs in parallel
+ *
+ *  The rendering of every texture font is split into chunks of characters,
+ *  so large texture fonts use all cores. Loaded fonts are kept in a pool
+ *  of FontSession objects shared by all jobs using the same fonts, e.g.
+ *  the instances of a variable font. A session is used by one task at a
+ *  time, so every font is loaded at most once per thread. Chunks and the
+ *  packing of finished texture fonts are run by a work stealing
+ *  TaskScheduler, expensive jobs are started first. The written files do
+ *  not depend on the number of threads.
+ *
+ *  \param selected jobs to build, all jobs if empty
+ *  \param glyphCaches caches of the characters of the jobs from the last
+ *         build, one per job, may be empty. Without caches the rendered
+ *         characters are released after a texture font was written
+ *  \return an error message for every job, empty for jobs built successfully,
+ *          a job whose characters cannot be rendered is not written
+ */
+std::vector<std::string> buildBatch(const std::vector<AtlasJob>& jobs, const BatchOptions& options,
+                                    const std::vector<bool>& selected = std::vector<bool>(),
+                                    const std::vector<std::shared_ptr<GlyphCache>>& glyphCaches = std::vector<std::shared_ptr<GlyphCache>>());
+
+#endif /* BATCHBUILDER_H_ */
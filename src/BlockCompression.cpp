@@ -0,0 +1,389 @@
+/*
+ * BlockCompression.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#include "ParallelFor.h"
+#include "Instrumentation.h"
+
+static const size_t BLOCK_SIZE = 8; //!< size of a compressed 4x4 block in bytes
+
+size_t getCompressedSize(uint32_t width, uint32_t height, BlockFormat format) {
+    if (format == BlockFormat::None) {
+        return static_cast<size_t>(width) * height;
+    }
+    return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * BLOCK_SIZE;
+}
+
+/*! \brief reads the pixels of a block in row major order, pixels outside of the image repeat the last column or line */
+static void readBlock(GrayImage& image, uint32_t blockX, uint32_t blockY, uint8_t pixels[16]) {
+    for (uint32_t y = 0; y < 4; y++) {
+        const uint8_t* row = image.getRow(std::min(blockY * 4 + y, image.getHeight() - 1));
+        for (uint32_t x = 0; x < 4; x++) {
+            pixels[y * 4 + x] = row[std::min(blockX * 4 + x, image.getWidth() - 1)];
+        }
+    }
+}
+
+/*! \brief selects the nearest palette entry for every pixel
+ *
+ *  \param indices receives the index of the palette entry for every pixel
+ *  \return the sum of the squared errors
+ */
+static uint32_t fitPalette(const uint8_t pixels[16], const int32_t palette[8], uint8_t indices[16]) {
+    uint32_t error = 0;
+    for (uint32_t pixel = 0; pixel < 16; pixel++) {
+        uint32_t bestError = std::numeric_limits<uint32_t>::max();
+        for (uint8_t index = 0; index < 8; index++) {
+            int32_t difference = pixels[pixel] - palette[index];
+            uint32_t pixelError = difference * difference;
+            if (pixelError < bestError) {
+                bestError = pixelError;
+                indices[pixel] = index;
+            }
+        }
+        error += bestError;
+    }
+    return error;
+}
+
+/*! \brief compresses a block to BC4
+ *
+ *  BC4 has two modes: if the first endpoint is greater than the second, six
+ *  values are interpolated between them. Otherwise four values are
+ *  interpolated and 0 and 255 are available in addition, which suits the
+ *  fully covered and empty pixels of characters. Both modes are tried with
+ *  the minimum and maximum of the block as endpoints.
+ */
+static void encodeBc4Block(const uint8_t pixels[16], uint8_t* output) {
+    uint8_t minimum = *std::min_element(pixels, pixels + 16);
+    uint8_t maximum = *std::max_element(pixels, pixels + 16);
+
+    int32_t palette[8];
+    uint8_t indices[16];
+    uint8_t endpoint0 = maximum;
+    uint8_t endpoint1 = minimum;
+
+    if (minimum == maximum) {
+        memset(indices, 0, sizeof(indices));
+    } else {
+        // eight value mode
+        palette[0] = maximum;
+        palette[1] = minimum;
+        for (int32_t i = 2; i < 8; i++) {
+            palette[i] = ((8 - i) * maximum + (i - 1) * minimum + 3) / 7;
+        }
+        uint32_t error = fitPalette(pixels, palette, indices);
+
+        // six value mode, the endpoints ignore pixels represented by 0 and 255
+        uint8_t innerMinimum = 255;
+        uint8_t innerMaximum = 0;
+        for (uint32_t pixel = 0; pixel < 16; pixel++) {
+            if (pixels[pixel] != 0 && pixels[pixel] != 255) {
+                innerMinimum = std::min(innerMinimum, pixels[pixel]);
+                innerMaximum = std::max(innerMaximum, pixels[pixel]);
+            }
+        }
+        if (innerMinimum > innerMaximum) {
+            innerMinimum = innerMaximum = 0;
+        }
+
+        int32_t sixPalette[8];
+        uint8_t sixIndices[16];
+        sixPalette[0] = innerMinimum;
+        sixPalette[1] = innerMaximum;
+        for (int32_t i = 2; i < 6; i++) {
+            sixPalette[i] = ((6 - i) * innerMinimum + (i - 1) * innerMaximum + 2) / 5;
+        }
+        sixPalette[6] = 0;
+        sixPalette[7] = 255;
+
+        if (fitPalette(pixels, sixPalette, sixIndices) < error) {
+            endpoint0 = innerMinimum;
+            endpoint1 = innerMaximum;
+            memcpy(indices, sixIndices, sizeof(indices));
+        }
+    }
+
+    // 3bit indices in row major order, starting with the least significant bits
+    uint64_t bits = 0;
+    for (uint32_t pixel = 0; pixel < 16; pixel++) {
+        bits |= static_cast<uint64_t>(indices[pixel]) << (3 * pixel);
+    }
+
+    output[0] = endpoint0;
+    output[1] = endpoint1;
+    for (uint32_t i = 0; i < 6; i++) {
+        output[2 + i] = bits >> (8 * i);
+    }
+}
+
+/*! \brief modifier tables of EAC, see the ETC2 specification */
+static const int32_t EAC_MODIFIERS[16][8] = {
+    {-3, -6,  -9, -15, 2, 5, 8, 14},
+    {-3, -7, -10, -13, 2, 6, 9, 12},
+    {-2, -5,  -8, -13, 1, 4, 7, 12},
+    {-2, -4,  -6, -13, 1, 3, 5, 12},
+    {-3, -6,  -8, -12, 2, 5, 7, 11},
+    {-3, -7,  -9, -11, 2, 6, 8, 10},
+    {-4, -7,  -8, -11, 3, 6, 7, 10},
+    {-3, -5,  -8, -11, 2, 4, 7, 10},
+    {-2, -6,  -8, -10, 1, 5, 7,  9},
+    {-2, -5,  -8, -10, 1, 4, 7,  9},
+    {-2, -4,  -8, -10, 1, 3, 7,  9},
+    {-2, -5,  -7, -10, 1, 4, 6,  9},
+    {-3, -4,  -7, -10, 2, 3, 6,  9},
+    {-1, -2,  -3, -10, 0, 1, 2,  9},
+    {-4, -6,  -8,  -9, 3, 5, 7,  8},
+    {-3, -5,  -7,  -9, 2, 4, 6,  8}
+};
+
+/*! \brief parameters of a compressed EAC block */
+struct EacBlock {
+    int32_t base;
+    int32_t multiplier;
+    int32_t table;
+    uint8_t indices[16];
+    uint64_t error;
+};
+
+/*! \brief selects the nearest modifier for every pixel of an EAC block and calculates the error
+ *
+ *  \param targets the pixels as 11bit values in row major order
+ */
+static void fitEacBlock(const int32_t targets[16], EacBlock& block) {
+    int32_t palette[8];
+    for (uint32_t index = 0; index < 8; index++) {
+        palette[index] = std::clamp(block.base * 8 + 4 + EAC_MODIFIERS[block.table][index] * block.multiplier * 8, 0, 2047);
+    }
+
+    block.error = 0;
+    for (uint32_t pixel = 0; pixel < 16; pixel++) {
+        uint32_t bestError = std::numeric_limits<uint32_t>::max();
+        for (uint8_t index = 0; index < 8; index++) {
+            int32_t difference = targets[pixel] - palette[index];
+            uint32_t pixelError = difference * difference;
+            if (pixelError < bestError) {
+                bestError = pixelError;
+                block.indices[pixel] = index;
+            }
+        }
+        block.error += bestError;
+    }
+}
+
+/*! \brief compresses a block to EAC R11
+ *
+ *  For every modifier table the multiplier and base value are estimated
+ *  from the range of the block, the neighbouring values are tried as well
+ *  and the combination with the smallest error is used.
+ */
+static void encodeEacBlock(const uint8_t pixels[16], uint8_t* output) {
+    int32_t targets[16];
+    for (uint32_t pixel = 0; pixel < 16; pixel++) {
+        targets[pixel] = (pixels[pixel] * 2047 + 127) / 255;
+    }
+    int32_t minimum = *std::min_element(targets, targets + 16);
+    int32_t maximum = *std::max_element(targets, targets + 16);
+
+    EacBlock best = {};
+    best.error = std::numeric_limits<uint64_t>::max();
+
+    // uniform blocks are represented by the table containing a zero modifier
+    int32_t firstTable = (minimum == maximum) ? 13 : 0;
+    int32_t lastTable = (minimum == maximum) ? 13 : 15;
+
+    for (int32_t table = firstTable; table <= lastTable; table++) {
+        int32_t low = EAC_MODIFIERS[table][3];
+        int32_t high = EAC_MODIFIERS[table][7];
+
+        double multiplierEstimate = (maximum - minimum) / (8.0 * (high - low));
+        int32_t firstMultiplier = std::clamp<int32_t>(floor(multiplierEstimate), 1, 15);
+        int32_t lastMultiplier = std::clamp<int32_t>(ceil(multiplierEstimate), 1, 15);
+
+        for (int32_t multiplier = firstMultiplier; multiplier <= lastMultiplier; multiplier++) {
+            double baseEstimate = ((minimum + maximum) / 2.0 - 4 - (low + high) / 2.0 * multiplier * 8) / 8;
+            int32_t base = lround(baseEstimate);
+
+            for (int32_t candidate = base - 1; candidate <= base + 1; candidate++) {
+                EacBlock block;
+                block.base = std::clamp(candidate, 0, 255);
+                block.multiplier = multiplier;
+                block.table = table;
+                fitEacBlock(targets, block);
+                if (block.error < best.error) {
+                    best = block;
+                }
+            }
+        }
+    }
+
+    // 64bit big endian: base, multiplier, table, 3bit indices in column major order
+    uint64_t bits = static_cast<uint64_t>(best.base) << 56
+                  | static_cast<uint64_t>(best.multiplier) << 52
+                  | static_cast<uint64_t>(best.table) << 48;
+    for (uint32_t x = 0; x < 4; x++) {
+        for (uint32_t y = 0; y < 4; y++) {
+            uint32_t position = x * 4 + y;
+            bits |= static_cast<uint64_t>(best.indices[y * 4 + x]) << (45 - 3 * position);
+        }
+    }
+
+    for (uint32_t i = 0; i < 8; i++) {
+        output[i] = bits >> (56 - 8 * i);
+    }
+}
+
+std::vector<uint8_t> compressImage(GrayImage& image, BlockFormat format, uint32_t threads) {
+    if (format != BlockFormat::BC4 && format != BlockFormat::EacR11) {
+        throw std::runtime_error("Unsupported block compression format.");
+    }
+
+    ScopedTimer timer("compress blocks");
+
+    uint32_t blocksX = (image.getWidth() + 3) / 4;
+    uint32_t blocksY = (image.getHeight() + 3) / 4;
+    std::vector<uint8_t> result(getCompressedSize(image.getWidth(), image.getHeight(), format));
+
+    parallelFor(blocksY, threads, [&](size_t blockY) {
+        uint8_t pixels[16];
+        for (uint32_t blockX = 0; blockX < blocksX; blockX++) {
+            uint8_t* output = result.data() + (blockY * blocksX + blockX) * BLOCK_SIZE;
+            readBlock(image, blockX, blockY, pixels);
+            if (format == BlockFormat::BC4) {
+                encodeBc4Block(pixels, output);
+            } else {
+                encodeEacBlock(pixels, output);
+            }
+        }
+    });
+
+    return result;
+}
+
+/*! \brief appends a 32bit little endian value to a buffer */
+static void appendLittleEndian(std::vector<uint8_t>& buffer, uint32_t value) {
+    buffer.push_back(value);
+    buffer.push_back(value >> 8);
+    buffer.push_back(value >> 16);
+    buffer.push_back(value >> 24);
+}
+
+/*! \brief writes a buffer to a file */
+static void writeBuffer(const std::filesystem::path& path, const std::vector<uint8_t>& buffer) {
+    std::fstream fp(path, std::fstream::out | std::fstream::binary);
+    if (fp.fail()) {
+        std::stringstream errorText;
+        errorText << "Could not open file \"" << path.native() << "\" for writing. Aborting...";
+        throw std::runtime_error(errorText.str());
+    }
+
+    fp.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+    fp.close();
+    if (fp.fail()) {
+        std::stringstream errorText;
+        errorText << "Could not write file \"" << path.native() << "\". Aborting...";
+        throw std::runtime_error(errorText.str());
+    }
+    Instrumentation::addCount("bytes written", buffer.size());
+}
+
+void writeDdsFile(const std::filesystem::path& path, const std::vector<std::shared_ptr<GrayImage>>& mipChain, uint32_t threads) {
+    if (mipChain.empty()) {
+        throw std::runtime_error("Cannot write a DDS file without images.");
+    }
+
+    uint32_t width = mipChain.front()->getWidth();
+    uint32_t height = mipChain.front()->getHeight();
+    bool hasMipMaps = mipChain.size() > 1;
+
+    std::vector<uint8_t> dds = {'D', 'D', 'S', ' '};
+
+    // DDS_HEADER
+    appendLittleEndian(dds, 124); // size of header
+    appendLittleEndian(dds, 0x1 | 0x2 | 0x4 | 0x1000 | 0x80000 | (hasMipMaps ? 0x20000 : 0)); // caps, height, width, pixel format, linear size, mip map count
+    appendLittleEndian(dds, height);
+    appendLittleEndian(dds, width);
+    appendLittleEndian(dds, getCompressedSize(width, height, BlockFormat::BC4)); // size of the first level
+    appendLittleEndian(dds, 0); // depth
+    appendLittleEndian(dds, mipChain.size());
+    for (uint32_t i = 0; i < 11; i++) {
+        appendLittleEndian(dds, 0); // reserved
+    }
+
+    // DDS_PIXELFORMAT referring to the DX10 header
+    appendLittleEndian(dds, 32); // size of pixel format
+    appendLittleEndian(dds, 0x4); // four character code is valid
+    dds.insert(dds.end(), {'D', 'X', '1', '0'});
+    for (uint32_t i = 0; i < 5; i++) {
+        appendLittleEndian(dds, 0); // bit counts and masks
+    }
+
+    appendLittleEndian(dds, 0x1000 | (hasMipMaps ? (0x8 | 0x400000) : 0)); // texture, complex, mip map
+    for (uint32_t i = 0; i < 4; i++) {
+        appendLittleEndian(dds, 0); // caps2 to caps4 and reserved
+    }
+
+    // DDS_HEADER_DXT10
+    appendLittleEndian(dds, 80); // DXGI_FORMAT_BC4_UNORM
+    appendLittleEndian(dds, 3); // D3D10_RESOURCE_DIMENSION_TEXTURE2D
+    appendLittleEndian(dds, 0); // misc flags
+    appendLittleEndian(dds, 1); // array size
+    appendLittleEndian(dds, 0); // alpha mode unknown
+
+    for (const std::shared_ptr<GrayImage>& level : mipChain) {
+        std::vector<uint8_t> blocks = compressImage(*level, BlockFormat::BC4, threads);
+        dds.insert(dds.end(), blocks.begin(), blocks.end());
+    }
+
+    writeBuffer(path, dds);
+}
+
+void writeKtxFile(const std::filesystem::path& path, const std::vector<std::shared_ptr<GrayImage>>& mipChain, BlockFormat format, uint32_t threads) {
+    if (mipChain.empty()) {
+        throw std::runtime_error("Cannot write a KTX file without images.");
+    }
+
+    uint32_t internalFormat;
+    switch (format) {
+        case BlockFormat::BC4: internalFormat = 0x8DBB; break; // GL_COMPRESSED_RED_RGTC1
+        case BlockFormat::EacR11: internalFormat = 0x9270; break; // GL_COMPRESSED_R11_EAC
+        default:
+            throw std::runtime_error("KTX files can only be written with block compression.");
+    }
+
+    std::vector<uint8_t> ktx = {0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+    appendLittleEndian(ktx, 0x04030201); // endianness
+    appendLittleEndian(ktx, 0); // type, 0 for compressed textures
+    appendLittleEndian(ktx, 1); // type size
+    appendLittleEndian(ktx, 0); // format, 0 for compressed textures
+    appendLittleEndian(ktx, internalFormat);
+    appendLittleEndian(ktx, 0x1903); // base internal format GL_RED
+    appendLittleEndian(ktx, mipChain.front()->getWidth());
+    appendLittleEndian(ktx, mipChain.front()->getHeight());
+    appendLittleEndian(ktx, 0); // depth
+    appendLittleEndian(ktx, 0); // number of array elements
+    appendLittleEndian(ktx, 1); // number of faces
+    appendLittleEndian(ktx, mipChain.size());
+    appendLittleEndian(ktx, 0); // size of key value data
+
+    // compressed blocks are 8 bytes, so no padding is needed between levels
+    for (const std::shared_ptr<GrayImage>& level : mipChain) {
+        std::vector<uint8_t> blocks = compressImage(*level, format, threads);
+        appendLittleEndian(ktx, blocks.size());
+        ktx.insert(ktx.end(), blocks.begin(), blocks.end());
+    }
+
+    writeBuffer(path, ktx);
+}
@@ -0,0 +1,67 @@
+/*
+ * BlockCompression.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef BLOCKCOMPRESSION_H_
+#define BLOCKCOMPRESSION_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <memory>
+#include <vector>
+#include <filesystem>
+
+#include "GrayImage.h"
+
+/*! \brief GPU block compression formats for single channel images
+ *
+ *  Both formats store 4x4 pixels in 8 bytes, i.e. half a byte per pixel.
+ */
+enum class BlockFormat : uint8_t {
+    None = 0,  //!< uncompressed 8bit pixels
+    BC4 = 1,   //!< BC4 unsigned (RGTC1, ATI1), supported by desktop GPUs
+    EacR11 = 2 //!< ETC2 EAC R11 unsigned, supported by OpenGL ES 3 and Vulkan on mobile GPUs
+};
+
+/*! \brief returns the size of an image compressed with the given format in bytes */
+size_t getCompressedSize(uint32_t width, uint32_t height, BlockFormat format);
+
+/*! \brief compresses an image into 4x4 blocks
+ *
+ *  Images whose size is not a multiple of 4 are allowed (e.g. small mip
+ *  maps), the last column and line are repeated to fill the blocks.
+ *  Lines of blocks are compressed in parallel, the result does not depend
+ *  on the number of threads.
+ *
+ *  \param image the image to compress
+ *  \param format BlockFormat::BC4 or BlockFormat::EacR11
+ *  \param threads number of threads to use, 0 uses all cores
+ *  \return the blocks in row major order
+ */
+std::vector<uint8_t> compressImage(GrayImage& image, BlockFormat format, uint32_t threads = 0);
+
+/*! \brief writes a mip chain as BC4 compressed DDS file
+ *
+ *  The file uses the DX10 extension header with DXGI_FORMAT_BC4_UNORM.
+ *
+ *  \param path the file to write
+ *  \param mipChain the images of the mip chain, starting with the full size image
+ *  \param threads number of threads to use, 0 uses all cores
+ */
+void writeDdsFile(const std::filesystem::path& path, const std::vector<std::shared_ptr<GrayImage>>& mipChain, uint32_t threads = 0);
+
+/*! \brief writes a mip chain as compressed KTX file
+ *
+ *  The file uses KTX version 1 with GL_COMPRESSED_RED_RGTC1 for
+ *  BlockFormat::BC4 and GL_COMPRESSED_R11_EAC for BlockFormat::EacR11.
+ *
+ *  \param path the file to write
+ *  \param mipChain the images of the mip chain, starting with the full size image
+ *  \param format BlockFormat::BC4 or BlockFormat::EacR11
+ *  \param threads number of threads to use, 0 uses all cores
+ */
+void writeKtxFile(const std::filesystem::path& path, const std::vector<std::shared_ptr<GrayImage>>& mipChain, BlockFormat format, uint32_t threads = 0);
+
+#endif /* BLOCKCOMPRESSION_H_ */
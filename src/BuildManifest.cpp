@@ -0,0 +1,259 @@
+/*
+ * BuildManifest.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "BuildManifest.h"
+
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+#include <nlohmann/json.hpp>
+
+#include "ContentHash.h"
+#include "TextureFontReader.h"
+
+static uint64_t parseHexValue(const nlohmann::json& json) {
+    return std::stoull(json.get<std::string>(), nullptr, 16);
+}
+
+static std::string toHexValue(uint64_t value) {
+    std::stringstream str;
+    str << std::hex;
+    str.width(16);
+    str.fill('0');
+    str << value;
+    return str.str();
+}
+
+bool BuildManifest::Entry::hasSameInputs(const Entry& other) const {
+    if (fonts.size() != other.fonts.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < fonts.size(); i++) {
+        if (fonts[i].path != other.fonts[i].path || fonts[i].hash != other.fonts[i].hash) {
+            return false;
+        }
+    }
+    return codepointHash == other.codepointHash &&
+           codepointCount == other.codepointCount &&
+           faceIndex == other.faceIndex &&
+           instance == other.instance &&
+           fontSize == other.fontSize &&
+           enableAntiAliasing == other.enableAntiAliasing &&
+           enableHinting == other.enableHinting &&
+           enableLcdRendering == other.enableLcdRendering &&
+           subpixelPhases == other.subpixelPhases &&
+           forcePowerOfTwo == other.forcePowerOfTwo &&
+           optimizePacking == other.optimizePacking &&
+           optimizeTimeLimit == other.optimizeTimeLimit &&
+           streaming == other.streaming;
+}
+
+BuildManifest::BuildManifest(const std::filesystem::path& path) :
+    m_path(std::filesystem::absolute(path))
+{
+    std::ifstream fp(m_path, std::ifstream::in | std::ifstream::binary);
+    if (fp.fail()) {
+        return;
+    }
+
+    try {
+        nlohmann::json json = nlohmann::json::parse(fp);
+        // the version of the tool is not bumped for changes of the output, the revision is
+        if (json.at("generator_revision").get<uint32_t>() != GENERATOR_REVISION ||
+            json.at("format_version").get<uint16_t>() != EXTENDED_FORMAT_VERSION) {
+            return;
+        }
+
+        std::map<std::string, Entry> entries;
+        for (const auto& [output, jsonEntry] : json.at("outputs").items()) {
+            Entry entry;
+            for (const nlohmann::json& jsonFont : jsonEntry.at("fonts")) {
+                FontRecord font;
+                font.path = jsonFont.at("path").get<std::string>();
+                font.size = jsonFont.at("size").get<uintmax_t>();
+                font.modificationTime = jsonFont.at("modification_time").get<int64_t>();
+                font.hash = parseHexValue(jsonFont.at("hash"));
+                entry.fonts.push_back(font);
+            }
+            entry.codepointHash = parseHexValue(jsonEntry.at("codepoints"));
+            entry.codepointCount = jsonEntry.at("codepoint_count").get<size_t>();
+            entry.faceIndex = jsonEntry.at("face_index").get<uint32_t>();
+            entry.instance = jsonEntry.at("instance").get<std::string>();
+            entry.fontSize = jsonEntry.at("size").get<double>();
+            entry.enableAntiAliasing = jsonEntry.at("antialiasing").get<bool>();
+            entry.enableHinting = jsonEntry.at("hinting").get<bool>();
+            entry.enableLcdRendering = jsonEntry.at("lcd").get<bool>();
+            entry.subpixelPhases = jsonEntry.at("subpixel_phases").get<uint32_t>();
+            entry.forcePowerOfTwo = jsonEntry.at("power_of_two").get<bool>();
+            entry.optimizePacking = jsonEntry.at("optimize_packing").get<bool>();
+            entry.optimizeTimeLimit = jsonEntry.at("optimize_time_limit").get<uint32_t>();
+            entry.streaming = jsonEntry.at("streaming").get<bool>();
+            entry.outputHash = parseHexValue(jsonEntry.at("output_hash"));
+            entries[output] = entry;
+        }
+
+        m_entries = entries;
+        for (const auto& [output, entry] : m_entries) {
+            for (const FontRecord& font : entry.fonts) {
+                m_fonts[font.path] = font;
+            }
+        }
+    } catch (std::exception&) {
+        // an invalid manifest is replaced after the build
+    }
+}
+
+std::string BuildManifest::getRelativePath(const std::filesystem::path& path) const {
+    // files outside of the directory of the manifest keep their absolute path
+    std::filesystem::path absolutePath = std::filesystem::absolute(path).lexically_normal();
+    std::filesystem::path relativePath = absolutePath.lexically_relative(m_path.parent_path());
+    if (relativePath.empty() || *relativePath.begin() == "..") {
+        return absolutePath.generic_string();
+    }
+    return relativePath.generic_string();
+}
+
+BuildManifest::FontRecord BuildManifest::getFontRecord(const std::filesystem::path& path) {
+    FontRecord font;
+    font.path = getRelativePath(path);
+    font.size = std::filesystem::file_size(path);
+    font.modificationTime = std::filesystem::last_write_time(path).time_since_epoch().count();
+
+    auto it = m_fonts.find(font.path);
+    if (it != m_fonts.end() && it->second.size == font.size && it->second.modificationTime == font.modificationTime) {
+        return it->second;
+    }
+
+    font.hash = hashFile(path);
+    m_fonts[font.path] = font;
+    return font;
+}
+
+BuildManifest::Entry BuildManifest::getEntry(const AtlasJob& job) {
+    Entry entry;
+    for (const std::filesystem::path& fontpath : job.getInputFiles()) {
+        if (fontpath != job.charsetPath) {
+            entry.fonts.push_back(getFontRecord(fontpath));
+        }
+    }
+
+    // the texture font only depends on the set of characters, not on their order
+    FontVariant variant = getFontVariant(job);
+    std::u32string str = toU32String(variant.chars);
+    std::set<char32_t> codepoints(str.begin(), str.end());
+    ContentHash codepointHash;
+    for (char32_t unicode : codepoints) {
+        codepointHash.updateValue(unicode);
+    }
+    entry.codepointHash = codepointHash.getValue();
+    entry.codepointCount = codepoints.size();
+
+    entry.faceIndex = job.faceIndex;
+    entry.instance = job.variation.toString();
+    entry.fontSize = job.fontSize;
+    entry.enableAntiAliasing = job.enableAntiAliasing;
+    entry.enableHinting = job.enableHinting;
+    entry.enableLcdRendering = job.enableLcdRendering;
+    entry.subpixelPhases = job.subpixelPhases;
+    entry.forcePowerOfTwo = job.forcePowerOfTwo;
+    entry.optimizePacking = job.optimizePacking;
+    entry.optimizeTimeLimit = job.optimizeTimeLimit;
+    entry.streaming = job.streaming;
+    return entry;
+}
+
+bool BuildManifest::isUpToDate(const AtlasJob& job) {
+    std::string output = getRelativePath(job.output);
+    m_pending.erase(output);
+
+    Entry entry;
+    try {
+        entry = getEntry(job);
+    } catch (std::exception&) {
+        return false;
+    }
+    m_pending[output] = entry;
+
+    auto it = m_entries.find(output);
+    if (it == m_entries.end() || !it->second.hasSameInputs(entry)) {
+        return false;
+    }
+
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(job.output, error)) {
+        return false;
+    }
+    return hashFile(job.output) == it->second.outputHash;
+}
+
+void BuildManifest::setBuilt(const AtlasJob& job) {
+    std::string output = getRelativePath(job.output);
+    auto it = m_pending.find(output);
+    if (it == m_pending.end()) {
+        std::stringstream errorText;
+        errorText << "The inputs of \"" << job.output.native() << "\" were not computed before it was built.";
+        throw std::runtime_error(errorText.str());
+    }
+
+    Entry entry = it->second;
+    entry.outputHash = hashFile(job.output);
+    m_entries[output] = entry;
+    m_pending.erase(it);
+}
+
+void BuildManifest::write() {
+    nlohmann::json json;
+    json["version"] = TEXTUREFONT_VERSION;
+    json["generator_revision"] = GENERATOR_REVISION;
+    json["format_version"] = EXTENDED_FORMAT_VERSION;
+    json["outputs"] = nlohmann::json::object();
+    for (const auto& [output, entry] : m_entries) {
+        nlohmann::json jsonEntry;
+        jsonEntry["fonts"] = nlohmann::json::array();
+        for (const FontRecord& font : entry.fonts) {
+            nlohmann::json jsonFont;
+            jsonFont["path"] = font.path;
+            jsonFont["size"] = font.size;
+            jsonFont["modification_time"] = font.modificationTime;
+            jsonFont["hash"] = toHexValue(font.hash);
+            jsonEntry["fonts"].push_back(jsonFont);
+        }
+        jsonEntry["codepoints"] = toHexValue(entry.codepointHash);
+        jsonEntry["codepoint_count"] = entry.codepointCount;
+        jsonEntry["face_index"] = entry.faceIndex;
+        jsonEntry["instance"] = entry.instance;
+        jsonEntry["size"] = entry.fontSize;
+        jsonEntry["antialiasing"] = entry.enableAntiAliasing;
+        jsonEntry["hinting"] = entry.enableHinting;
+        jsonEntry["lcd"] = entry.enableLcdRendering;
+        jsonEntry["subpixel_phases"] = entry.subpixelPhases;
+        jsonEntry["power_of_two"] = entry.forcePowerOfTwo;
+        jsonEntry["optimize_packing"] = entry.optimizePacking;
+        jsonEntry["optimize_time_limit"] = entry.optimizeTimeLimit;
+        jsonEntry["streaming"] = entry.streaming;
+        jsonEntry["output_hash"] = toHexValue(entry.outputHash);
+        json["outputs"][output] = jsonEntry;
+    }
+
+    std::string content = json.dump(4);
+    writeFileAtomically(m_path, [&content](const std::filesystem::path& path) {
+        std::fstream fp(path, std::fstream::out | std::fstream::binary);
+        if (fp.fail()) {
+            std::stringstream errorText;
+            errorText << "Could not open file \"" << path.native() << "\" for writing. Aborting...";
+            throw std::runtime_error(errorText.str());
+        }
+        fp << content << '\n';
+        fp.close();
+        if (fp.fail()) {
+            std::stringstream errorText;
+            errorText << "Could not write file \"" << path.native() << "\". Aborting...";
+            throw std::runtime_error(errorText.str());
+        }
+    });
+}
@@ -0,0 +1,96 @@
+/*
+ * BuildManifest.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef BUILDMANIFEST_H_
+#define BUILDMANIFEST_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "AtlasJob.h"
+
+/*! \brief Records the inputs of built texture fonts, so unchanged texture fonts are not built again
+ *
+ *  For every output the manifest stores the hashes of the font files, the
+ *  hash of the resolved set of code points, all render and packing
+ *  parameters and the hash of the written file. A texture font is up to
+ *  date if all of them match and the output file was not modified. The
+ *  manifest is only used by the same GENERATOR_REVISION and
+ *  EXTENDED_FORMAT_VERSION it was written with.
+ *
+ *  Font hashes are reused while size and modification time of a font stay
+ *  the same, so checking an unchanged font does not read it. Paths are
+ *  stored relative to the directory of the manifest.
+ */
+class BuildManifest {
+public:
+    /*! \brief Constructor, reads the manifest if it exists
+     *
+     *  A manifest which cannot be parsed or was written for another
+     *  GENERATOR_REVISION or format version is ignored, so all texture fonts
+     *  are built again.
+     */
+    BuildManifest(const std::filesystem::path& path);
+
+    /*! \brief computes the inputs of a job and checks if its output was built from the same inputs
+     *
+     *  Jobs whose inputs cannot be read are never up to date, building them
+     *  reports the error.
+     */
+    bool isUpToDate(const AtlasJob& job);
+
+    /*! \brief records the inputs computed by the last call of isUpToDate() for the job, after its output was written */
+    void setBuilt(const AtlasJob& job);
+
+    /*! \brief writes the manifest atomically */
+    void write();
+
+private:
+    /*! \brief font file the texture font was built from */
+    struct FontRecord {
+        std::string path;
+        uintmax_t size = 0;
+        int64_t modificationTime = 0;
+        uint64_t hash = 0;
+    };
+
+    /*! \brief inputs and file of a built texture font */
+    struct Entry {
+        std::vector<FontRecord> fonts;
+        uint64_t codepointHash = 0;
+        size_t codepointCount = 0;
+        uint32_t faceIndex = 0;
+        std::string instance; //!< instance of a variable font, see FontVariation::toString()
+        double fontSize = 0;
+        bool enableAntiAliasing = false;
+        bool enableHinting = false;
+        bool enableLcdRendering = false;
+        uint32_t subpixelPhases = 1;
+        bool forcePowerOfTwo = false;
+        bool optimizePacking = false;
+        uint32_t optimizeTimeLimit = 0;
+        bool streaming = false;
+        uint64_t outputHash = 0;
+
+        /*! \brief compares the inputs, the output hash is not compared */
+        bool hasSameInputs(const Entry& other) const;
+    };
+
+    std::string getRelativePath(const std::filesystem::path& path) const;
+    FontRecord getFontRecord(const std::filesystem::path& path);
+    Entry getEntry(const AtlasJob& job);
+
+    std::filesystem::path m_path;
+    std::map<std::string, Entry> m_entries; //!< entries of built texture fonts by output path
+    std::map<std::string, Entry> m_pending; //!< entries computed by isUpToDate() by output path
+    std::map<std::string, FontRecord> m_fonts; //!< known font hashes by path
+};
+
+#endif /* BUILDMANIFEST_H_ */
@@ -0,0 +1,54 @@
+/*
+ * Codepage.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef CODEPAGE_H_
+#define CODEPAGE_H_
+
+#include <stdint.h>
+
+/*! \brief 8bit code pages supported by the simple texture font format
+ *
+ *  The codes 0x00 to 0x7f are ASCII in all code pages.
+ */
+enum class Codepage {
+    CP437,       //!< IBM PC (DOS) code page with box drawing characters
+    CP850,       //!< DOS Latin-1
+    ISO_8859_1,  //!< Latin-1, western european
+    ISO_8859_2,  //!< Latin-2, central european
+    ISO_8859_5,  //!< Cyrillic
+    ISO_8859_7,  //!< Greek
+    ISO_8859_9,  //!< Latin-5, turkish
+    ISO_8859_15  //!< Latin-9, western european with euro sign
+};
+
+/*! \brief How characters that do not exist in a code page are handled */
+enum class UnmappableCharacters {
+    Skip,       //!< the character is left out
+    Substitute, //!< the character is left out, readers draw the character of a substitute code that has to be stored instead
+    Error       //!< an exception is thrown
+};
+
+/*! \brief returns the name of a code page, e.g. "CP437" */
+const char* getCodepageName(Codepage codepage);
+
+/*! \brief converts a unicode codepoint to the code of a code page
+ *
+ *  The conversion uses tables built at compile time and does not allocate.
+ *
+ *  \param unicode the codepoint to convert
+ *  \param codepage the code page to convert to
+ *  \param code receives the code if the character exists in the code page
+ *  \return false if the character does not exist in the code page
+ */
+bool encodeCodepoint(char32_t unicode, Codepage codepage, uint8_t& code);
+
+/*! \brief converts a code of a code page to a unicode codepoint
+ *
+ *  \return the codepoint, 0 if the code is not defined in the code page
+ */
+char32_t decodeCodepoint(uint8_t code, Codepage codepage);
+
+#endif /* CODEPAGE_H_ */
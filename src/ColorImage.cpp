@@ -0,0 +1,167 @@
+/*
+ * ColorImage.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "ColorImage.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+#include "Instrumentation.h"
+
+ColorImage::ColorImage(uint32_t width, uint32_t height, uint32_t channels, uint8_t fill) {
+    this->width = width;
+    this->rows = height;
+    this->channels = channels;
+    this->pitch = static_cast<size_t>(width) * channels;
+    data.resize(pitch * height, fill);
+    countAllocation();
+}
+
+ColorImage::ColorImage(FT_Bitmap& bitmap) {
+    switch(bitmap.pixel_mode) {
+        case FT_PIXEL_MODE_LCD:
+            // FreeType stores three subpixels per pixel, so the width is given in subpixels
+            this->channels = 3;
+            this->width = bitmap.width / 3;
+            this->rows = bitmap.rows;
+            this->pitch = static_cast<size_t>(width) * channels;
+            data.resize(pitch * rows);
+            for (uint32_t row = 0; row < rows; row++) {
+                memcpy(data.data() + row * pitch, bitmap.buffer + row * bitmap.pitch, pitch);
+            }
+            break;
+
+        case FT_PIXEL_MODE_BGRA:
+            // color glyphs, e.g. emoji, are premultiplied BGRA and stored as RGBA
+            this->channels = 4;
+            this->width = bitmap.width;
+            this->rows = bitmap.rows;
+            this->pitch = static_cast<size_t>(width) * channels;
+            data.resize(pitch * rows);
+            for (uint32_t row = 0; row < rows; row++) {
+                const uint8_t* source = bitmap.buffer + row * bitmap.pitch;
+                uint8_t* line = data.data() + row * pitch;
+                for (uint32_t x = 0; x < width; x++) {
+                    line[4 * x + 0] = source[4 * x + 2];
+                    line[4 * x + 1] = source[4 * x + 1];
+                    line[4 * x + 2] = source[4 * x + 0];
+                    line[4 * x + 3] = source[4 * x + 3];
+                }
+            }
+            break;
+
+        default:
+            // throw exception
+            std::stringstream errorText;
+            errorText << "FreeType delivered invalid pixel mode for color image: " << static_cast<int32_t>(bitmap.pixel_mode);
+            throw std::runtime_error(errorText.str());
+    }
+    countAllocation();
+}
+
+ColorImage::ColorImage(GrayImage& gray, uint32_t channels) {
+    this->width = gray.getWidth();
+    this->rows = gray.getHeight();
+    this->channels = channels;
+    this->pitch = static_cast<size_t>(width) * channels;
+    data.resize(pitch * rows);
+
+    for (uint32_t row = 0; row < rows; row++) {
+        uint8_t* sourceLine = gray.getRow(row);
+        uint8_t* line = getRow(row);
+        for (uint32_t x = 0; x < width; x++) {
+            for (uint32_t channel = 0; channel < channels; channel++) {
+                line[x * channels + channel] = sourceLine[x];
+            }
+        }
+    }
+    countAllocation();
+}
+
+ColorImage::ColorImage(const ColorImage& other) {
+    data = other.data;
+    this->pitch = other.pitch;
+    this->width = other.width;
+    this->rows = other.rows;
+    this->channels = other.channels;
+    countAllocation();
+}
+
+ColorImage::~ColorImage() {
+}
+
+void ColorImage::countAllocation() {
+    Instrumentation::addCount("image allocations");
+    Instrumentation::addCount("image bytes", data.size());
+}
+
+bool ColorImage::blit(ColorImage& source, uint32_t posX, uint32_t posY) {
+    if (source.getChannels() != this->getChannels()) {
+        return false;
+    }
+
+    // check if source image fits in this image
+    if (source.getWidth() + posX > this->getWidth()) {
+        return false;
+    }
+    if (source.getHeight() + posY > this->getHeight()) {
+        return false;
+    }
+
+    // now blit image
+    for (uint32_t row = 0; row < source.getHeight(); row++) {
+        memcpy(this->getRow(row + posY) + posX * channels, source.getRow(row), source.getWidth() * channels);
+    }
+
+    return true;
+}
+
+void ColorImage::flipVertically() {
+    FlipVertically(data.data(), pitch, width * channels, rows);
+}
+
+void ColorImage::extrude(uint32_t posX, uint32_t posY, uint32_t width, uint32_t height, uint32_t border) {
+    ExtrudeEdges(data.data(), pitch, channels, posX, posY, width, height, border);
+}
+
+std::shared_ptr<ColorImage> ColorImage::downsample() {
+    std::shared_ptr<ColorImage> result(new ColorImage(std::max(1u, width / 2), std::max(1u, rows / 2), channels));
+    DownsampleBox(data.data(), pitch, width, rows, channels, result->data.data(), result->pitch);
+    return result;
+}
+
+std::shared_ptr<ColorImage> ColorImage::resample(uint32_t width, uint32_t height) {
+    std::shared_ptr<ColorImage> result(new ColorImage(width, height, channels));
+    ResampleArea(data.data(), pitch, this->width, rows, channels, result->data.data(), result->pitch, width, height);
+    return result;
+}
+
+std::shared_ptr<ColorImage> ColorImage::crop(uint32_t posX, uint32_t posY, uint32_t width, uint32_t height) {
+    std::shared_ptr<ColorImage> result(new ColorImage(width, height, channels));
+    for (uint32_t row = 0; row < height; row++) {
+        memcpy(result->getRow(row), getRow(row + posY) + posX * channels, width * channels);
+    }
+    return result;
+}
+
+std::shared_ptr<GrayImage> ColorImage::getGrayImage() {
+    std::shared_ptr<GrayImage> gray(new GrayImage(width, rows));
+    for (uint32_t row = 0; row < rows; row++) {
+        getGrayPixels(0, row, width, 1, gray->getRow(row), width);
+    }
+    return gray;
+}
+
+void ColorImage::getGrayPixels(uint32_t posX, uint32_t posY, uint32_t width, uint32_t height, uint8_t* destination, size_t destinationPitch) {
+    for (uint32_t row = 0; row < height; row++) {
+        uint8_t* sourceLine = getRow(posY + row) + static_cast<size_t>(posX) * channels;
+        uint8_t* line = destination + row * destinationPitch;
+        for (uint32_t x = 0; x < width; x++) {
+            line[x] = *std::max_element(sourceLine + x * channels, sourceLine + (x + 1) * channels);
+        }
+    }
+}
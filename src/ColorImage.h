@@ -0,0 +1,95 @@
+/*
+ * ColorImage.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef COLORIMAGE_H_
+#define COLORIMAGE_H_
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include "GrayImage.h"
+
+/*! \brief Multi channel image class
+ *
+ *  This class provides means to store and manipulate images with several
+ *  8bit channels per pixel, e.g. RGB images of LCD rendered characters.
+ *  The channels of a pixel are stored interleaved.
+ *  It is possible to construct the image from a FreeType FT_Bitmap using
+ *  the pixel mode FT_PIXEL_MODE_LCD.
+ */
+class ColorImage {
+public:
+    ColorImage(uint32_t width, uint32_t height, uint32_t channels, uint8_t fill = 0);
+    ColorImage(FT_Bitmap& bitmap);
+
+    /*! \brief creates an image with all channels set to the values of a grayscale image */
+    ColorImage(GrayImage& gray, uint32_t channels);
+    ColorImage(const ColorImage& other);
+
+    virtual ~ColorImage();
+
+    /*! \brief blit image to this image
+     *
+     *  Both images need to have the same number of channels.
+     *
+     *  \param source source image
+     *  \param posX upper left corner of blit position
+     *  \param posY upper left corner of blit position
+     *
+     *  \return false if image did not fit, else true
+     */
+    bool blit(ColorImage& source, uint32_t posX, uint32_t posY);
+
+    void flipVertically();
+
+    /*! \brief replicates the edge pixels of a rectangle into its surroundings, see GrayImage::extrude() */
+    void extrude(uint32_t posX, uint32_t posY, uint32_t width, uint32_t height, uint32_t border);
+
+    /*! \brief creates an image of half the width and height using a box filter */
+    std::shared_ptr<ColorImage> downsample();
+
+    /*! \brief creates a scaled copy of the image, see ResampleArea() */
+    std::shared_ptr<ColorImage> resample(uint32_t width, uint32_t height);
+
+    /*! \brief creates an image of a rectangle of this image, see GrayImage::crop() */
+    std::shared_ptr<ColorImage> crop(uint32_t posX, uint32_t posY, uint32_t width, uint32_t height);
+
+    /*! \brief creates a grayscale image using the maximum of all channels */
+    std::shared_ptr<GrayImage> getGrayImage();
+
+    /*! \brief writes the maximum of all channels of a rectangle of this image to a grayscale buffer
+     *
+     *  \param destination upper left pixel of the buffer
+     *  \param destinationPitch offset between two rows of the buffer in bytes
+     */
+    void getGrayPixels(uint32_t posX, uint32_t posY, uint32_t width, uint32_t height, uint8_t* destination, size_t destinationPitch);
+
+    /*! \brief get pointer to given row
+     *
+     *  This method returns a pointer to the beginning of the given row.
+     *  The row contains getWidth() * getChannels() bytes.
+     *
+     *  \param row the row to return a pointer to
+     */
+    uint8_t* getRow(uint32_t row) { return (data.data() + pitch*row); }
+    uint32_t getWidth() { return width; }
+    uint32_t getHeight() { return rows; }
+    uint32_t getChannels() { return channels; }
+
+private:
+    std::vector<uint8_t> data; //!< the imagedata
+    size_t pitch; //!< offset between two rows in bytes
+    uint32_t width; //!< length of row in pixels
+    uint32_t rows; //!< number of rows in image
+    uint32_t channels; //!< number of bytes per pixel
+
+    void countAllocation(); //!< records the allocation of the image data for the instrumentation
+};
+
+#endif /* COLORIMAGE_H_ */
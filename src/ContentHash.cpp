@@ -0,0 +1,115 @@
+/*
+ * ContentHash.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "ContentHash.h"
+
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+static const uint64_t HASH_SEED = 0xcbf29ce484222325ull; // FNV-1a offset basis
+static const uint64_t HASH_PRIME = 0x100000001b3ull; // FNV-1a prime
+
+/*! \brief mixes a word into the state, multiplying twice spreads all bits of the word */
+static inline uint64_t mixWord(uint64_t state, uint64_t word) {
+    word *= 0x9e3779b97f4a7c15ull;
+    word ^= word >> 32;
+    return (state ^ word) * HASH_PRIME;
+}
+
+ContentHash::ContentHash() :
+    m_state(HASH_SEED),
+    m_length(0),
+    m_pendingSize(0)
+{
+}
+
+void ContentHash::update(const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    m_length += size;
+
+    // complete a pending word first
+    while (m_pendingSize > 0 && m_pendingSize < 8 && size > 0) {
+        m_pending[m_pendingSize++] = *bytes++;
+        size--;
+    }
+    if (m_pendingSize == 8) {
+        uint64_t word;
+        memcpy(&word, m_pending, 8);
+        m_state = mixWord(m_state, word);
+        m_pendingSize = 0;
+    }
+
+    for (; size >= 8; bytes += 8, size -= 8) {
+        uint64_t word;
+        memcpy(&word, bytes, 8);
+        m_state = mixWord(m_state, word);
+    }
+
+    memcpy(m_pending + m_pendingSize, bytes, size);
+    m_pendingSize += size;
+}
+
+void ContentHash::update(const std::string& str) {
+    // the length separates consecutive strings, so "ab" + "c" differs from "a" + "bc"
+    updateValue(static_cast<uint64_t>(str.size()));
+    update(str.data(), str.size());
+}
+
+void ContentHash::update(const std::u8string& str) {
+    updateValue(static_cast<uint64_t>(str.size()));
+    update(str.data(), str.size());
+}
+
+uint64_t ContentHash::getValue() const {
+    uint64_t state = m_state;
+    if (m_pendingSize > 0) {
+        uint64_t word = 0;
+        memcpy(&word, m_pending, m_pendingSize);
+        state = mixWord(state, word);
+    }
+    state = mixWord(state, m_length);
+
+    // final avalanche (from splitmix64)
+    state ^= state >> 30;
+    state *= 0xbf58476d1ce4e5b9ull;
+    state ^= state >> 27;
+    state *= 0x94d049bb133111ebull;
+    state ^= state >> 31;
+    return state;
+}
+
+std::string ContentHash::getHexValue() const {
+    std::stringstream hex;
+    hex << std::hex << std::setw(16) << std::setfill('0') << getValue();
+    return hex.str();
+}
+
+uint64_t hashFile(const std::filesystem::path& path) {
+    // read in blocks instead of mapping the file, a mapped file truncated by another process raises SIGBUS
+    std::ifstream fp(path, std::ifstream::in | std::ifstream::binary);
+    if (fp.fail()) {
+        std::stringstream errorText;
+        errorText << "File \"" << path.native() << "\" could not be read.";
+        throw std::runtime_error(errorText.str());
+    }
+
+    ContentHash hash;
+    std::vector<char> buffer(1 << 20);
+    while (fp) {
+        fp.read(buffer.data(), buffer.size());
+        hash.update(buffer.data(), fp.gcount());
+    }
+    if (fp.bad()) {
+        std::stringstream errorText;
+        errorText << "File \"" << path.native() << "\" could not be read.";
+        throw std::runtime_error(errorText.str());
+    }
+    return hash.getValue();
+}
@@ -0,0 +1,52 @@
+/*
+ * ContentHash.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef CONTENTHASH_H_
+#define CONTENTHASH_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <filesystem>
+
+/*! \brief Incremental 64bit hash to identify the content of files and parameters
+ *
+ *  The data is processed in 8 byte words, so hashing large font files is
+ *  limited by memory bandwidth. The hash is not cryptographic, it only
+ *  detects changes. Values are the same on all little endian systems.
+ */
+class ContentHash {
+public:
+    ContentHash();
+
+    void update(const void* data, size_t size);
+    void update(const std::string& str);
+    void update(const std::u8string& str);
+
+    /*! \brief adds a plain old data value */
+    template <typename T>
+    void updateValue(const T& value) { update(&value, sizeof(T)); }
+
+    uint64_t getValue() const;
+
+    /*! \brief returns the value as 16 hex digits */
+    std::string getHexValue() const;
+
+private:
+    uint64_t m_state;
+    uint64_t m_length;
+    uint8_t m_pending[8]; //!< bytes not yet forming a complete word
+    size_t m_pendingSize;
+};
+
+/*! \brief returns the hash of the content of a file
+ *
+ *  The file is read, not memory mapped, so files changed while they are
+ *  hashed cannot crash the process.
+ */
+uint64_t hashFile(const std::filesystem::path& path);
+
+#endif /* CONTENTHASH_H_ */
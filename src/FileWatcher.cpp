@@ -0,0 +1,115 @@
+/*
+ * FileWatcher.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "FileWatcher.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+/*! \brief returns the path in a form that can be compared with the paths of inotify events */
+static std::filesystem::path normalizePath(const std::filesystem::path& path) {
+    return std::filesystem::absolute(path).lexically_normal();
+}
+
+FileWatcher::FileWatcher(const std::vector<std::filesystem::path>& paths) {
+    m_fd = inotify_init1(IN_CLOEXEC);
+    if (m_fd < 0) {
+        std::stringstream errorText;
+        errorText << "Could not initialize inotify: " << strerror(errno);
+        throw std::runtime_error(errorText.str());
+    }
+
+    std::set<std::filesystem::path> directories;
+    for (const std::filesystem::path& path : paths) {
+        std::filesystem::path normalized = normalizePath(path);
+        m_files[normalized].insert(path);
+        directories.insert(normalized.parent_path());
+    }
+
+    for (const std::filesystem::path& directory : directories) {
+        int wd = inotify_add_watch(m_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE);
+        if (wd < 0) {
+            std::stringstream errorText;
+            errorText << "Could not watch directory \"" << directory.native() << "\": " << strerror(errno);
+            close(m_fd);
+            throw std::runtime_error(errorText.str());
+        }
+        m_directories[wd] = directory;
+    }
+}
+
+FileWatcher::~FileWatcher() {
+    close(m_fd);
+}
+
+bool FileWatcher::readEvents(int timeout, std::set<std::filesystem::path>& changed) {
+    pollfd pfd = {m_fd, POLLIN, 0};
+    int result = poll(&pfd, 1, timeout);
+    if (result < 0 && errno != EINTR) {
+        std::stringstream errorText;
+        errorText << "Waiting for file changes failed: " << strerror(errno);
+        throw std::runtime_error(errorText.str());
+    }
+    if (result <= 0) {
+        return false;
+    }
+
+    // events of other files in the watched directories are skipped
+    bool watched = false;
+
+    alignas(inotify_event) char buffer[4096];
+    ssize_t length = read(m_fd, buffer, sizeof(buffer));
+    if (length < 0) {
+        if (errno == EINTR || errno == EAGAIN) {
+            return false;
+        }
+        std::stringstream errorText;
+        errorText << "Reading file changes failed: " << strerror(errno);
+        throw std::runtime_error(errorText.str());
+    }
+
+    for (ssize_t offset = 0; offset < length; ) {
+        const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+        offset += sizeof(inotify_event) + event->len;
+
+        auto directory = m_directories.find(event->wd);
+        if (directory == m_directories.end() || event->len == 0) {
+            continue;
+        }
+        auto file = m_files.find(directory->second / event->name);
+        if (file != m_files.end()) {
+            changed.insert(file->second.begin(), file->second.end());
+            watched = true;
+        }
+    }
+    return watched;
+}
+
+std::set<std::filesystem::path> FileWatcher::waitForChanges(std::chrono::milliseconds debounce) {
+    std::set<std::filesystem::path> changed;
+    while (changed.empty()) {
+        readEvents(-1, changed);
+    }
+
+    // collect the remaining changes of the burst, only changes of the files restart the debounce time
+    auto deadline = std::chrono::steady_clock::now() + debounce;
+    for (;;) {
+        auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0) {
+            break;
+        }
+        if (readEvents(remaining.count(), changed)) {
+            deadline = std::chrono::steady_clock::now() + debounce;
+        }
+    }
+    return changed;
+}
@@ -0,0 +1,54 @@
+/*
+ * FileWatcher.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef FILEWATCHER_H_
+#define FILEWATCHER_H_
+
+#include <chrono>
+#include <map>
+#include <set>
+#include <vector>
+#include <filesystem>
+
+/*! \brief Waits for changes of files using inotify
+ *
+ *  The directories containing the files are watched instead of the files
+ *  themselves, so files replaced by editors (write to a new file, then
+ *  rename it) are still noticed. Only available on Linux.
+ */
+class FileWatcher {
+public:
+    /*! \brief Constructor
+     *
+     *  \param paths the files to watch, they do not need to exist yet
+     */
+    FileWatcher(const std::vector<std::filesystem::path>& paths);
+    virtual ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    /*! \brief blocks until at least one of the files changed
+     *
+     *  Changes arriving in a burst are collected: after a change, the
+     *  method keeps waiting until no further change of the files happened
+     *  for the debounce time. Changes of other files in the watched
+     *  directories do not extend the wait.
+     *
+     *  \return the changed files, as given to the constructor
+     */
+    std::set<std::filesystem::path> waitForChanges(std::chrono::milliseconds debounce);
+
+private:
+    /*! \brief reads all pending events and adds the changed files, returns false if none of the files changed within the timeout */
+    bool readEvents(int timeout, std::set<std::filesystem::path>& changed);
+
+    int m_fd;
+    std::map<int, std::filesystem::path> m_directories; //!< watched directories by watch descriptor
+    std::map<std::filesystem::path, std::set<std::filesystem::path>> m_files; //!< normalized absolute path to the paths given to the constructor
+};
+
+#endif /* FILEWATCHER_H_ */
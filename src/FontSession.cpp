@@ -0,0 +1,307 @@
+/*
+ * FontSession.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "FontSession.h"
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+#include "MappedFile.h"
+#include "Instrumentation.h"
+
+#include FT_LCD_FILTER_H
+#include FT_MULTIPLE_MASTERS_H
+#include FT_SFNT_NAMES_H
+#include FT_TRUETYPE_IDS_H
+
+std::string FontVariation::toString() const {
+    std::stringstream description;
+    description << namedInstance;
+    for (const auto& [tag, value] : axes) {
+        if (description.tellp() > 0) {
+            description << ",";
+        }
+        description << tag << "=" << value;
+    }
+    return description.str();
+}
+
+FontVariation parseFontVariation(const std::string& description) {
+    FontVariation variation;
+    std::stringstream stream(description);
+    std::string entry;
+    while (std::getline(stream, entry, ',')) {
+        size_t separator = entry.find('=');
+        if (separator == std::string::npos) {
+            if (!variation.namedInstance.empty()) {
+                std::stringstream errorText;
+                errorText << "Font instance \"" << description << "\" names more than one named instance.";
+                throw std::runtime_error(errorText.str());
+            }
+            variation.namedInstance = entry;
+            continue;
+        }
+
+        std::string tag = entry.substr(0, separator);
+        std::string value = entry.substr(separator + 1);
+        size_t parsed = 0;
+        double coordinate = 0;
+        try {
+            coordinate = std::stod(value, &parsed);
+        } catch (std::exception&) {
+            parsed = 0;
+        }
+        if (tag.empty() || tag.size() > 4 || parsed == 0 || parsed != value.size()) {
+            std::stringstream errorText;
+            errorText << "Invalid axis \"" << entry << "\" in font instance \"" << description << "\", use TAG=VALUE.";
+            throw std::runtime_error(errorText.str());
+        }
+        variation.axes[tag] = coordinate;
+    }
+    return variation;
+}
+
+/*! \brief returns the four character tag of a variation axis */
+static std::string getAxisTag(FT_ULong tag) {
+    std::string result;
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        result.push_back(static_cast<char>((tag >> shift) & 0xff));
+    }
+    // tags shorter than four characters are padded with spaces
+    return result.substr(0, result.find_last_not_of(' ') + 1);
+}
+
+/*! \brief returns an entry of the name table of a font as UTF-8, empty if it does not exist
+ *
+ *  Unicode names of the Windows platform are preferred, names of the
+ *  Macintosh platform are used as a fallback.
+ */
+static std::string getSfntName(FT_Face face, FT_UInt nameId) {
+    std::string macintoshName;
+    for (FT_UInt index = 0; index < FT_Get_Sfnt_Name_Count(face); index++) {
+        FT_SfntName name;
+        if (FT_Get_Sfnt_Name(face, index, &name) || name.name_id != nameId) {
+            continue;
+        }
+
+        if (name.platform_id == TT_PLATFORM_MICROSOFT && (name.encoding_id == TT_MS_ID_UNICODE_CS || name.encoding_id == TT_MS_ID_UCS_4)) {
+            // UTF-16 big endian, surrogate pairs do not occur in style names
+            std::string result;
+            for (FT_UInt pos = 0; pos + 1 < name.string_len; pos += 2) {
+                uint32_t c = (name.string[pos] << 8) | name.string[pos + 1];
+                if (c < 0x80) {
+                    result.push_back(c);
+                } else if (c < 0x800) {
+                    result.push_back(0xC0 | (c >> 6));
+                    result.push_back(0x80 | (c & 0x3F));
+                } else {
+                    result.push_back(0xE0 | (c >> 12));
+                    result.push_back(0x80 | ((c >> 6) & 0x3F));
+                    result.push_back(0x80 | (c & 0x3F));
+                }
+            }
+            return result;
+        }
+        if (name.platform_id == TT_PLATFORM_MACINTOSH && macintoshName.empty()) {
+            macintoshName.assign(reinterpret_cast<const char*>(name.string), name.string_len);
+        }
+    }
+    return macintoshName;
+}
+
+std::atomic<bool> FontSession::s_copyFiles(false);
+
+void FontSession::setCopyFiles(bool copy) {
+    s_copyFiles.store(copy, std::memory_order_relaxed);
+}
+
+FontSession::FontSession(const std::vector<std::filesystem::path>& fontpaths, uint32_t faceIndex) {
+    if (fontpaths.empty()) {
+        throw std::runtime_error("No font file given.");
+    }
+
+    ScopedTimer timer("load fonts");
+
+    // now init Freetype2
+    int error = FT_Init_FreeType(&m_library);
+
+    if (error) {
+        std::stringstream errorText;
+        errorText << "Could not initialize Freetype2: error #" << error;
+        throw std::runtime_error(errorText.str());
+    }
+
+    // the filter reduces color fringes of LCD rendered characters, it is
+    // not available if FreeType was built without subpixel rendering support
+    FT_Library_SetLcdFilter(m_library, FT_LCD_FILTER_DEFAULT);
+
+    try {
+        // now load font faces
+        for (const std::filesystem::path& fontpath : fontpaths) {
+            m_files.push_back(std::make_unique<MappedFile>(fontpath, s_copyFiles.load(std::memory_order_relaxed)));
+
+            FT_Long index = m_faces.empty() ? faceIndex : 0;
+            FT_Face face;
+            error = FT_New_Memory_Face(m_library, m_files.back()->getData(), m_files.back()->getSize(), index, &face);
+            if (error == FT_Err_Unknown_File_Format) {
+                throw std::runtime_error("Font file is in unsupported format.");
+            } else if (error && index > 0) {
+                std::stringstream errorText;
+                errorText << "Font file \"" << fontpath.native() << "\" contains no face with index " << index << ".";
+                throw std::runtime_error(errorText.str());
+            } else if (error) {
+                throw std::runtime_error("Font file could not be read.");
+            }
+            m_faces.push_back(face);
+        }
+        m_coordinates.resize(m_faces.size());
+    } catch (...) {
+        for (FT_Face face : m_faces) {
+            FT_Done_Face(face);
+        }
+        FT_Done_FreeType(m_library);
+        throw;
+    }
+}
+
+FontSession::~FontSession() {
+    // faces have to be released before the memory they were loaded from
+    for (FT_Face face : m_faces) {
+        FT_Done_Face(face);
+    }
+    FT_Done_FreeType(m_library);
+}
+
+FontSession::ResolvedGlyph FontSession::resolveCharacter(uint32_t character) {
+    auto it = m_resolvedGlyphs.find(character);
+    if (it != m_resolvedGlyphs.end()) {
+        return it->second;
+    }
+
+    ResolvedGlyph resolved = {0, 0};
+    for (uint32_t face = 0; face < m_faces.size(); face++) {
+        FT_UInt glyphIndex = FT_Get_Char_Index(m_faces[face], character);
+        if (glyphIndex != 0) {
+            resolved.face = face;
+            resolved.glyphIndex = glyphIndex;
+            break;
+        }
+    }
+
+    m_resolvedGlyphs[character] = resolved;
+    return resolved;
+}
+
+std::vector<FT_Fixed> FontSession::getDesignCoordinates(const FontVariation& variation) {
+    FT_Face face = m_faces.front();
+    FT_MM_Var* master = nullptr;
+    if (!FT_HAS_MULTIPLE_MASTERS(face) || FT_Get_MM_Var(face, &master)) {
+        if (!variation.isDefault()) {
+            std::stringstream errorText;
+            errorText << "The font " << getFaceName(0) << " is not a variable font, it has no instance \"" << variation.toString() << "\".";
+            throw std::runtime_error(errorText.str());
+        }
+        return std::vector<FT_Fixed>();
+    }
+
+    std::vector<FT_Fixed> coordinates;
+    try {
+        for (FT_UInt axis = 0; axis < master->num_axis; axis++) {
+            coordinates.push_back(master->axis[axis].def);
+        }
+
+        if (!variation.namedInstance.empty()) {
+            FT_UInt instance = 0;
+            while (instance < master->num_namedstyles && getSfntName(face, master->namedstyle[instance].strid) != variation.namedInstance) {
+                instance++;
+            }
+            if (instance == master->num_namedstyles) {
+                std::stringstream errorText;
+                errorText << "The font " << getFaceName(0) << " has no named instance \"" << variation.namedInstance << "\".";
+                throw std::runtime_error(errorText.str());
+            }
+            coordinates.assign(master->namedstyle[instance].coords, master->namedstyle[instance].coords + master->num_axis);
+        }
+
+        for (const auto& [tag, value] : variation.axes) {
+            FT_UInt axis = 0;
+            while (axis < master->num_axis && getAxisTag(master->axis[axis].tag) != tag) {
+                axis++;
+            }
+            if (axis == master->num_axis) {
+                std::stringstream errorText;
+                errorText << "The font " << getFaceName(0) << " has no axis \"" << tag << "\".";
+                throw std::runtime_error(errorText.str());
+            }
+
+            FT_Fixed coordinate = static_cast<FT_Fixed>(std::lround(value * 65536));
+            if (coordinate < master->axis[axis].minimum || coordinate > master->axis[axis].maximum) {
+                std::stringstream errorText;
+                errorText << "The axis \"" << tag << "\" of the font " << getFaceName(0) << " ranges from "
+                          << master->axis[axis].minimum / 65536.0 << " to " << master->axis[axis].maximum / 65536.0 << ".";
+                throw std::runtime_error(errorText.str());
+            }
+            coordinates[axis] = coordinate;
+        }
+    } catch (...) {
+        FT_Done_MM_Var(m_library, master);
+        throw;
+    }
+
+    FT_Done_MM_Var(m_library, master);
+    return coordinates;
+}
+
+std::vector<std::string> FontSession::getNamedInstances() {
+    std::vector<std::string> names;
+    FT_Face face = m_faces.front();
+    FT_MM_Var* master = nullptr;
+    if (!FT_HAS_MULTIPLE_MASTERS(face) || FT_Get_MM_Var(face, &master)) {
+        return names;
+    }
+    for (FT_UInt instance = 0; instance < master->num_namedstyles; instance++) {
+        names.push_back(getSfntName(face, master->namedstyle[instance].strid));
+    }
+    FT_Done_MM_Var(m_library, master);
+    return names;
+}
+
+bool FontSession::setDesignCoordinates(uint32_t face, const std::vector<FT_Fixed>& coordinates) {
+    if (coordinates.empty() || m_coordinates.at(face) == coordinates) {
+        return false;
+    }
+
+    std::vector<FT_Fixed> values = coordinates;
+    int error = FT_Set_Var_Design_Coordinates(m_faces[face], values.size(), values.data());
+    if (error) {
+        std::stringstream errorText;
+        errorText << "Could not set the instance of the font " << getFaceName(face) << ": error #" << error;
+        throw std::runtime_error(errorText.str());
+    }
+    m_coordinates[face] = coordinates;
+    Instrumentation::addCount("font instances switched");
+    return true;
+}
+
+std::string FontSession::getFaceName(uint32_t faceIndex) {
+    FT_Face face = m_faces.at(faceIndex);
+
+    std::string name;
+    if (face->family_name) {
+        name += face->family_name;
+    }
+
+    if (face->style_name) {
+        name += std::string(" ") + face->style_name;
+    }
+
+    if (name.size() == 0) {
+        name = "(none)";
+    }
+
+    return name;
+}
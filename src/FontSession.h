@@ -0,0 +1,140 @@
+/*
+ * FontSession.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef FONTSESSION_H_
+#define FONTSESSION_H_
+
+#include <atomic>
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <filesystem>
+#include <unordered_map>
+
+#include <stdint.h>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+class MappedFile;
+
+/*! \brief Instance of a variable font
+ *
+ *  An instance is given by the name of a named instance of the font (e.g.
+ *  "Bold"), by design coordinates of axes or both. Coordinates of axes
+ *  override the ones of the named instance. Axes not given keep their
+ *  default values.
+ */
+struct FontVariation {
+    std::string namedInstance; //!< style name of a named instance, empty for the default instance
+    std::map<std::string, double> axes; //!< design coordinates by axis tag, e.g. "wght" = 650
+
+    bool isDefault() const { return namedInstance.empty() && axes.empty(); }
+
+    /*! \brief returns the instance in the format read by parseFontVariation(), e.g. "Bold,wdth=80" */
+    std::string toString() const;
+
+    bool operator==(const FontVariation& other) const = default;
+};
+
+/*! \brief parses an instance of a variable font
+ *
+ *  The description is a comma separated list. An entry of the form
+ *  TAG=VALUE sets the design coordinate of an axis, any other entry is the
+ *  name of a named instance, e.g. "Bold", "wght=650" or "Condensed,wght=300".
+ */
+FontVariation parseFontVariation(const std::string& description);
+
+/*! \brief A set of loaded fonts that can be shared by several renderers
+ *
+ *  The font files are memory mapped, see setCopyFiles(), and parsed only
+ *  once. Renderers using the session create their own FT_Size objects, so a single session
+ *  can be used to render the same fonts at many different sizes without
+ *  touching the file system again.
+ *
+ *  FreeType faces must not be used by several threads at the same time.
+ *  Every access to the faces of a session has to hold the lock returned by
+ *  lock().
+ */
+class FontSession {
+public:
+    /*! \brief Constructor
+     *
+     *  \param fontpaths the paths to the TrueType fonts, ordered by priority
+     *  \param faceIndex index of the face of the first font in a font collection (TTC),
+     *         the fallback fonts always use their first face
+     */
+    FontSession(const std::vector<std::filesystem::path>& fontpaths, uint32_t faceIndex = 0);
+    virtual ~FontSession();
+
+    FontSession(const FontSession&) = delete;
+    FontSession& operator=(const FontSession&) = delete;
+
+    /*! \brief read the font files of sessions created afterwards into memory instead of mapping them
+     *
+     *  Used by processes running for a long time like servers, which would
+     *  be killed by SIGBUS if a mapped font was truncated while it is used.
+     */
+    static void setCopyFiles(bool copy);
+
+    std::unique_lock<std::mutex> lock() { return std::unique_lock<std::mutex>(m_mutex); }
+
+    FT_Face getFace(uint32_t face) { return m_faces.at(face); }
+    uint32_t getFaceCount() { return m_faces.size(); }
+    std::string getFaceName(uint32_t face);
+
+    /*! \brief font face and glyph index a codepoint was resolved to */
+    struct ResolvedGlyph {
+        uint32_t face;
+        FT_UInt glyphIndex;
+    };
+
+    /*! \brief find the face to render the given codepoint from
+     *
+     *  The first face that has a glyph for the codepoint in its charmap is
+     *  used. If no face has one, the missing glyph of the first face is
+     *  returned. The result does not depend on the font size and is cached.
+     *  The session lock has to be held when calling this method.
+     */
+    ResolvedGlyph resolveCharacter(uint32_t character);
+
+    /*! \brief returns the design coordinates of an instance of the first font
+     *
+     *  Fonts that are not variable fonts only have the default instance,
+     *  an empty vector is returned for them. Throws if the font has no
+     *  named instance or axis of the given names, or if a coordinate is
+     *  outside of the range of its axis.
+     */
+    std::vector<FT_Fixed> getDesignCoordinates(const FontVariation& variation);
+
+    /*! \brief returns the names of the named instances of the first font */
+    std::vector<std::string> getNamedInstances();
+
+    /*! \brief selects the instance of a variable font face
+     *
+     *  All renderers of a session share its faces, so every renderer sets
+     *  the coordinates of its instance before loading a glyph. The face is
+     *  only changed if its current coordinates differ. The session lock has
+     *  to be held when calling this method.
+     *
+     *  \param coordinates design coordinates, see getDesignCoordinates(), nothing is done if empty
+     *  \return true if the coordinates were changed, the size of the renderer then has to be set again
+     */
+    bool setDesignCoordinates(uint32_t face, const std::vector<FT_Fixed>& coordinates);
+
+private:
+    static std::atomic<bool> s_copyFiles;
+
+    FT_Library m_library;
+    std::vector<std::unique_ptr<MappedFile>> m_files;
+    std::vector<FT_Face> m_faces;
+    std::unordered_map<uint32_t, ResolvedGlyph> m_resolvedGlyphs; //!< cache of already resolved codepoints
+    std::vector<std::vector<FT_Fixed>> m_coordinates; //!< current design coordinates of every face, empty while the face was not varied
+    std::mutex m_mutex;
+};
+
+#endif /* FONTSESSION_H_ */
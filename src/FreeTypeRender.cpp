@@ -9,89 +9,310 @@
 
 #include <cstdlib>
 #include <cstring>
+#include <cmath>
 #include <stdint.h>
 #include <iostream>
 #include <sstream>
 
-FreeTypeRender::FreeTypeRender(const std::filesystem::path& fontpath, double fontSize, bool enableAntiAliasing, bool enableHinting)
-    : m_enableAntiAliasing(enableAntiAliasing), m_enableHinting(enableHinting)
+#include "ContentHash.h"
+#include "Instrumentation.h"
+
+#include FT_SIZES_H
+#include FT_OUTLINE_H
+
+FreeTypeRender::FreeTypeRender(const std::filesystem::path& fontpath, double fontSize, bool enableAntiAliasing, bool enableHinting, bool enableLcdRendering)
+    : FreeTypeRender(std::vector<std::filesystem::path>{fontpath}, fontSize, enableAntiAliasing, enableHinting, enableLcdRendering)
 {
-    // now init Freetype2
-    int error = FT_Init_FreeType(&m_library);
-    
-    if (error) {
-        std::stringstream errorText;
-        errorText << "Could not initialize Freetype2: error #" << error;
-        throw std::runtime_error(errorText.str());
+}
+
+FreeTypeRender::FreeTypeRender(const std::vector<std::filesystem::path>& fontpaths, double fontSize, bool enableAntiAliasing, bool enableHinting, bool enableLcdRendering)
+    : FreeTypeRender(std::make_shared<FontSession>(fontpaths), fontSize, enableAntiAliasing, enableHinting, enableLcdRendering)
+{
+}
+
+FreeTypeRender::FreeTypeRender(std::shared_ptr<FontSession> session, double fontSize, bool enableAntiAliasing, bool enableHinting, bool enableLcdRendering,
+                               const FontVariation& variation)
+    : m_session(session), m_fontSize(fontSize), m_enableAntiAliasing(enableAntiAliasing), m_enableHinting(enableHinting), m_enableLcdRendering(enableLcdRendering)
+{
+    auto lock = m_session->lock();
+
+    m_coordinates = m_session->getDesignCoordinates(variation);
+    m_fontName = m_session->getFaceName(0);
+    if (!variation.isDefault()) {
+        FT_Face face = m_session->getFace(0);
+        m_fontName = std::string(face->family_name ? face->family_name : "(none)") + " " + variation.toString();
+    }
+    m_scales.resize(m_session->getFaceCount(), 1.0);
+
+    // the sizes are set for the outlines of the instance
+    m_session->setDesignCoordinates(0, m_coordinates);
+
+    // every renderer uses its own size objects, so renderers of different
+    // sizes can share the faces of the session
+    for (uint32_t faceIndex = 0; faceIndex < m_session->getFaceCount(); faceIndex++) {
+        FT_Face face = m_session->getFace(faceIndex);
+
+        FT_Size size;
+        int error = FT_New_Size(face, &size);
+        if (!error) {
+            m_sizes.push_back(size);
+            error = FT_Activate_Size(size);
+        }
+        if (!error) {
+            error = setSize(faceIndex);
+        }
+
+        if (error) {
+            for (FT_Size createdSize : m_sizes) {
+                FT_Done_Size(createdSize);
+            }
+            throw std::runtime_error("Could not set font size.");
+        }
     }
+}
 
-    // now load font face
-    error = FT_New_Face(m_library, reinterpret_cast<const char*>(fontpath.u8string().c_str()), 0, &m_face);
-    if (error == FT_Err_Unknown_File_Format) {
-        throw std::runtime_error("Font file is in unsupported format.");
-    } else if (error) {
-        throw std::runtime_error("Font file could not be read.");
+int FreeTypeRender::setSize(uint32_t faceIndex) {
+    FT_Face face = m_session->getFace(faceIndex);
+    if (FT_IS_SCALABLE(face) || !FT_HAS_FIXED_SIZES(face)) {
+        m_scales[faceIndex] = 1.0;
+        return FT_Set_Pixel_Sizes(face,        /* handle to face object */
+                                  0,           /* pixel_width */
+                                  m_fontSize); /* pixel_height */
     }
-    error = FT_Set_Pixel_Sizes(m_face,    /* handle to face object */
-                               0,         /* pixel_width */
-                               fontSize); /* pixel_height */
 
-    if (error) {
-        throw std::runtime_error("Could not set font size.");
+    // bitmap fonts like most emoji fonts only have some strikes,
+    // the smallest one not smaller than the font size is scaled down
+    int strike = 0;
+    for (int i = 0; i < face->num_fixed_sizes; i++) {
+        FT_Pos ppem = face->available_sizes[i].y_ppem;
+        FT_Pos selected = face->available_sizes[strike].y_ppem;
+        bool large = ppem >= m_fontSize * 64;
+        bool selectedLarge = selected >= m_fontSize * 64;
+        if ((large && (!selectedLarge || ppem < selected)) || (!large && !selectedLarge && ppem > selected)) {
+            strike = i;
+        }
+    }
+    int error = FT_Select_Size(face, strike);
+    if (!error) {
+        m_scales[faceIndex] = m_fontSize / (face->available_sizes[strike].y_ppem / 64.0);
     }
+    return error;
 }
 
 FreeTypeRender::~FreeTypeRender() {
-    // free memory
-    FT_Done_FreeType(m_library);
+    auto lock = m_session->lock();
+    for (FT_Size size : m_sizes) {
+        FT_Done_Size(size);
+    }
 }
 
-std::shared_ptr<ImageCharacter> FreeTypeRender::renderUnicodeCharacter(uint32_t character) {
+uint32_t FreeTypeRender::loadCharacter(uint32_t character, uint32_t phase, uint32_t phaseCount, bool render) {
+
+    // shifted glyphs are rendered after moving the outline
+    bool shiftOutline = (phase != 0);
 
-    int flags = FT_LOAD_RENDER;
-    if (m_enableAntiAliasing) {
+    int flags = (shiftOutline || !render) ? FT_LOAD_DEFAULT : FT_LOAD_RENDER;
+    FT_Render_Mode renderMode;
+    if (m_enableLcdRendering) {
+        flags |= FT_LOAD_TARGET_LCD;
+        renderMode = FT_RENDER_MODE_LCD;
+    } else if (m_enableAntiAliasing) {
         flags |= FT_LOAD_TARGET_NORMAL;
+        renderMode = FT_RENDER_MODE_NORMAL;
     } else {
         flags |= FT_LOAD_TARGET_MONO;
+        renderMode = FT_RENDER_MODE_MONO;
     }
 
     if (!m_enableHinting) {
         flags |= FT_LOAD_NO_HINTING;
     }
 
-    int error = FT_Load_Char(m_face, character, flags);
+    // color glyphs are delivered as BGRA bitmaps
+    flags |= FT_LOAD_COLOR;
+
+    FontSession::ResolvedGlyph resolved = m_session->resolveCharacter(character);
+    FT_Face face = m_session->getFace(resolved.face);
+
+    int error = FT_Activate_Size(m_sizes[resolved.face]);
+    if (!error && resolved.face == 0 && m_session->setDesignCoordinates(0, m_coordinates)) {
+        // another renderer of the session used a different instance, the
+        // scaled metrics and hinting data of the size depend on the instance
+        error = setSize(0);
+    }
+    if (!error) {
+        error = FT_Load_Glyph(face, resolved.glyphIndex, flags);
+    }
+    if (!error && shiftOutline) {
+        // glyphs that are not outlines (e.g. embedded bitmaps) cannot be shifted
+        if (face->glyph->format == FT_GLYPH_FORMAT_OUTLINE) {
+            FT_Pos shift = (static_cast<FT_Pos>(phase) * 64) / phaseCount; // 26.6 fixed point
+            FT_Outline_Translate(&face->glyph->outline, shift, 0);
+        }
+        if (render) {
+            error = FT_Render_Glyph(face->glyph, renderMode);
+        }
+    }
     if (error) {
         std::stringstream errorText;
         errorText << "Could not load character: " << character;
         throw std::runtime_error(errorText.str());
     }
+    return resolved.face;
+}
 
-    std::shared_ptr<GrayImage> image(new GrayImage(m_face->glyph->bitmap));
+void FreeTypeRender::setAdvances(ImageCharacter& imgCharacter, uint32_t faceIndex) {
+    FT_Face face = m_session->getFace(faceIndex);
+    if (FT_IS_SCALABLE(face)) {
+        imgCharacter.horiAdvance = face->glyph->linearHoriAdvance / (double)65536;
+        imgCharacter.vertAdvance = face->glyph->linearVertAdvance / (double)65536;
+    } else {
+        // fixed size fonts have no linear advances
+        double scale = m_scales[faceIndex];
+        imgCharacter.horiAdvance = face->glyph->advance.x / 64.0 * scale;
+        imgCharacter.vertAdvance = face->glyph->metrics.vertAdvance / 64.0 * scale;
+    }
+}
+
+std::shared_ptr<ImageCharacter> FreeTypeRender::renderUnicodeCharacter(uint32_t character, uint32_t phase, uint32_t phaseCount) {
+    auto lock = m_session->lock();
+    uint32_t face = loadCharacter(character, phase, phaseCount, true);
+    return createCharacter(face, character, phase);
+}
+
+std::shared_ptr<ImageCharacter> FreeTypeRender::measureUnicodeCharacter(uint32_t character, uint32_t phase, uint32_t phaseCount) {
+    auto lock = m_session->lock();
+    uint32_t faceIndex = loadCharacter(character, phase, phaseCount, false);
+    FT_Face face = m_session->getFace(faceIndex);
+
+    // embedded bitmaps are loaded as images anyway, layered color glyphs
+    // (COLR) are loaded as outlines but rendered into BGRA bitmaps
+    if (face->glyph->format != FT_GLYPH_FORMAT_OUTLINE || FT_HAS_COLOR(face)) {
+        faceIndex = loadCharacter(character, phase, phaseCount, true);
+        return createCharacter(faceIndex, character, phase);
+    }
 
     std::shared_ptr<ImageCharacter> imgCharacter(new ImageCharacter());
-    imgCharacter->image = image;
-    imgCharacter->horiAdvance = m_face->glyph->linearHoriAdvance / (double)65536;
-    imgCharacter->vertAdvance = m_face->glyph->linearVertAdvance / (double)65536;
-    imgCharacter->bitmap_left = m_face->glyph->bitmap_left;
-    imgCharacter->bitmap_top = m_face->glyph->bitmap_top;
+    if (face->glyph->outline.n_points > 0) {
+        FT_BBox box;
+        FT_Outline_Get_CBox(&face->glyph->outline, &box);
+        int32_t left = static_cast<int32_t>(std::floor(box.xMin / 64.0)) - 1;
+        int32_t right = static_cast<int32_t>(std::ceil(box.xMax / 64.0)) + 1;
+        int32_t bottom = static_cast<int32_t>(std::floor(box.yMin / 64.0)) - 1;
+        int32_t top = static_cast<int32_t>(std::ceil(box.yMax / 64.0)) + 1;
+        imgCharacter->width = right - left;
+        imgCharacter->height = top - bottom;
+        imgCharacter->bitmap_left = left;
+        imgCharacter->bitmap_top = top;
+    } else {
+        imgCharacter->bitmap_left = 0;
+        imgCharacter->bitmap_top = 0;
+    }
+    setAdvances(*imgCharacter, faceIndex);
     imgCharacter->unicode = character;
+    imgCharacter->face = faceIndex;
+    imgCharacter->phase = phase;
 
+    Instrumentation::addCount("glyphs measured");
     return imgCharacter;
 }
 
-std::string FreeTypeRender::getFontName() {
-    std::string name;
-    if (m_face->family_name) {
-        name += m_face->family_name;
+uint64_t FreeTypeRender::getCharacterHash(uint32_t character) {
+    auto lock = m_session->lock();
+    uint32_t faceIndex = loadCharacter(character, 0, 1, false);
+    FT_Face face = m_session->getFace(faceIndex);
+
+    ContentHash hash;
+    hash.updateValue(faceIndex);
+    if (face->glyph->format != FT_GLYPH_FORMAT_OUTLINE || FT_HAS_COLOR(face)) {
+        // like measureUnicodeCharacter() these glyphs are rendered anyway
+        loadCharacter(character, 0, 1, true);
+        const FT_Bitmap& bitmap = face->glyph->bitmap;
+        hash.updateValue(bitmap.pixel_mode);
+        hash.updateValue(bitmap.width);
+        hash.updateValue(bitmap.rows);
+        for (uint32_t row = 0; row < bitmap.rows; row++) {
+            hash.update(bitmap.buffer + static_cast<ptrdiff_t>(row) * bitmap.pitch, std::abs(bitmap.pitch));
+        }
+        hash.updateValue(face->glyph->bitmap_left);
+        hash.updateValue(face->glyph->bitmap_top);
+    } else {
+        // the shifted outlines of the sub pixel phases are translated copies of this outline
+        const FT_Outline& outline = face->glyph->outline;
+        hash.updateValue(outline.n_points);
+        hash.update(outline.points, outline.n_points * sizeof(FT_Vector));
+        hash.update(outline.tags, outline.n_points);
+        hash.updateValue(outline.n_contours);
+        hash.update(outline.contours, outline.n_contours * sizeof(outline.contours[0]));
+        hash.updateValue(outline.flags);
+    }
+    hash.updateValue(face->glyph->linearHoriAdvance);
+    hash.updateValue(face->glyph->linearVertAdvance);
+    hash.updateValue(face->glyph->advance.x);
+    hash.updateValue(face->glyph->metrics.vertAdvance);
+    return hash.getValue();
+}
+
+std::shared_ptr<ImageCharacter> FreeTypeRender::createCharacter(uint32_t faceIndex, uint32_t character, uint32_t phase) {
+    FT_Face face = m_session->getFace(faceIndex);
+    std::shared_ptr<ImageCharacter> imgCharacter(new ImageCharacter());
+
+    // glyphs with embedded bitmaps are delivered as grayscale even in LCD mode
+    if (face->glyph->bitmap.pixel_mode == FT_PIXEL_MODE_BGRA) {
+        // the alpha channel is the maximum of the premultiplied channels
+        imgCharacter->rgbaImage = std::shared_ptr<ColorImage>(new ColorImage(face->glyph->bitmap));
+        imgCharacter->image = imgCharacter->rgbaImage->getGrayImage();
+        Instrumentation::addCount("color glyphs rendered");
+    } else if (face->glyph->bitmap.pixel_mode == FT_PIXEL_MODE_LCD) {
+        imgCharacter->colorImage = std::shared_ptr<ColorImage>(new ColorImage(face->glyph->bitmap));
+        imgCharacter->image = imgCharacter->colorImage->getGrayImage();
+    } else {
+        imgCharacter->image = std::shared_ptr<GrayImage>(new GrayImage(face->glyph->bitmap));
     }
 
-    if (m_face->style_name) {
-        name += std::string(" ") + m_face->style_name;
+    imgCharacter->bitmap_left = face->glyph->bitmap_left;
+    imgCharacter->bitmap_top = face->glyph->bitmap_top;
+
+    setAdvances(*imgCharacter, faceIndex);
+
+    double scale = m_scales[faceIndex];
+    if (scale != 1.0) {
+        // the bitmaps of fixed size fonts are scaled to the font size
+        imgCharacter->bitmap_left = static_cast<int32_t>(std::lround(face->glyph->bitmap_left * scale));
+        imgCharacter->bitmap_top = static_cast<int32_t>(std::lround(face->glyph->bitmap_top * scale));
+
+        uint32_t width = static_cast<uint32_t>(std::lround(imgCharacter->image->getWidth() * scale));
+        uint32_t height = static_cast<uint32_t>(std::lround(imgCharacter->image->getHeight() * scale));
+        if (imgCharacter->rgbaImage) {
+            imgCharacter->rgbaImage = imgCharacter->rgbaImage->resample(width, height);
+            imgCharacter->image = imgCharacter->rgbaImage->getGrayImage();
+        } else {
+            imgCharacter->image = imgCharacter->image->resample(width, height);
+        }
     }
 
-    if (name.size() == 0) {
-        name = "(none)";
+    // hinting and the control box of the outline may leave empty rows and
+    // columns, they are removed and the bearings are moved accordingly
+    uint32_t left = 0, top = 0, width = 0, height = 0;
+    imgCharacter->image->getContentBounds(left, top, width, height);
+    if (width != imgCharacter->image->getWidth() || height != imgCharacter->image->getHeight()) {
+        Instrumentation::addCount("pixels trimmed", imgCharacter->image->getWidth() * imgCharacter->image->getHeight() - width * height);
+        imgCharacter->image = imgCharacter->image->crop(left, top, width, height);
+        if (imgCharacter->colorImage) {
+            imgCharacter->colorImage = imgCharacter->colorImage->crop(left, top, width, height);
+        }
+        if (imgCharacter->rgbaImage) {
+            imgCharacter->rgbaImage = imgCharacter->rgbaImage->crop(left, top, width, height);
+        }
+        imgCharacter->bitmap_left += left;
+        imgCharacter->bitmap_top -= top;
     }
+    imgCharacter->width = imgCharacter->image->getWidth();
+    imgCharacter->height = imgCharacter->image->getHeight();
+    imgCharacter->unicode = character;
+    imgCharacter->face = faceIndex;
+    imgCharacter->phase = phase;
 
-    return name;
+    Instrumentation::addCount("glyphs rendered");
+    return imgCharacter;
 }
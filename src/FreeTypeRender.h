@@ -8,15 +8,17 @@
 #ifndef FREETYPERENDER_H_
 #define FREETYPERENDER_H_
 
-#include <QImage>
 #include <string>
 #include <memory>
 #include <filesystem>
+#include <vector>
 
 #include <stdint.h>
 #include <ft2build.h>
 #include FT_FREETYPE_H
 #include "GrayImage.h"
+#include "ColorImage.h"
+#include "FontSession.h"
 
 /*! \brief Information about a single rendered character
  *
@@ -25,12 +27,18 @@
  *  font.
  */
 struct ImageCharacter {
-    std::shared_ptr<GrayImage> image;  //!< Pointer to the image of the character
+    std::shared_ptr<GrayImage> image;  //!< Pointer to the image of the character, not set for characters that were only measured
+    std::shared_ptr<ColorImage> colorImage; //!< Pointer to the RGB image of the character, only set for LCD rendered characters
+    std::shared_ptr<ColorImage> rgbaImage; //!< Pointer to the premultiplied RGBA image of the character, only set for color glyphs like emoji
+    uint32_t width = 0; //!< width of the image, kept when the pixels are released
+    uint32_t height = 0; //!< height of the image, kept when the pixels are released
     int32_t bitmap_left; //!< bearing from top of the bitmap
     int32_t bitmap_top; //!< bearing from left of the bitmap
     double horiAdvance; //!< horizontal advance of character
     double vertAdvance; //!< vertical advance of character
     uint32_t unicode; //!< unicode codepoint of this character
+    uint32_t face; //!< index of the font face the character was rendered from
+    uint32_t phase; //!< sub pixel phase of the character, see FreeTypeRender::renderUnicodeCharacter()
 };
 
 /*! \brief Wrapper to the FreeType2 Library
@@ -38,6 +46,13 @@ struct ImageCharacter {
  *  This class provides the means to open arbitrary TrueType fonts and render
  *  images of single characters from the font. To address a certain character
  *  the unicode codepoint of the character is needed.
+ *
+ *  Several fonts may be given as a fallback chain. Each character is then
+ *  rendered from the first font that contains it.
+ *
+ *  The fonts are held by a FontSession. Several renderers with different
+ *  font sizes or different instances of a variable font can share one
+ *  session, so the fonts are only loaded once.
  */
 class FreeTypeRender {
 public:
@@ -45,28 +60,114 @@ public:
      *
      *  \param fontpath the path to the TrueType font
      *  \param fontSize size of the font in pixels
+     *  \param enableAntiAliasing render grayscale instead of monochrome characters
+     *  \param enableHinting use the hinting of the font
+     *  \param enableLcdRendering render characters for LCD screens with horizontal RGB subpixels
      */
-    FreeTypeRender(const std::filesystem::path& fontpath, double fontSize, bool enableAntiAliasing = true, bool enableHinting = true);
+    FreeTypeRender(const std::filesystem::path& fontpath, double fontSize, bool enableAntiAliasing = true, bool enableHinting = true, bool enableLcdRendering = false);
+
+    /*! \brief Constructor for a chain of fallback fonts
+     *
+     *  \param fontpaths the paths to the TrueType fonts, ordered by priority
+     *  \param fontSize size of the font in pixels
+     */
+    FreeTypeRender(const std::vector<std::filesystem::path>& fontpaths, double fontSize, bool enableAntiAliasing = true, bool enableHinting = true, bool enableLcdRendering = false);
+
+    /*! \brief Constructor using already loaded fonts
+     *
+     *  \param session the session holding the fonts
+     *  \param fontSize size of the font in pixels
+     *  \param variation instance of the first font of the session if it is a variable font
+     */
+    FreeTypeRender(std::shared_ptr<FontSession> session, double fontSize, bool enableAntiAliasing = true, bool enableHinting = true, bool enableLcdRendering = false,
+                   const FontVariation& variation = FontVariation());
     virtual ~FreeTypeRender();
 
     /*! \brief renders a single character
      *
-     *  The character is rendered into a greyscale image. It is returned in
+     *  The character is rendered into a greyscale image. With LCD rendering
+     *  the character is additionally rendered into an RGB image, the
+     *  greyscale image then contains the maximum of the subpixels. It is returned in
      *  an ImageCharacter structure that also contains information on how to
      *  use the character as a font.
+     *  If none of the fonts contains the character, the missing glyph
+     *  of the first font is rendered.
+     *
+     *  For sub pixel positioning the character can be rendered shifted to
+     *  the right by phase / phaseCount pixels.
+     *
+     *  Color glyphs (CBDT, sbix and COLR tables) are rendered into an RGBA
+     *  image, the greyscale image then contains the alpha channel. Fonts
+     *  containing only bitmaps of fixed sizes use the smallest strike not
+     *  smaller than the font size, its bitmaps are scaled to the font size.
+     *
+     *  Empty rows and columns at the edges of the image are removed, so the
+     *  image is the bounding box of the visible pixels. Characters without
+     *  visible pixels have an empty image.
      *
      *  \param character unicode point to render
+     *  \param phase sub pixel phase to render, must be smaller than phaseCount
+     *  \param phaseCount number of sub pixel phases per pixel
      *  \return an ImageCharacter structure of the character
      */
-    std::shared_ptr<ImageCharacter> renderUnicodeCharacter(uint32_t character);
+    std::shared_ptr<ImageCharacter> renderUnicodeCharacter(uint32_t character, uint32_t phase = 0, uint32_t phaseCount = 1);
 
-    std::string getFontName();
+    /*! \brief returns the metrics of a character without rendering it
+     *
+     *  For outlines only the glyph is loaded, the size and bearings are
+     *  those of a box that contains the image renderUnicodeCharacter()
+     *  returns for the same arguments, the image itself is not set. The
+     *  box is the control box of the outline plus a pixel on every side for
+     *  the LCD filter and the drop-out control of monochrome rendering, so
+     *  it is usually larger than the trimmed image.
+     *
+     *  Embedded bitmaps and color glyphs are loaded as images anyway, they
+     *  are rendered completely and returned like renderUnicodeCharacter()
+     *  does.
+     */
+    std::shared_ptr<ImageCharacter> measureUnicodeCharacter(uint32_t character, uint32_t phase = 0, uint32_t phaseCount = 1);
+
+    /*! \brief returns a hash of the glyph a character is rendered from
+     *
+     *  For outlines the scaled and hinted outline and the advances are
+     *  hashed without rendering the character. Embedded bitmaps and color
+     *  glyphs are rendered and their pixels are hashed. A character with the
+     *  same hash in a changed font is rendered the same in all sub pixel
+     *  phases, see GlyphCache::removeChangedCharacters().
+     */
+    uint64_t getCharacterHash(uint32_t character);
+
+    /*! \brief returns the name of the first font, for instances other than the default instance followed by the instance */
+    std::string getFontName() { return m_fontName; }
+    std::string getFaceName(uint32_t face) { return m_session->getFaceName(face); }
+    uint32_t getFaceCount() { return m_session->getFaceCount(); }
 
 private:
-    FT_Library m_library;
-    FT_Face m_face;
+    /*! \brief sets the font size of a face, the size object of the face has to be active */
+    int setSize(uint32_t face);
+
+    /*! \brief loads a character into the glyph slot of its face, the session has to be locked
+     *
+     *  \param render render the character, otherwise only the (shifted) outline is loaded
+     *  \return the index of the face the character was loaded from
+     */
+    uint32_t loadCharacter(uint32_t character, uint32_t phase, uint32_t phaseCount, bool render);
+
+    /*! \brief creates a character from the bitmap in the glyph slot of a face, the session has to be locked */
+    std::shared_ptr<ImageCharacter> createCharacter(uint32_t face, uint32_t character, uint32_t phase);
+
+    /*! \brief sets the advances of a character from the glyph slot of a face */
+    void setAdvances(ImageCharacter& imgCharacter, uint32_t face);
+
+    std::shared_ptr<FontSession> m_session;
+    double m_fontSize;
+    std::string m_fontName;
+    std::vector<FT_Fixed> m_coordinates; //!< design coordinates of the instance of the first font, empty if it is no variable font
+    std::vector<FT_Size> m_sizes; //!< size object of this renderer for every face of the session
+    std::vector<double> m_scales; //!< scale from the selected strike to the font size for every face, 1 for scalable faces
     bool m_enableAntiAliasing;
     bool m_enableHinting;
+    bool m_enableLcdRendering;
 };
 
 #endif /* FREETYPERENDER_H_ */
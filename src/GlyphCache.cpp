@@ -0,0 +1,109 @@
+/*
+ * GlyphCache.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "GlyphCache.h"
+
+#include <set>
+
+#include "TextureFontCreator.h"
+
+GlyphCache::RenderSettings GlyphCache::getRenderSettings(const FontVariant& variant) {
+    RenderSettings settings;
+    settings.fontSize = variant.fontSize;
+    settings.enableAntiAliasing = variant.enableAntiAliasing;
+    settings.enableHinting = variant.enableHinting;
+    settings.enableLcdRendering = variant.enableLcdRendering;
+    settings.subpixelPhases = variant.subpixelPhases;
+    settings.faceIndex = variant.faceIndex;
+    settings.variation = variant.variation;
+    return settings;
+}
+
+std::shared_ptr<ImageCharacter> GlyphCache::find(const FontVariant& variant, char32_t unicode, uint32_t phase) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!(m_settings == getRenderSettings(variant))) {
+        return nullptr;
+    }
+
+    auto it = m_characters.find(characterKey(unicode, phase));
+    if (it == m_characters.end()) {
+        return nullptr;
+    }
+    return it->second;
+}
+
+void GlyphCache::assign(const FontVariant& variant, const std::vector<std::shared_ptr<ImageCharacter>>& characters) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_settings = getRenderSettings(variant);
+    m_characters.clear();
+    for (const std::shared_ptr<ImageCharacter>& imgChar : characters) {
+        m_characters.emplace(characterKey(imgChar->unicode, imgChar->phase), imgChar);
+    }
+}
+
+void GlyphCache::insert(const FontVariant& variant, const std::vector<std::shared_ptr<ImageCharacter>>& characters) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    RenderSettings settings = getRenderSettings(variant);
+    if (!(m_settings == settings)) {
+        m_settings = settings;
+        m_characters.clear();
+    }
+    for (const std::shared_ptr<ImageCharacter>& imgChar : characters) {
+        m_characters[characterKey(imgChar->unicode, imgChar->phase)] = imgChar;
+    }
+}
+
+void GlyphCache::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_characters.clear();
+    m_characterHashes.clear();
+}
+
+size_t GlyphCache::removeChangedCharacters(const FontVariant& variant) {
+    std::shared_ptr<FontSession> session = variant.session;
+    if (!session) {
+        std::vector<std::filesystem::path> fontpaths = {variant.fontpath};
+        fontpaths.insert(fontpaths.end(), variant.fallbackFontpaths.begin(), variant.fallbackFontpaths.end());
+        session = std::make_shared<FontSession>(fontpaths, variant.faceIndex);
+    }
+    FreeTypeRender renderer(session, variant.fontSize, variant.enableAntiAliasing, variant.enableHinting, variant.enableLcdRendering, variant.variation);
+
+    std::u32string str = toU32String(variant.chars);
+    std::set<char32_t> characterSet(str.begin(), str.end());
+    std::unordered_map<char32_t, uint64_t> hashes;
+    for (char32_t unicode : characterSet) {
+        hashes[unicode] = renderer.getCharacterHash(unicode);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    RenderSettings settings = getRenderSettings(variant);
+    if (!(m_settings == settings)) {
+        // the hashes depend on the settings, like the images
+        m_settings = settings;
+        m_characters.clear();
+        m_characterHashes.clear();
+    }
+
+    std::set<char32_t> removed;
+    for (auto it = m_characters.begin(); it != m_characters.end(); ) {
+        char32_t unicode = it->second->unicode;
+        auto previous = m_characterHashes.find(unicode);
+        auto current = hashes.find(unicode);
+        if (previous == m_characterHashes.end() || current == hashes.end() || previous->second != current->second) {
+            removed.insert(unicode);
+            it = m_characters.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    m_characterHashes = hashes;
+    return removed.size();
+}
+
+size_t GlyphCache::size() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_characters.size();
+}
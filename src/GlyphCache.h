@@ -0,0 +1,84 @@
+/*
+ * GlyphCache.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef GLYPHCACHE_H_
+#define GLYPHCACHE_H_
+
+#include <stdint.h>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "FreeTypeRender.h"
+
+struct FontVariant;
+
+/*! \brief Keeps the rendered characters of a font variant between builds
+ *
+ *  When a texture font is created again with a cache assigned to its font
+ *  variant, only characters missing in the cache are rendered. After
+ *  rendering, the cache holds exactly the characters of the last build, so
+ *  characters removed from the character set are released.
+ *
+ *  The cache is only used while the render settings of the variant (size,
+ *  anti aliasing, hinting, LCD rendering, sub pixel phases, face index and
+ *  instance) stay the same. Changes of the font files are not detected by
+ *  the cache itself, removeChangedCharacters() has to be called when they
+ *  happen.
+ */
+class GlyphCache {
+public:
+    /*! \brief returns the cached character, nullptr if it was not rendered with the settings of the variant */
+    std::shared_ptr<ImageCharacter> find(const FontVariant& variant, char32_t unicode, uint32_t phase);
+
+    /*! \brief replaces the content of the cache with the characters rendered for the variant */
+    void assign(const FontVariant& variant, const std::vector<std::shared_ptr<ImageCharacter>>& characters);
+
+    /*! \brief adds characters rendered for the variant, characters rendered with other settings are removed */
+    void insert(const FontVariant& variant, const std::vector<std::shared_ptr<ImageCharacter>>& characters);
+
+    /*! \brief removes all characters */
+    void clear();
+
+    /*! \brief removes the characters whose glyphs changed in the fonts of the variant
+     *
+     *  The hashes of all characters of the variant are computed from the
+     *  current fonts, see FreeTypeRender::getCharacterHash(), and compared
+     *  with the hashes of the last call. Characters whose hash changed or
+     *  was not known are removed, the others are kept although the font
+     *  files changed. Call it before every build of the variant.
+     *
+     *  \return number of removed characters, all phases of a character count once
+     */
+    size_t removeChangedCharacters(const FontVariant& variant);
+
+    size_t size();
+
+private:
+    /*! \brief settings affecting the rendered images of characters */
+    struct RenderSettings {
+        double fontSize = 0;
+        bool enableAntiAliasing = false;
+        bool enableHinting = false;
+        bool enableLcdRendering = false;
+        uint32_t subpixelPhases = 0;
+        uint32_t faceIndex = 0;
+        FontVariation variation;
+
+        bool operator==(const RenderSettings& other) const = default;
+    };
+
+    static RenderSettings getRenderSettings(const FontVariant& variant);
+    static uint64_t characterKey(char32_t unicode, uint32_t phase) { return (static_cast<uint64_t>(phase) << 32) | unicode; }
+
+    std::mutex m_mutex;
+    RenderSettings m_settings;
+    std::unordered_map<uint64_t, std::shared_ptr<ImageCharacter>> m_characters;
+    std::unordered_map<char32_t, uint64_t> m_characterHashes; //!< hashes of the last call of removeChangedCharacters()
+};
+
+#endif /* GLYPHCACHE_H_ */
@@ -0,0 +1,210 @@
+/*
+ * GlyphMetrics.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "GlyphMetrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+int32_t toFixed16_16(double value) {
+    return static_cast<int32_t>(std::lround(value * 65536));
+}
+
+double fromFixed16_16(int32_t value) {
+    return value / (double)65536;
+}
+
+/*! \brief converts a value to a smaller integer type, throws if it does not fit */
+template <typename T>
+static T checkedCast(int64_t value, uint32_t unicode, const char* name) {
+    if (value < std::numeric_limits<T>::min() || value > std::numeric_limits<T>::max()) {
+        std::stringstream errorText;
+        errorText << "The " << name << " of character " << unicode << " does not fit into the compact metrics.";
+        throw std::runtime_error(errorText.str());
+    }
+    return static_cast<T>(value);
+}
+
+CompactGlyphMetrics makeCompactGlyphMetrics(const ImageCharacter& character, int32_t left, int32_t top, uint32_t page) {
+    CompactGlyphMetrics metrics;
+    uint32_t unicode = character.unicode;
+
+    metrics.unicode = unicode;
+    metrics.horiAdvance = checkedCast<int32_t>(std::llround(character.horiAdvance * 65536), unicode, "horizontal advance");
+    metrics.vertAdvance = checkedCast<int32_t>(std::llround(character.vertAdvance * 65536), unicode, "vertical advance");
+    metrics.bitmapLeft = checkedCast<int16_t>(character.bitmap_left, unicode, "left bearing");
+    metrics.bitmapTop = checkedCast<int16_t>(character.bitmap_top, unicode, "top bearing");
+    metrics.left = checkedCast<uint16_t>(left, unicode, "left offset");
+    metrics.top = checkedCast<uint16_t>(top, unicode, "top offset");
+    metrics.width = checkedCast<uint16_t>(character.width, unicode, "width");
+    metrics.height = checkedCast<uint16_t>(character.height, unicode, "height");
+    metrics.face = checkedCast<uint16_t>(character.face, unicode, "font face");
+    metrics.phase = checkedCast<uint8_t>(character.phase, unicode, "sub pixel phase");
+    metrics.page = checkedCast<uint8_t>(page, unicode, "page");
+
+    return metrics;
+}
+
+static void appendVarint(std::vector<uint8_t>& buffer, uint64_t value) {
+    while (value >= 0x80) {
+        buffer.push_back((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    buffer.push_back(value);
+}
+
+static void appendSignedVarint(std::vector<uint8_t>& buffer, int64_t value) {
+    appendVarint(buffer, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+/*! \brief bounds checked reader for variable length integers */
+class VarintReader {
+public:
+    VarintReader(const uint8_t* data, size_t size) : m_data(data), m_size(size), m_pos(0) {}
+
+    uint64_t read() {
+        uint64_t value = 0;
+        for (uint32_t shift = 0; shift < 64; shift += 7) {
+            if (m_pos >= m_size) {
+                throw std::runtime_error("Glyph metrics are truncated.");
+            }
+            uint8_t byte = m_data[m_pos++];
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+        throw std::runtime_error("Glyph metrics contain an invalid variable length integer.");
+    }
+
+    int64_t readSigned() {
+        uint64_t value = read();
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    template <typename T>
+    T read(int64_t offset = 0) {
+        int64_t value = static_cast<int64_t>(read()) + offset;
+        return checkValue<T>(value);
+    }
+
+    template <typename T>
+    T readSigned(int64_t offset = 0) {
+        int64_t value = readSigned() + offset;
+        return checkValue<T>(value);
+    }
+
+private:
+    template <typename T>
+    T checkValue(int64_t value) {
+        if (value < std::numeric_limits<T>::min() || value > std::numeric_limits<T>::max()) {
+            throw std::runtime_error("Glyph metrics contain a value out of range.");
+        }
+        return static_cast<T>(value);
+    }
+
+    const uint8_t* m_data;
+    size_t m_size;
+    size_t m_pos;
+};
+
+std::vector<uint8_t> encodeGlyphMetrics(std::vector<CompactGlyphMetrics> glyphs, MetricsEncoding encoding, bool withPage) {
+    std::vector<uint8_t> buffer;
+
+    switch (encoding) {
+        case MetricsEncoding::Compact:
+            buffer.resize(glyphs.size() * sizeof(CompactGlyphMetrics));
+            if (!glyphs.empty()) {
+                memcpy(buffer.data(), glyphs.data(), buffer.size());
+            }
+            break;
+
+        case MetricsEncoding::CompactDelta: {
+            std::stable_sort(glyphs.begin(), glyphs.end(), [](const CompactGlyphMetrics& a, const CompactGlyphMetrics& b) {
+                return (a.unicode < b.unicode) || (a.unicode == b.unicode && a.phase < b.phase);
+            });
+
+            CompactGlyphMetrics previous = {};
+            for (const CompactGlyphMetrics& glyph : glyphs) {
+                appendVarint(buffer, glyph.unicode - previous.unicode);
+                appendSignedVarint(buffer, static_cast<int64_t>(glyph.horiAdvance) - previous.horiAdvance);
+                appendSignedVarint(buffer, static_cast<int64_t>(glyph.vertAdvance) - previous.vertAdvance);
+                appendSignedVarint(buffer, glyph.bitmapLeft);
+                appendSignedVarint(buffer, glyph.bitmapTop);
+                appendVarint(buffer, glyph.left);
+                appendVarint(buffer, glyph.top);
+                appendVarint(buffer, glyph.width);
+                appendVarint(buffer, glyph.height);
+                appendVarint(buffer, glyph.face);
+                appendVarint(buffer, glyph.phase);
+                if (withPage) {
+                    appendVarint(buffer, glyph.page);
+                }
+                previous = glyph;
+            }
+            break;
+        }
+
+        default:
+            throw std::runtime_error("Unsupported glyph metrics encoding.");
+    }
+
+    return buffer;
+}
+
+std::vector<CompactGlyphMetrics> decodeGlyphMetrics(const uint8_t* data, size_t size, size_t count, MetricsEncoding encoding, bool withPage) {
+    std::vector<CompactGlyphMetrics> glyphs;
+
+    switch (encoding) {
+        case MetricsEncoding::Compact:
+            if (size / sizeof(CompactGlyphMetrics) < count) {
+                throw std::runtime_error("Glyph metrics are truncated.");
+            }
+            glyphs.resize(count);
+            if (count > 0) {
+                memcpy(glyphs.data(), data, count * sizeof(CompactGlyphMetrics));
+            }
+            break;
+
+        case MetricsEncoding::CompactDelta: {
+            // every record needs at least one byte per field
+            if (size / (withPage ? 12 : 11) < count) {
+                throw std::runtime_error("Glyph metrics are truncated.");
+            }
+            glyphs.reserve(count);
+
+            VarintReader reader(data, size);
+            CompactGlyphMetrics previous = {};
+            for (size_t i = 0; i < count; i++) {
+                CompactGlyphMetrics glyph;
+                glyph.unicode = reader.read<uint32_t>(previous.unicode);
+                glyph.horiAdvance = reader.readSigned<int32_t>(previous.horiAdvance);
+                glyph.vertAdvance = reader.readSigned<int32_t>(previous.vertAdvance);
+                glyph.bitmapLeft = reader.readSigned<int16_t>();
+                glyph.bitmapTop = reader.readSigned<int16_t>();
+                glyph.left = reader.read<uint16_t>();
+                glyph.top = reader.read<uint16_t>();
+                glyph.width = reader.read<uint16_t>();
+                glyph.height = reader.read<uint16_t>();
+                glyph.face = reader.read<uint16_t>();
+                glyph.phase = reader.read<uint8_t>();
+                glyph.page = withPage ? reader.read<uint8_t>() : 0;
+                glyphs.push_back(glyph);
+                previous = glyph;
+            }
+            break;
+        }
+
+        default:
+            throw std::runtime_error("Unsupported glyph metrics encoding.");
+    }
+
+    return glyphs;
+}
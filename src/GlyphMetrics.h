@@ -0,0 +1,91 @@
+/*
+ * GlyphMetrics.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef GLYPHMETRICS_H_
+#define GLYPHMETRICS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include "FreeTypeRender.h"
+
+/*! \brief Encoding of the character tables in binary texture fonts */
+enum class MetricsEncoding : uint8_t {
+    Plain = 0,        //!< records as in the legacy format version, advances stored as double
+    Compact = 1,      //!< fixed size CompactGlyphMetrics records
+    CompactDelta = 2  //!< CompactGlyphMetrics sorted by codepoint, delta and varint coded
+};
+
+/*! \brief Compact metrics of a single character in a texture font
+ *
+ *  Advances are stored as 16.16 fixed point values, which is the format
+ *  FreeType delivers linear advances in, so no precision is lost. All
+ *  other values are stored with 16 bits. The record has a size of 28 bytes,
+ *  so it fits into a single cache line.
+ */
+struct CompactGlyphMetrics {
+    uint32_t unicode; //!< unicode codepoint of the character
+    int32_t horiAdvance; //!< horizontal advance in 16.16 fixed point
+    int32_t vertAdvance; //!< vertical advance in 16.16 fixed point
+    int16_t bitmapLeft; //!< left bearing of the character
+    int16_t bitmapTop; //!< top bearing of the character
+    uint16_t left; //!< left offset of the character in the image
+    uint16_t top; //!< top offset of the character in the image
+    uint16_t width; //!< width of the character
+    uint16_t height; //!< height of the character
+    uint16_t face; //!< index of the font face the character was rendered from
+    uint8_t phase; //!< sub pixel phase of the character
+    uint8_t page; //!< 1 if the character is stored in the color page, always 0 without FORMAT_FEATURE_COLOR_PAGE
+};
+
+static_assert(sizeof(CompactGlyphMetrics) == 28, "CompactGlyphMetrics must not contain padding");
+
+/*! \brief converts a value to 16.16 fixed point, the value has to be within +-32768 */
+int32_t toFixed16_16(double value);
+double fromFixed16_16(int32_t value);
+
+/*! \brief creates the compact metrics of a character
+ *
+ *  Throws an exception if a value cannot be represented in the compact
+ *  metrics.
+ *
+ *  \param character the rendered character
+ *  \param left left offset of the character in the image
+ *  \param top top offset of the character in the image
+ *  \param page image the character is stored in, see ImageOffset::page
+ */
+CompactGlyphMetrics makeCompactGlyphMetrics(const ImageCharacter& character, int32_t left, int32_t top, uint32_t page = 0);
+
+/*! \brief encodes a table of compact metrics
+ *
+ *  With MetricsEncoding::Compact the records are stored in the given order
+ *  as little endian values. With MetricsEncoding::CompactDelta the records
+ *  are sorted by codepoint and phase. The difference to the codepoint and
+ *  advances of the previous record is stored, all values are stored as
+ *  variable length integers (LEB128, signed values zigzag coded).
+ *
+ *  \param glyphs the metrics to encode
+ *  \param encoding MetricsEncoding::Compact or MetricsEncoding::CompactDelta
+ *  \param withPage store the page of every record with MetricsEncoding::CompactDelta,
+ *         used by files with FORMAT_FEATURE_COLOR_PAGE. Compact records always contain the page
+ *  \return the encoded table
+ */
+std::vector<uint8_t> encodeGlyphMetrics(std::vector<CompactGlyphMetrics> glyphs, MetricsEncoding encoding, bool withPage = false);
+
+/*! \brief decodes a table of compact metrics
+ *
+ *  Throws an exception if the data is truncated or malformed.
+ *
+ *  \param data the encoded table
+ *  \param size size of the encoded table in bytes
+ *  \param count number of records in the table
+ *  \param encoding MetricsEncoding::Compact or MetricsEncoding::CompactDelta
+ *  \param withPage the records contain the page, see encodeGlyphMetrics()
+ */
+std::vector<CompactGlyphMetrics> decodeGlyphMetrics(const uint8_t* data, size_t size, size_t count, MetricsEncoding encoding, bool withPage = false);
+
+#endif /* GLYPHMETRICS_H_ */
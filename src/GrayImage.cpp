@@ -7,18 +7,27 @@
 
 #include "GrayImage.h"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 
+#include "Instrumentation.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 GrayImage::GrayImage(uint32_t width, uint32_t height, uint8_t fill) {
-    data.resize(width * height, fill);
+    data.resize(static_cast<size_t>(width) * height, fill);
     this->width = width;
     this->rows = height;
     this->pitch = width;
+    countAllocation();
 }
 
 GrayImage::GrayImage(FT_Bitmap& bitmap) {
-    data.resize(bitmap.width * bitmap.rows);
+    data.resize(static_cast<size_t>(bitmap.width) * bitmap.rows);
     this->pitch = bitmap.width;
     this->width = bitmap.width;
     this->rows = bitmap.rows;
@@ -44,6 +53,7 @@ GrayImage::GrayImage(FT_Bitmap& bitmap) {
             errorText << "FreeType delivered invalid pixel mode: " << static_cast<int32_t>(bitmap.pixel_mode);
             throw std::runtime_error(errorText.str());
     }
+    countAllocation();
 }
 
 GrayImage::GrayImage(const GrayImage& other) {
@@ -54,12 +64,18 @@ GrayImage::GrayImage(const GrayImage& other) {
 
     // now copy data
     memcpy(data.data(), other.data.data(), other.width * other.rows);
+    countAllocation();
 }
 
 GrayImage::~GrayImage() {
     // TODO Auto-generated destructor stub
 }
 
+void GrayImage::countAllocation() {
+    Instrumentation::addCount("image allocations");
+    Instrumentation::addCount("image bytes", data.size());
+}
+
 bool GrayImage::blit(GrayImage& source, uint32_t posX, uint32_t posY) {
     // check if source image fits in this image
     if (source.getWidth() + posX > this->getWidth()) {
@@ -77,6 +93,76 @@ bool GrayImage::blit(GrayImage& source, uint32_t posX, uint32_t posY) {
     return true;
 }
 
+/*! \brief combines a row of source pixels with a row of destination pixels
+ *
+ *  Max and Add use SSE2 if available and process 16 pixels at once, the
+ *  remaining loops are simple enough to be vectorized by the compiler.
+ */
+static void compositeRow(uint8_t* __restrict dst, const uint8_t* __restrict src, size_t length, BlendMode mode) {
+    size_t i = 0;
+
+    switch (mode) {
+        case BlendMode::Replace:
+            memcpy(dst, src, length);
+            break;
+
+        case BlendMode::Max:
+#ifdef __SSE2__
+            for (; i + 16 <= length; i += 16) {
+                __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+                __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_max_epu8(s, d));
+            }
+#endif
+            for (; i < length; i++) {
+                dst[i] = std::max(dst[i], src[i]);
+            }
+            break;
+
+        case BlendMode::Add:
+#ifdef __SSE2__
+            for (; i + 16 <= length; i += 16) {
+                __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+                __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_adds_epu8(s, d));
+            }
+#endif
+            for (; i < length; i++) {
+                dst[i] = std::min(dst[i] + src[i], 255);
+            }
+            break;
+
+        case BlendMode::Over:
+            // dst = src + dst * (255 - src) / 255, the division is rounded exactly
+            for (; i < length; i++) {
+                uint32_t product = dst[i] * (255 - src[i]) + 128;
+                dst[i] = src[i] + ((product + (product >> 8)) >> 8);
+            }
+            break;
+    }
+}
+
+void GrayImage::composite(GrayImage& source, int32_t posX, int32_t posY, BlendMode mode) {
+    composite(source.data.data(), source.pitch, source.getWidth(), source.getHeight(), posX, posY, mode);
+}
+
+void GrayImage::composite(const uint8_t* source, size_t sourcePitch, uint32_t width, uint32_t height,
+                          int32_t posX, int32_t posY, BlendMode mode) {
+    // clip the source rectangle against this image
+    int64_t firstColumn = std::max<int64_t>(0, -static_cast<int64_t>(posX));
+    int64_t firstRow = std::max<int64_t>(0, -static_cast<int64_t>(posY));
+    int64_t lastColumn = std::min<int64_t>(width, static_cast<int64_t>(this->getWidth()) - posX);
+    int64_t lastRow = std::min<int64_t>(height, static_cast<int64_t>(this->getHeight()) - posY);
+
+    if (firstColumn >= lastColumn || firstRow >= lastRow) {
+        return;
+    }
+
+    for (int64_t row = firstRow; row < lastRow; row++) {
+        compositeRow(this->getRow(row + posY) + posX + firstColumn, source + row * sourcePitch + firstColumn, lastColumn - firstColumn, mode);
+    }
+}
+
 /*! \brief flips an image vertically
  *
  *  \param ptr pointer to the first line of pixels
@@ -105,22 +191,238 @@ void GrayImage::flipVertically() {
     FlipVertically(data.data(), pitch, width, rows);
 }
 
-std::shared_ptr<QImage> GrayImage::getQImage(uint8_t red, uint8_t green, uint8_t blue) {
-    std::shared_ptr<QImage> image(new QImage(QSize(this->getWidth(), this->getHeight()), QImage::Format_ARGB32));
+/*! \brief replicates the edge pixels of a rectangle into its surroundings
+ *
+ *  \param ptr pointer to the first line of pixels
+ *  \param pitch distance between the first pixel of a line to the first pixel of the next line in bytes
+ *  \param bytesPerPixel size of a pixel in bytes
+ *  \param posX upper left corner of the rectangle in pixels
+ *  \param posY upper left corner of the rectangle in pixels
+ *  \param width width of the rectangle in pixels
+ *  \param height height of the rectangle in pixels
+ *  \param border width of the border around the rectangle in pixels
+ */
+void ExtrudeEdges(void* ptr, size_t pitch, size_t bytesPerPixel, size_t posX, size_t posY, size_t width, size_t height, size_t border) {
+    if (width == 0 || height == 0 || border == 0) {
+        return;
+    }
+
+    uint8_t* image = static_cast<uint8_t*>(ptr);
+
+    // extend every line to the left and to the right
+    for (size_t line = posY; line < posY + height; line++) {
+        uint8_t* first = image + pitch * line + posX * bytesPerPixel;
+        uint8_t* last = first + (width - 1) * bytesPerPixel;
+        for (size_t i = 1; i <= border; i++) {
+            memcpy(first - i * bytesPerPixel, first, bytesPerPixel);
+            memcpy(last + i * bytesPerPixel, last, bytesPerPixel);
+        }
+    }
+
+    // copy the extended first and last line upwards and downwards
+    size_t lineLength = (width + 2 * border) * bytesPerPixel;
+    uint8_t* firstLine = image + pitch * posY + (posX - border) * bytesPerPixel;
+    uint8_t* lastLine = firstLine + pitch * (height - 1);
+    for (size_t i = 1; i <= border; i++) {
+        memcpy(firstLine - i * pitch, firstLine, lineLength);
+        memcpy(lastLine + i * pitch, lastLine, lineLength);
+    }
+}
+
+/*! \brief reduces an image to half its width and height
+ *
+ *  Every destination pixel is the rounded average of 2x2 source pixels. The
+ *  destination is max(1, sourceWidth / 2) pixels wide and max(1, sourceHeight / 2)
+ *  pixels high, the last column or line of odd sized images is dropped.
+ *
+ *  \param bytesPerPixel number of 8bit channels per pixel, channels are filtered separately
+ */
+void DownsampleBox(const void* source, size_t sourcePitch, size_t sourceWidth, size_t sourceHeight, size_t bytesPerPixel, void* destination, size_t destinationPitch) {
+    size_t width = std::max<size_t>(1, sourceWidth / 2);
+    size_t height = std::max<size_t>(1, sourceHeight / 2);
+
+    for (size_t line = 0; line < height; line++) {
+        const uint8_t* upper = static_cast<const uint8_t*>(source) + sourcePitch * std::min(2 * line, sourceHeight - 1);
+        const uint8_t* lower = static_cast<const uint8_t*>(source) + sourcePitch * std::min(2 * line + 1, sourceHeight - 1);
+        uint8_t* output = static_cast<uint8_t*>(destination) + destinationPitch * line;
+
+        for (size_t x = 0; x < width; x++) {
+            size_t left = std::min(2 * x, sourceWidth - 1) * bytesPerPixel;
+            size_t right = std::min(2 * x + 1, sourceWidth - 1) * bytesPerPixel;
+            for (size_t channel = 0; channel < bytesPerPixel; channel++) {
+                output[x * bytesPerPixel + channel] = (upper[left + channel] + upper[right + channel]
+                                                     + lower[left + channel] + lower[right + channel] + 2) >> 2;
+            }
+        }
+    }
+}
+
+/*! \brief source pixels covered by a destination pixel and the covered fraction of each */
+struct AreaWeights {
+    size_t first; //!< first source pixel
+    std::vector<float> weights; //!< weights of the source pixels starting with first, they add up to 1
+};
 
-    for (uint32_t y = 0; y < getHeight(); y++) {
-        uint32_t* line = reinterpret_cast<uint32_t*>(image->scanLine(y));
-        uint8_t* sourceLine = getRow(y);
-        for (uint32_t x = 0; x < getWidth(); x++) {
-            uint32_t color = qRgb(sourceLine[x] * (double) red   / 255.0,
-                                  sourceLine[x] * (double) blue  / 255.0,
-                                  sourceLine[x] * (double) green / 255.0);
-            line[x] = color;
+static std::vector<AreaWeights> getAreaWeights(size_t sourceSize, size_t destinationSize) {
+    std::vector<AreaWeights> result(destinationSize);
+    double scale = static_cast<double>(sourceSize) / destinationSize;
+    for (size_t i = 0; i < destinationSize; i++) {
+        double start = i * scale;
+        double end = std::min<double>(sourceSize, (i + 1) * scale);
+        result[i].first = static_cast<size_t>(start);
+        for (size_t pixel = result[i].first; pixel < end; pixel++) {
+            double covered = std::min<double>(end, pixel + 1) - std::max<double>(start, pixel);
+            result[i].weights.push_back(covered / scale);
         }
     }
+    return result;
+}
 
-    return image;
+/*! \brief scales an image to an arbitrary size
+ *
+ *  Every destination pixel is the average of the source pixels it covers,
+ *  weighted by the covered area. The filter is separable, so the image is
+ *  scaled horizontally first and vertically afterwards. Enlarged images are
+ *  blocky, the filter is meant for reducing bitmaps of fixed size fonts.
+ *  Channels are filtered separately, colors should be premultiplied by
+ *  their alpha.
+ *
+ *  \param bytesPerPixel number of 8bit channels per pixel
+ *  \param width width of the destination in pixels
+ *  \param height height of the destination in pixels
+ */
+void ResampleArea(const void* source, size_t sourcePitch, size_t sourceWidth, size_t sourceHeight, size_t bytesPerPixel,
+                  void* destination, size_t destinationPitch, size_t width, size_t height) {
+    if (width == 0 || height == 0 || sourceWidth == 0 || sourceHeight == 0) {
+        return;
+    }
+
+    std::vector<AreaWeights> columns = getAreaWeights(sourceWidth, width);
+    std::vector<AreaWeights> lines = getAreaWeights(sourceHeight, height);
+
+    // scale every source line horizontally
+    size_t lineLength = width * bytesPerPixel;
+    std::vector<float> scaled(lineLength * sourceHeight, 0.0f);
+    for (size_t line = 0; line < sourceHeight; line++) {
+        const uint8_t* input = static_cast<const uint8_t*>(source) + sourcePitch * line;
+        float* output = scaled.data() + lineLength * line;
+        for (size_t x = 0; x < width; x++) {
+            for (size_t i = 0; i < columns[x].weights.size(); i++) {
+                const uint8_t* pixel = input + (columns[x].first + i) * bytesPerPixel;
+                for (size_t channel = 0; channel < bytesPerPixel; channel++) {
+                    output[x * bytesPerPixel + channel] += pixel[channel] * columns[x].weights[i];
+                }
+            }
+        }
+    }
+
+    // combine the scaled lines vertically
+    std::vector<float> sum(lineLength);
+    for (size_t line = 0; line < height; line++) {
+        std::fill(sum.begin(), sum.end(), 0.0f);
+        for (size_t i = 0; i < lines[line].weights.size(); i++) {
+            const float* input = scaled.data() + lineLength * (lines[line].first + i);
+            float weight = lines[line].weights[i];
+            for (size_t x = 0; x < lineLength; x++) {
+                sum[x] += input[x] * weight;
+            }
+        }
+
+        uint8_t* output = static_cast<uint8_t*>(destination) + destinationPitch * line;
+        for (size_t x = 0; x < lineLength; x++) {
+            output[x] = static_cast<uint8_t>(std::min(255.0f, sum[x] + 0.5f));
+        }
+    }
+}
+
+std::shared_ptr<GrayImage> GrayImage::resample(uint32_t width, uint32_t height) {
+    std::shared_ptr<GrayImage> result(new GrayImage(width, height));
+    ResampleArea(data.data(), pitch, this->width, rows, 1, result->data.data(), result->pitch, width, height);
+    return result;
 }
 
+void GrayImage::extrude(uint32_t posX, uint32_t posY, uint32_t width, uint32_t height, uint32_t border) {
+    ExtrudeEdges(data.data(), pitch, 1, posX, posY, width, height, border);
+}
 
+std::shared_ptr<GrayImage> GrayImage::downsample() {
+    std::shared_ptr<GrayImage> result(new GrayImage(std::max(1u, width / 2), std::max(1u, rows / 2)));
+    DownsampleBox(data.data(), pitch, width, rows, 1, result->data.data(), result->pitch);
+    return result;
+}
 
+/*! \brief returns true if all bytes are zero, uses SSE2 if available */
+static bool isZero(const uint8_t* ptr, size_t length) {
+    size_t i = 0;
+#ifdef __SSE2__
+    __m128i any = _mm_setzero_si128();
+    for (; i + 16 <= length; i += 16) {
+        any = _mm_or_si128(any, _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + i)));
+    }
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(any, _mm_setzero_si128())) != 0xffff) {
+        return false;
+    }
+#endif
+    uint8_t rest = 0;
+    for (; i < length; i++) {
+        rest |= ptr[i];
+    }
+    return rest == 0;
+}
+
+/*! \brief combines a row into dst using bitwise or, uses SSE2 if available */
+static void orRow(uint8_t* __restrict dst, const uint8_t* __restrict src, size_t length) {
+    size_t i = 0;
+#ifdef __SSE2__
+    for (; i + 16 <= length; i += 16) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(s, d));
+    }
+#endif
+    for (; i < length; i++) {
+        dst[i] |= src[i];
+    }
+}
+
+bool GrayImage::getContentBounds(uint32_t& posX, uint32_t& posY, uint32_t& width, uint32_t& height) {
+    uint32_t top = 0;
+    while (top < rows && isZero(getRow(top), this->width)) {
+        top++;
+    }
+    if (top == rows) {
+        return false;
+    }
+    uint32_t bottom = rows;
+    while (isZero(getRow(bottom - 1), this->width)) {
+        bottom--;
+    }
+
+    // a column is empty if it is empty in all remaining rows
+    std::vector<uint8_t> columns(this->width, 0);
+    for (uint32_t row = top; row < bottom; row++) {
+        orRow(columns.data(), getRow(row), this->width);
+    }
+    uint32_t left = 0;
+    while (columns[left] == 0) {
+        left++;
+    }
+    uint32_t right = this->width;
+    while (columns[right - 1] == 0) {
+        right--;
+    }
+
+    posX = left;
+    posY = top;
+    width = right - left;
+    height = bottom - top;
+    return true;
+}
+
+std::shared_ptr<GrayImage> GrayImage::crop(uint32_t posX, uint32_t posY, uint32_t width, uint32_t height) {
+    std::shared_ptr<GrayImage> result(new GrayImage(width, height));
+    for (uint32_t row = 0; row < height; row++) {
+        memcpy(result->getRow(row), getRow(row + posY) + posX, width);
+    }
+    return result;
+}
@@ -9,21 +9,29 @@
 #define GRAYIMAGE_H_
 
 #include <stdint.h>
+#include <stddef.h>
 #include <memory>
+#include <vector>
 #include <ft2build.h>
 #include FT_FREETYPE_H
-#include <QImage>
 
 
+/*! \brief How the pixels of a source image are combined with an image */
+enum class BlendMode {
+    Replace, //!< the source pixel replaces the destination pixel
+    Max,     //!< the maximum of both pixels is used, overlapping characters keep their shape
+    Add,     //!< both pixels are added, saturating at 255
+    Over     //!< the source is drawn over the destination using its value as alpha (Porter-Duff over)
+};
+
 /*! \brief Gray scale image class
  *
  *  This class provides means to store and manipulate grayscale images.
  *  These image always use a single 8bit value per pixel.
  *  It is possible to construct the image from a truetype2 FT_Bitmap.
- *  It is also possible to export the image as a QImage.
  *
- *  As Qt is a very heavy dependency support for exporting to QImage is
- *  only enabled when USE_QT_IMAGE is defined.
+ *  As Qt is a very heavy dependency the conversion to QImage is done by
+ *  the GUI, see QImageConversion.h.
  */
 class GrayImage {
 public:
@@ -43,8 +51,63 @@ public:
      */
     bool blit(GrayImage& source, uint32_t posX, uint32_t posY);
 
+    /*! \brief composite image onto this image
+     *
+     *  In contrast to blit() the source image may be placed partially or
+     *  completely outside of this image, only the visible part is drawn.
+     *
+     *  \param source source image
+     *  \param posX upper left corner of the source image, may be negative
+     *  \param posY upper left corner of the source image, may be negative
+     *  \param mode how source and destination pixels are combined
+     */
+    void composite(GrayImage& source, int32_t posX, int32_t posY, BlendMode mode = BlendMode::Max);
+
+    /*! \brief composite pixels onto this image, see composite()
+     *
+     *  The source is given by its first pixel and the offset between its
+     *  rows, so a rectangle of another image is drawn without copying it.
+     *
+     *  \param source upper left pixel of the source
+     *  \param sourcePitch offset between two rows of the source in bytes
+     *  \param width width of the source
+     *  \param height height of the source
+     */
+    void composite(const uint8_t* source, size_t sourcePitch, uint32_t width, uint32_t height,
+                   int32_t posX, int32_t posY, BlendMode mode = BlendMode::Max);
+
     void flipVertically();
 
+    /*! \brief replicates the edge pixels of a rectangle into its surroundings
+     *
+     *  The border around the rectangle has to be inside of the image.
+     *
+     *  \param posX upper left corner of the rectangle
+     *  \param posY upper left corner of the rectangle
+     *  \param width width of the rectangle
+     *  \param height height of the rectangle
+     *  \param border width of the border filled with the edge pixels
+     */
+    void extrude(uint32_t posX, uint32_t posY, uint32_t width, uint32_t height, uint32_t border);
+
+    /*! \brief creates an image of half the width and height using a box filter */
+    std::shared_ptr<GrayImage> downsample();
+
+    /*! \brief creates a scaled copy of the image, see ResampleArea() */
+    std::shared_ptr<GrayImage> resample(uint32_t width, uint32_t height);
+
+    /*! \brief finds the smallest rectangle containing all non-zero pixels
+     *
+     *  \param posX upper left corner of the rectangle
+     *  \param posY upper left corner of the rectangle
+     *  \param width width of the rectangle
+     *  \param height height of the rectangle
+     *  \return false if all pixels are zero, the rectangle is not set then
+     */
+    bool getContentBounds(uint32_t& posX, uint32_t& posY, uint32_t& width, uint32_t& height);
+
+    /*! \brief creates an image of a rectangle of this image, the rectangle has to be inside of the image */
+    std::shared_ptr<GrayImage> crop(uint32_t posX, uint32_t posY, uint32_t width, uint32_t height);
 
     /*! \brief get pointer to given row
      *
@@ -56,14 +119,22 @@ public:
     uint8_t* getRow(uint32_t row) { return (data.data() + pitch*row); }
     uint32_t getWidth() { return width; }
     uint32_t getHeight() { return rows; }
-    std::shared_ptr<QImage> getQImage(uint8_t red = 255, uint8_t green = 255, uint8_t blue = 255);
+    size_t getPitch() { return pitch; } //!< offset between two rows in bytes
 
 
 private:
     std::vector<uint8_t> data; //!< the imagedata
-    uint32_t pitch; //!< offset between two rows in bytes
+    size_t pitch; //!< offset between two rows in bytes
     uint32_t width; //!< length of row in bytes
     uint32_t rows; //!< number of rows in image
+
+    void countAllocation(); //!< records the allocation of the image data for the instrumentation
 };
 
+void FlipVertically(void* ptr, size_t pitch, size_t lineLength, size_t lines);
+void ExtrudeEdges(void* ptr, size_t pitch, size_t bytesPerPixel, size_t posX, size_t posY, size_t width, size_t height, size_t border);
+void DownsampleBox(const void* source, size_t sourcePitch, size_t sourceWidth, size_t sourceHeight, size_t bytesPerPixel, void* destination, size_t destinationPitch);
+void ResampleArea(const void* source, size_t sourcePitch, size_t sourceWidth, size_t sourceHeight, size_t bytesPerPixel,
+                  void* destination, size_t destinationPitch, size_t width, size_t height);
+
 #endif /* GRAYIMAGE_H_ */
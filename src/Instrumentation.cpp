@@ -0,0 +1,202 @@
+/*
+ * Instrumentation.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "Instrumentation.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+#include <nlohmann/json.hpp>
+
+std::atomic<bool> Instrumentation::s_enabled(false);
+
+namespace { // anonymous namespace
+
+/*! \brief number of timings kept for the trace, about 100 MB, later timings only count in the summary */
+const size_t MAX_TRACE_EVENTS = 1 << 20;
+
+struct TraceEvent {
+    const char* name;
+    int64_t start; //!< microseconds since the start of the recording
+    int64_t duration; //!< microseconds
+    uint32_t thread;
+    std::vector<std::pair<const char*, int64_t>> arguments;
+};
+
+struct TimerSummary {
+    uint64_t calls = 0;
+    int64_t total = 0;
+    int64_t maximum = 0;
+    int64_t first = 0; //!< start of the first call, used to sort the timers
+};
+
+/*! \brief the recorded data, guarded by mutex */
+struct Recording {
+    std::mutex mutex;
+    std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+    std::vector<TraceEvent> events; //!< at most MAX_TRACE_EVENTS
+    uint64_t droppedEvents = 0; //!< timings not kept for the trace
+    std::map<std::string_view, TimerSummary> timers; //!< all timings, the names are string literals
+    std::map<std::string, int64_t> counters;
+    std::map<std::thread::id, uint32_t> threads; //!< small numbers for the threads, in order of appearance
+};
+
+Recording& getRecording() {
+    static Recording recording;
+    return recording;
+}
+
+} // anonymous namespace
+
+void Instrumentation::setEnabled(bool enabled) {
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Instrumentation::recordCount(const char* name, int64_t value) {
+    Recording& recording = getRecording();
+    std::lock_guard<std::mutex> lock(recording.mutex);
+    recording.counters[name] += value;
+}
+
+void Instrumentation::recordEvent(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end,
+                                  const std::vector<std::pair<const char*, int64_t>>& arguments) {
+    Recording& recording = getRecording();
+    std::lock_guard<std::mutex> lock(recording.mutex);
+
+    auto thread = recording.threads.emplace(std::this_thread::get_id(), recording.threads.size()).first->second;
+
+    TraceEvent event;
+    event.name = name;
+    event.start = std::chrono::duration_cast<std::chrono::microseconds>(start - recording.origin).count();
+    event.duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    event.thread = thread;
+
+    TimerSummary& timer = recording.timers[name];
+    if (timer.calls == 0 || event.start < timer.first) {
+        timer.first = event.start;
+    }
+    timer.calls++;
+    timer.total += event.duration;
+    timer.maximum = std::max(timer.maximum, event.duration);
+
+    if (recording.events.size() < MAX_TRACE_EVENTS) {
+        event.arguments = arguments;
+        recording.events.push_back(event);
+    } else {
+        recording.droppedEvents++;
+    }
+}
+
+void Instrumentation::reset() {
+    Recording& recording = getRecording();
+    std::lock_guard<std::mutex> lock(recording.mutex);
+    recording.origin = std::chrono::steady_clock::now();
+    recording.events.clear();
+    recording.events.shrink_to_fit();
+    recording.droppedEvents = 0;
+    recording.timers.clear();
+    recording.counters.clear();
+    recording.threads.clear();
+}
+
+std::string Instrumentation::getSummary() {
+    Recording& recording = getRecording();
+    std::lock_guard<std::mutex> lock(recording.mutex);
+
+    std::vector<std::pair<std::string_view, TimerSummary>> sortedTimers(recording.timers.begin(), recording.timers.end());
+    std::stable_sort(sortedTimers.begin(), sortedTimers.end(), [](const auto& a, const auto& b) {
+        return a.second.first < b.second.first;
+    });
+
+    std::stringstream summary;
+    summary << std::fixed << std::setprecision(3);
+    summary << std::left << std::setw(28) << "timer" << std::right
+            << std::setw(8) << "calls" << std::setw(14) << "total ms" << std::setw(14) << "mean ms" << std::setw(14) << "max ms" << "\n";
+    for (const auto& [name, timer] : sortedTimers) {
+        summary << std::left << std::setw(28) << name << std::right
+                << std::setw(8) << timer.calls
+                << std::setw(14) << timer.total / 1000.0
+                << std::setw(14) << timer.total / 1000.0 / timer.calls
+                << std::setw(14) << timer.maximum / 1000.0 << "\n";
+    }
+
+    if (!recording.counters.empty()) {
+        summary << "\n" << std::left << std::setw(28) << "counter" << std::right << std::setw(22) << "value" << "\n";
+        for (const auto& [name, value] : recording.counters) {
+            summary << std::left << std::setw(28) << name << std::right << std::setw(22) << value << "\n";
+        }
+    }
+
+    return summary.str();
+}
+
+void Instrumentation::writeChromeTrace(const std::filesystem::path& path) {
+    nlohmann::json events = nlohmann::json::array();
+    uint64_t droppedEvents = 0;
+    {
+        Recording& recording = getRecording();
+        std::lock_guard<std::mutex> lock(recording.mutex);
+
+        int64_t end = 0;
+        for (const TraceEvent& event : recording.events) {
+            nlohmann::json json;
+            json["name"] = event.name;
+            json["ph"] = "X"; // complete event with duration
+            json["ts"] = event.start;
+            json["dur"] = event.duration;
+            json["pid"] = 1;
+            json["tid"] = event.thread;
+            if (!event.arguments.empty()) {
+                json["args"] = nlohmann::json::object();
+                for (const auto& [name, value] : event.arguments) {
+                    json["args"][name] = value;
+                }
+            }
+            events.push_back(json);
+            end = std::max(end, event.start + event.duration);
+        }
+
+        // counters are shown with their final value at the end of the trace
+        for (const auto& [name, value] : recording.counters) {
+            nlohmann::json json;
+            json["name"] = name;
+            json["ph"] = "C";
+            json["ts"] = end;
+            json["pid"] = 1;
+            json["args"] = {{"value", value}};
+            events.push_back(json);
+        }
+        droppedEvents = recording.droppedEvents;
+    }
+
+    nlohmann::json trace;
+    trace["traceEvents"] = events;
+    trace["displayTimeUnit"] = "ms";
+    if (droppedEvents > 0) {
+        trace["otherData"]["dropped_events"] = droppedEvents;
+    }
+
+    std::fstream fp(path, std::fstream::out | std::fstream::binary);
+    if (fp.fail()) {
+        std::stringstream errorText;
+        errorText << "Could not open file \"" << path.native() << "\" for writing. Aborting...";
+        throw std::runtime_error(errorText.str());
+    }
+    fp << trace.dump(1);
+    fp.close();
+    if (fp.fail()) {
+        std::stringstream errorText;
+        errorText << "Could not write file \"" << path.native() << "\". Aborting...";
+        throw std::runtime_error(errorText.str());
+    }
+}
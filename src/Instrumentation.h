@@ -0,0 +1,95 @@
+/*
+ * Instrumentation.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef INSTRUMENTATION_H_
+#define INSTRUMENTATION_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+#include <filesystem>
+
+/*! \brief Collects timings and counters of the stages of a texture font build
+ *
+ *  Instrumentation is disabled by default. While disabled every timer and
+ *  counter only checks a flag, so it can stay in the code permanently.
+ *  All methods are thread safe.
+ *
+ *  The results can be exported as Chrome trace event JSON (to be opened
+ *  with chrome://tracing or Perfetto) or as a summary table. The summary
+ *  contains all timings, the trace only the first million, so long running
+ *  processes like the server do not grow without bound.
+ */
+class Instrumentation {
+public:
+    static void setEnabled(bool enabled);
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    /*! \brief adds a value to a counter */
+    static void addCount(const char* name, int64_t value = 1) {
+        if (isEnabled()) {
+            recordCount(name, value);
+        }
+    }
+
+    /*! \brief removes all recorded timings and counters */
+    static void reset();
+
+    /*! \brief returns a table of all timers (calls, total, mean and maximum time) and counters */
+    static std::string getSummary();
+
+    /*! \brief writes all recorded timings and counters as Chrome trace event JSON */
+    static void writeChromeTrace(const std::filesystem::path& path);
+
+private:
+    friend class ScopedTimer;
+
+    static void recordCount(const char* name, int64_t value);
+    static void recordEvent(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end,
+                            const std::vector<std::pair<const char*, int64_t>>& arguments);
+
+    static std::atomic<bool> s_enabled;
+};
+
+/*! \brief Measures the time until the end of the scope
+ *
+ *  The name has to be a string literal, it is stored as pointer.
+ */
+class ScopedTimer {
+public:
+    ScopedTimer(const char* name) : m_name(name), m_enabled(Instrumentation::isEnabled()) {
+        if (m_enabled) {
+            m_start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~ScopedTimer() {
+        if (m_enabled) {
+            Instrumentation::recordEvent(m_name, m_start, std::chrono::steady_clock::now(), m_arguments);
+        }
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    /*! \brief attaches a value to the timing, shown as argument in the trace */
+    void setArgument(const char* name, int64_t value) {
+        if (m_enabled) {
+            m_arguments.push_back({name, value});
+        }
+    }
+
+private:
+    const char* m_name;
+    bool m_enabled;
+    std::chrono::steady_clock::time_point m_start;
+    std::vector<std::pair<const char*, int64_t>> m_arguments;
+};
+
+#endif /* INSTRUMENTATION_H_ */
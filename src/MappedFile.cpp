@@ -0,0 +1,70 @@
+/*
+ * MappedFile.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "MappedFile.h"
+
+#include <cerrno>
+#include <sstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*! \brief throws the exception for a file that could not be read */
+[[noreturn]] static void throwReadError(const std::filesystem::path& path) {
+    std::stringstream errorText;
+    errorText << "File \"" << path.native() << "\" could not be read.";
+    throw std::runtime_error(errorText.str());
+}
+
+MappedFile::MappedFile(const std::filesystem::path& path, bool copy) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throwReadError(path);
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+        close(fd);
+        throwReadError(path);
+    }
+    m_size = fileStat.st_size;
+
+    if (copy) {
+        // a file shrinking while it is read is an error, growing is noticed by the next copy
+        m_copy.resize(m_size);
+        size_t offset = 0;
+        while (offset < m_size) {
+            ssize_t length = read(fd, m_copy.data() + offset, m_size - offset);
+            if (length < 0 && errno == EINTR) {
+                continue;
+            }
+            if (length <= 0) {
+                close(fd);
+                throwReadError(path);
+            }
+            offset += length;
+        }
+        close(fd);
+        m_data = m_copy.data();
+        return;
+    }
+
+    m_data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping stays valid after closing the file
+
+    if (m_data == MAP_FAILED) {
+        throwReadError(path);
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (m_copy.empty()) {
+        munmap(m_data, m_size);
+    }
+}
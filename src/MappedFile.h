@@ -0,0 +1,44 @@
+/*
+ * MappedFile.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef MAPPEDFILE_H_
+#define MAPPEDFILE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <filesystem>
+#include <vector>
+
+/*! \brief read only memory mapping of a whole file
+ *
+ *  The pages of the file are only read when they are accessed, so mapping
+ *  a large file is cheap if only parts of it are used. Accessing a page
+ *  of a mapped file truncated by another process raises SIGBUS, processes
+ *  running for a long time copy the file instead.
+ */
+class MappedFile {
+public:
+    /*! \brief Constructor
+     *
+     *  \param copy read the whole file into memory instead of mapping it, the
+     *         data then stays valid when the file is changed
+     */
+    MappedFile(const std::filesystem::path& path, bool copy = false);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* getData() { return static_cast<const uint8_t*>(m_data); }
+    size_t getSize() { return m_size; }
+
+private:
+    void* m_data;
+    size_t m_size;
+    std::vector<uint8_t> m_copy; //!< content of the file if it was copied, empty if it is mapped
+};
+
+#endif /* MAPPEDFILE_H_ */
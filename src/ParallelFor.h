@@ -0,0 +1,48 @@
+/*
+ * ParallelFor.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef PARALLELFOR_H_
+#define PARALLELFOR_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+
+/*! \brief runs function(index) for all indices from 0 to count - 1 on several threads
+ *
+ *  \param count number of indices
+ *  \param threads maximum number of threads to use, 0 uses all cores
+ *  \param function the function to run, exceptions are passed to the caller
+ */
+template <typename Function>
+void parallelFor(size_t count, uint32_t threads, Function function) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::min<size_t>(threads, count);
+
+    std::atomic<size_t> nextIndex(0);
+    auto worker = [&]() {
+        for (size_t index = nextIndex++; index < count; index = nextIndex++) {
+            function(index);
+        }
+    };
+
+    std::vector<std::future<void>> futures;
+    for (uint32_t thread = 1; thread < threads; thread++) {
+        futures.push_back(std::async(std::launch::async, worker));
+    }
+    worker();
+    for (std::future<void>& future : futures) {
+        future.get(); // rethrows exceptions of the workers
+    }
+}
+
+#endif /* PARALLELFOR_H_ */
@@ -0,0 +1,396 @@
+/*
+ * PngEncoder.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "PngEncoder.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <zlib.h>
+
+#include "ParallelFor.h"
+#include "Instrumentation.h"
+
+/*! \brief appends a 32bit big endian value to a buffer */
+static void appendBigEndian(std::vector<uint8_t>& buffer, uint32_t value) {
+    buffer.push_back(value >> 24);
+    buffer.push_back(value >> 16);
+    buffer.push_back(value >> 8);
+    buffer.push_back(value);
+}
+
+/*! \brief appends a PNG chunk including length and checksum to a buffer */
+static void appendChunk(std::vector<uint8_t>& buffer, const char* type, const uint8_t* data, size_t size) {
+    appendBigEndian(buffer, size);
+
+    size_t typePos = buffer.size();
+    buffer.insert(buffer.end(), type, type + 4);
+    buffer.insert(buffer.end(), data, data + size);
+
+    // the checksum covers the type and the data of the chunk
+    uint32_t crc = crc32(0, buffer.data() + typePos, size + 4);
+    appendBigEndian(buffer, crc);
+}
+
+static const size_t CHUNK_SIZE = 256 * 1024; //!< size of the filtered image data compressed by a single task
+static const size_t WINDOW_SIZE = 32768; //!< size of the deflate window
+
+/*! \brief Paeth predictor as defined by the PNG specification */
+static inline uint8_t paethPredictor(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = abs(p - a);
+    int pb = abs(p - b);
+    int pc = abs(p - c);
+    if (pa <= pb && pa <= pc) {
+        return a;
+    }
+    return (pb <= pc) ? b : c;
+}
+
+/*! \brief sum of the filtered bytes interpreted as signed values, used to select a filter */
+static uint32_t filterCost(const uint8_t* data, size_t length) {
+    uint32_t cost = 0;
+    for (size_t i = 0; i < length; i++) {
+        cost += abs(static_cast<int8_t>(data[i]));
+    }
+    return cost;
+}
+
+/*! \brief filters a single row
+ *
+ *  The filters None, Sub, Up and Paeth are tried and the one with the lowest
+ *  cost is used. The filter type is stored in the first byte of the output.
+ *
+ *  \param row the row to filter
+ *  \param previous the previous row or nullptr for the first row
+ *  \param output buffer receiving the filter type and length filtered bytes
+ *  \param candidate scratch buffer of length bytes
+ */
+static void filterRow(const uint8_t* row, const uint8_t* previous, size_t length, uint32_t bpp, uint8_t* output, uint8_t* candidate) {
+    output[0] = 0;
+    memcpy(output + 1, row, length);
+    uint32_t bestCost = filterCost(output + 1, length);
+
+    for (uint8_t filter : {1, 2, 4}) {
+        size_t first = std::min<size_t>(bpp, length);
+        switch (filter) {
+            case 1: // Sub
+                memcpy(candidate, row, first);
+                for (size_t i = first; i < length; i++) {
+                    candidate[i] = row[i] - row[i - bpp];
+                }
+                break;
+            case 2: // Up
+                if (!previous) {
+                    continue; // same as None
+                }
+                for (size_t i = 0; i < length; i++) {
+                    candidate[i] = row[i] - previous[i];
+                }
+                break;
+            case 4: // Paeth
+                if (!previous) {
+                    continue; // same as Sub
+                }
+                for (size_t i = 0; i < first; i++) {
+                    candidate[i] = row[i] - previous[i];
+                }
+                for (size_t i = first; i < length; i++) {
+                    candidate[i] = row[i] - paethPredictor(row[i - bpp], previous[i], previous[i - bpp]);
+                }
+                break;
+        }
+
+        uint32_t cost = filterCost(candidate, length);
+        if (cost < bestCost) {
+            bestCost = cost;
+            output[0] = filter;
+            memcpy(output + 1, candidate, length);
+        }
+    }
+}
+
+/*! \brief compresses a chunk into a raw deflate stream
+ *
+ *  Chunks other than the last one are ended with a sync flush, so the
+ *  streams of all chunks can be concatenated. The preceding data is used
+ *  as dictionary to keep the compression ratio close to a single stream.
+ */
+static std::vector<uint8_t> deflateChunk(const uint8_t* data, size_t length, const uint8_t* dictionary, size_t dictionaryLength, int level, bool last) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(&stream, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw std::runtime_error("Could not initialize PNG compression.");
+    }
+
+    if (dictionaryLength > 0) {
+        deflateSetDictionary(&stream, dictionary, dictionaryLength);
+    }
+
+    std::vector<uint8_t> output(deflateBound(&stream, length) + 16);
+    stream.next_in = const_cast<uint8_t*>(data);
+    stream.avail_in = length;
+
+    int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+    int result;
+    do {
+        if (stream.total_out == output.size()) {
+            output.resize(output.size() * 2);
+        }
+        stream.next_out = output.data() + stream.total_out;
+        stream.avail_out = output.size() - stream.total_out;
+        result = deflate(&stream, flush);
+    } while (result != Z_STREAM_ERROR && (stream.avail_out == 0 || (last && result != Z_STREAM_END)));
+
+    if (result == Z_STREAM_ERROR) {
+        deflateEnd(&stream);
+        throw std::runtime_error("Could not compress PNG image data.");
+    }
+
+    output.resize(stream.total_out);
+    deflateEnd(&stream);
+    return output;
+}
+
+/*! \brief encodes interleaved 8bit image data as PNG
+ *
+ *  \param getRow function returning a pointer to the pixels of a row
+ */
+template <typename RowFunction>
+static std::vector<uint8_t> encodePngRows(uint32_t width, uint32_t height, uint32_t channels, RowFunction getRow, const PngOptions& options) {
+    ScopedTimer timer("encode PNG");
+    uint8_t colorType;
+    switch (channels) {
+        case 1: colorType = 0; break; // grayscale
+        case 3: colorType = 2; break; // RGB
+        case 4: colorType = 6; break; // RGBA
+        default:
+            std::stringstream errorText;
+            errorText << "PNG images with " << channels << " channels are not supported.";
+            throw std::runtime_error(errorText.str());
+    }
+
+    int level = std::clamp(options.compressionLevel, 0, 9);
+
+    // every row is preceded by its filter type
+    size_t rowLength = static_cast<size_t>(width) * channels;
+    size_t filteredRowLength = rowLength + 1;
+    std::vector<uint8_t> filtered(filteredRowLength * height);
+
+    size_t rowsPerChunk = std::max<size_t>(1, CHUNK_SIZE / filteredRowLength);
+    size_t chunks = std::max<size_t>(1, (height + rowsPerChunk - 1) / rowsPerChunk);
+
+    // filtering only depends on the unfiltered image, so all rows can be filtered in parallel
+    parallelFor(chunks, options.threads, [&](size_t chunk) {
+        std::vector<uint8_t> candidate(rowLength);
+        size_t lastRow = std::min<size_t>(height, (chunk + 1) * rowsPerChunk);
+        for (size_t row = chunk * rowsPerChunk; row < lastRow; row++) {
+            uint8_t* output = filtered.data() + row * filteredRowLength;
+            if (level == 0) {
+                // filtering does not help if the data is not compressed
+                output[0] = 0;
+                memcpy(output + 1, getRow(row), rowLength);
+            } else {
+                filterRow(getRow(row), (row > 0) ? getRow(row - 1) : nullptr, rowLength, channels, output, candidate.data());
+            }
+        }
+    });
+
+    std::vector<std::vector<uint8_t>> compressedChunks(chunks);
+    std::vector<uLong> checksums(chunks);
+    parallelFor(chunks, options.threads, [&](size_t chunk) {
+        size_t begin = chunk * rowsPerChunk * filteredRowLength;
+        size_t end = std::min(filtered.size(), (chunk + 1) * rowsPerChunk * filteredRowLength);
+        size_t dictionaryLength = std::min(begin, WINDOW_SIZE);
+
+        compressedChunks[chunk] = deflateChunk(filtered.data() + begin, end - begin,
+                                               filtered.data() + begin - dictionaryLength, dictionaryLength,
+                                               level, chunk + 1 == chunks);
+        checksums[chunk] = adler32(adler32(0, nullptr, 0), filtered.data() + begin, end - begin);
+    });
+
+    // zlib header, see RFC 1950
+    std::vector<uint8_t> zlibData;
+    uint8_t cmf = 0x78; // deflate with 32K window
+    uint8_t flevel = (level < 2) ? 0 : (level < 6) ? 1 : (level == 6) ? 2 : 3;
+    uint8_t flg = flevel << 6;
+    flg += (31 - ((cmf << 8) | flg) % 31) % 31;
+    zlibData.push_back(cmf);
+    zlibData.push_back(flg);
+
+    uLong checksum = adler32(0, nullptr, 0);
+    for (size_t chunk = 0; chunk < chunks; chunk++) {
+        zlibData.insert(zlibData.end(), compressedChunks[chunk].begin(), compressedChunks[chunk].end());
+
+        size_t chunkLength = std::min(filtered.size() - chunk * rowsPerChunk * filteredRowLength, rowsPerChunk * filteredRowLength);
+        checksum = adler32_combine(checksum, checksums[chunk], chunkLength);
+    }
+    appendBigEndian(zlibData, checksum);
+
+    std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+
+    std::vector<uint8_t> header;
+    appendBigEndian(header, width);
+    appendBigEndian(header, height);
+    header.push_back(8); // bit depth
+    header.push_back(colorType);
+    header.push_back(0); // compression method
+    header.push_back(0); // filter method
+    header.push_back(0); // interlace method
+
+    appendChunk(png, "IHDR", header.data(), header.size());
+    appendChunk(png, "IDAT", zlibData.data(), zlibData.size());
+    appendChunk(png, "IEND", nullptr, 0);
+
+    return png;
+}
+
+std::vector<uint8_t> encodePng(GrayImage& image, const PngOptions& options) {
+    return encodePngRows(image.getWidth(), image.getHeight(), 1, [&image](uint32_t row) { return image.getRow(row); }, options);
+}
+
+std::vector<uint8_t> encodePng(ColorImage& image, const PngOptions& options) {
+    return encodePngRows(image.getWidth(), image.getHeight(), image.getChannels(), [&image](uint32_t row) { return image.getRow(row); }, options);
+}
+
+/*! \brief reads a 32bit big endian value */
+static uint32_t readBigEndian(const uint8_t* data) {
+    return (static_cast<uint32_t>(data[0]) << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+}
+
+/*! \brief reverses the filter of a row, see filterRow() */
+static void unfilterRow(uint8_t filter, uint8_t* row, const uint8_t* previous, size_t length, uint32_t bpp) {
+    for (size_t i = 0; i < length; i++) {
+        int a = (i >= bpp) ? row[i - bpp] : 0;
+        int b = previous ? previous[i] : 0;
+        int c = (previous && i >= bpp) ? previous[i - bpp] : 0;
+        switch (filter) {
+            case 0: break;
+            case 1: row[i] += a; break;
+            case 2: row[i] += b; break;
+            case 3: row[i] += (a + b) / 2; break;
+            case 4: row[i] += paethPredictor(a, b, c); break;
+            default:
+                throw std::runtime_error("PNG image contains an invalid filter type.");
+        }
+    }
+}
+
+std::shared_ptr<ColorImage> decodePng(const uint8_t* data, size_t size) {
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    if (size < sizeof(signature) || memcmp(data, signature, sizeof(signature)) != 0) {
+        throw std::runtime_error("Data is not a PNG image.");
+    }
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t channels = 0;
+    std::vector<uint8_t> zlibData;
+    bool end = false;
+
+    size_t pos = sizeof(signature);
+    while (!end) {
+        // every chunk consists of length, type, data and checksum
+        if (size - pos < 12) {
+            throw std::runtime_error("PNG image is truncated.");
+        }
+        uint32_t length = readBigEndian(data + pos);
+        if (length > size - pos - 12) {
+            throw std::runtime_error("PNG image is truncated.");
+        }
+        const uint8_t* type = data + pos + 4;
+        const uint8_t* chunk = data + pos + 8;
+        if (crc32(0, type, length + 4) != readBigEndian(chunk + length)) {
+            throw std::runtime_error("PNG image contains a chunk with wrong checksum.");
+        }
+
+        if (memcmp(type, "IHDR", 4) == 0) {
+            if (length != 13) {
+                throw std::runtime_error("PNG image contains an invalid header.");
+            }
+            width = readBigEndian(chunk);
+            height = readBigEndian(chunk + 4);
+            uint8_t bitDepth = chunk[8];
+            uint8_t colorType = chunk[9];
+            uint8_t interlace = chunk[12];
+            switch (colorType) {
+                case 0: channels = 1; break;
+                case 2: channels = 3; break;
+                case 6: channels = 4; break;
+                default: channels = 0; break;
+            }
+            if (bitDepth != 8 || channels == 0 || interlace != 0 || chunk[10] != 0 || chunk[11] != 0) {
+                throw std::runtime_error("Only 8bit grayscale, RGB and RGBA PNG images without interlacing are supported.");
+            }
+        } else if (memcmp(type, "IDAT", 4) == 0) {
+            zlibData.insert(zlibData.end(), chunk, chunk + length);
+        } else if (memcmp(type, "IEND", 4) == 0) {
+            end = true;
+        } else if (!(type[0] & 0x20)) {
+            throw std::runtime_error("PNG image contains an unsupported critical chunk.");
+        }
+
+        pos += length + 12;
+    }
+
+    if (channels == 0) {
+        throw std::runtime_error("PNG image has no header.");
+    }
+
+    // the size of the filtered data is known, so it is inflated in a single call.
+    // deflate compresses by at most 1032:1, larger sizes cannot be valid
+    size_t rowLength = static_cast<size_t>(width) * channels;
+    size_t maximumSize = zlibData.size() * 1032 + 1024;
+    if (rowLength + 1 > maximumSize || (height > 0 && (rowLength + 1) > maximumSize / height)) {
+        throw std::runtime_error("PNG image contains invalid image data.");
+    }
+    std::vector<uint8_t> filtered((rowLength + 1) * height);
+    uLongf filteredSize = filtered.size();
+    if (uncompress(filtered.data(), &filteredSize, zlibData.data(), zlibData.size()) != Z_OK || filteredSize != filtered.size()) {
+        throw std::runtime_error("PNG image contains invalid image data.");
+    }
+
+    std::shared_ptr<ColorImage> image(new ColorImage(width, height, channels));
+    for (uint32_t row = 0; row < height; row++) {
+        uint8_t* line = image->getRow(row);
+        memcpy(line, filtered.data() + row * (rowLength + 1) + 1, rowLength);
+        unfilterRow(filtered[row * (rowLength + 1)], line, (row > 0) ? image->getRow(row - 1) : nullptr, rowLength, channels);
+    }
+
+    return image;
+}
+
+/*! \brief writes a buffer to a file */
+static void writeBuffer(const std::filesystem::path& path, const std::vector<uint8_t>& buffer) {
+    std::fstream fp(path, std::fstream::out | std::fstream::binary);
+    if (fp.fail()) {
+        std::stringstream errorText;
+        errorText << "Could not open file \"" << path.native() << "\" for writing. Aborting...";
+        throw std::runtime_error(errorText.str());
+    }
+
+    fp.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+    fp.close();
+    if (fp.fail()) {
+        std::stringstream errorText;
+        errorText << "Could not write file \"" << path.native() << "\". Aborting...";
+        throw std::runtime_error(errorText.str());
+    }
+    Instrumentation::addCount("bytes written", buffer.size());
+}
+
+void writePngFile(const std::filesystem::path& path, GrayImage& image, const PngOptions& options) {
+    writeBuffer(path, encodePng(image, options));
+}
+
+void writePngFile(const std::filesystem::path& path, ColorImage& image, const PngOptions& options) {
+    writeBuffer(path, encodePng(image, options));
+}
@@ -0,0 +1,59 @@
+/*
+ * PngEncoder.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef PNGENCODER_H_
+#define PNGENCODER_H_
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+#include <filesystem>
+
+#include "GrayImage.h"
+#include "ColorImage.h"
+
+/*! \brief Options for encoding PNG images */
+struct PngOptions {
+    int compressionLevel = 6; //!< zlib compression level from 0 (none) to 9 (best)
+
+    /*! \brief number of threads used for compression, 0 uses all cores
+     *
+     *  The image data is split into chunks that are compressed independently
+     *  (like pigz does) and concatenated into a single zlib stream. The
+     *  resulting file does not depend on the number of threads.
+     */
+    uint32_t threads = 0;
+};
+
+/*! \brief encodes an image as PNG file
+ *
+ *  Grayscale images are stored as 8bit grayscale PNG, color images as 8bit
+ *  RGB (three channels) or RGBA (four channels) PNG.
+ *
+ *  \param image the image to encode
+ *  \param options compression options
+ *  \return the content of the PNG file
+ */
+std::vector<uint8_t> encodePng(GrayImage& image, const PngOptions& options = PngOptions());
+std::vector<uint8_t> encodePng(ColorImage& image, const PngOptions& options = PngOptions());
+
+/*! \brief decodes a PNG file
+ *
+ *  Only the subset of PNG written by encodePng() is supported: 8bit
+ *  grayscale, RGB and RGBA images without interlacing. Throws an exception
+ *  for other or malformed files.
+ *
+ *  \param data the content of the PNG file
+ *  \param size size of the PNG file in bytes
+ *  \return the image, grayscale images have a single channel
+ */
+std::shared_ptr<ColorImage> decodePng(const uint8_t* data, size_t size);
+
+/*! \brief writes an image to a PNG file */
+void writePngFile(const std::filesystem::path& path, GrayImage& image, const PngOptions& options = PngOptions());
+void writePngFile(const std::filesystem::path& path, ColorImage& image, const PngOptions& options = PngOptions());
+
+#endif /* PNGENCODER_H_ */
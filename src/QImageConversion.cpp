@@ -0,0 +1,46 @@
+/*
+ * QImageConversion.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "QImageConversion.h"
+
+std::shared_ptr<QImage> toQImage(GrayImage& source, uint8_t red, uint8_t green, uint8_t blue) {
+    std::shared_ptr<QImage> image(new QImage(QSize(source.getWidth(), source.getHeight()), QImage::Format_ARGB32));
+
+    for (uint32_t y = 0; y < source.getHeight(); y++) {
+        uint32_t* line = reinterpret_cast<uint32_t*>(image->scanLine(y));
+        uint8_t* sourceLine = source.getRow(y);
+        for (uint32_t x = 0; x < source.getWidth(); x++) {
+            uint32_t color = qRgb(sourceLine[x] * (double) red   / 255.0,
+                                  sourceLine[x] * (double) green / 255.0,
+                                  sourceLine[x] * (double) blue  / 255.0);
+            line[x] = color;
+        }
+    }
+
+    return image;
+}
+
+std::shared_ptr<QImage> toQImage(ColorImage& source) {
+    std::shared_ptr<QImage> image(new QImage(QSize(source.getWidth(), source.getHeight()), QImage::Format_ARGB32));
+
+    uint32_t channels = source.getChannels();
+    for (uint32_t y = 0; y < source.getHeight(); y++) {
+        uint32_t* line = reinterpret_cast<uint32_t*>(image->scanLine(y));
+        uint8_t* sourceLine = source.getRow(y);
+        for (uint32_t x = 0; x < source.getWidth(); x++) {
+            uint8_t* pixel = sourceLine + x * channels;
+            if (channels >= 4) {
+                line[x] = qRgba(pixel[0], pixel[1], pixel[2], pixel[3]);
+            } else if (channels == 3) {
+                line[x] = qRgb(pixel[0], pixel[1], pixel[2]);
+            } else {
+                line[x] = qRgb(pixel[0], pixel[0], pixel[0]);
+            }
+        }
+    }
+
+    return image;
+}
@@ -0,0 +1,25 @@
+/*
+ * QImageConversion.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef QIMAGECONVERSION_H_
+#define QIMAGECONVERSION_H_
+
+#include <QImage>
+#include <memory>
+
+#include "GrayImage.h"
+#include "ColorImage.h"
+
+/*! \brief converts a grayscale image to a QImage
+ *
+ *  The gray values are used as intensity of the given color.
+ */
+std::shared_ptr<QImage> toQImage(GrayImage& source, uint8_t red = 255, uint8_t green = 255, uint8_t blue = 255);
+
+/*! \brief converts an RGB or RGBA image to a QImage */
+std::shared_ptr<QImage> toQImage(ColorImage& source);
+
+#endif /* QIMAGECONVERSION_H_ */
@@ -0,0 +1,130 @@
+/*
+ * TaskScheduler.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "TaskScheduler.h"
+
+#include <algorithm>
+
+namespace { // anonymous namespace
+
+// identifies the scheduler and queue of the current worker thread
+thread_local const TaskScheduler* currentScheduler = nullptr;
+thread_local uint32_t currentQueue = 0;
+
+} // anonymous namespace
+
+TaskScheduler::TaskScheduler(uint32_t threads) :
+    m_queuedTasks(0),
+    m_unfinishedTasks(0),
+    m_nextQueue(0),
+    m_stopping(false)
+{
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (uint32_t i = 0; i < threads; i++) {
+        m_queues.push_back(std::make_unique<Queue>());
+    }
+    for (uint32_t i = 0; i < threads; i++) {
+        m_threads.emplace_back(&TaskScheduler::workerLoop, this, i);
+    }
+}
+
+TaskScheduler::~TaskScheduler() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        m_taskQueued.notify_all();
+    }
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void TaskScheduler::submit(std::function<void()> task) {
+    uint32_t queue;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (currentScheduler == this) {
+            queue = currentQueue;
+        } else {
+            queue = m_nextQueue;
+            m_nextQueue = (m_nextQueue + 1) % m_queues.size();
+        }
+        m_unfinishedTasks++;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_queues[queue]->mutex);
+        m_queues[queue]->tasks.push_back(std::move(task));
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_queuedTasks++;
+    m_taskQueued.notify_one();
+}
+
+void TaskScheduler::wait() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_tasksFinished.wait(lock, [this]() { return m_unfinishedTasks == 0; });
+}
+
+bool TaskScheduler::takeTask(uint32_t index, std::function<void()>& task) {
+    // newest task of the own queue first, it is likely to use data still in the cache
+    {
+        Queue& own = *m_queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // otherwise the oldest task of another queue
+    for (uint32_t offset = 1; offset < m_queues.size(); offset++) {
+        Queue& other = *m_queues[(index + offset) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(other.mutex);
+        if (!other.tasks.empty()) {
+            task = std::move(other.tasks.front());
+            other.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskScheduler::workerLoop(uint32_t index) {
+    currentScheduler = this;
+    currentQueue = index;
+
+    while (true) {
+        {
+            // reserve a task, tasks are counted after they were added to a queue
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_taskQueued.wait(lock, [this]() { return m_queuedTasks > 0 || m_stopping; });
+            if (m_queuedTasks == 0) {
+                return;
+            }
+            m_queuedTasks--;
+        }
+
+        // the reserved task is in one of the queues, though not necessarily in the one checked first
+        std::function<void()> task;
+        while (!takeTask(index, task)) {
+            std::this_thread::yield();
+        }
+
+        task();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_unfinishedTasks--;
+        if (m_unfinishedTasks == 0) {
+            m_tasksFinished.notify_all();
+        }
+    }
+}
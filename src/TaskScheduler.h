@@ -0,0 +1,72 @@
+/*
+ * TaskScheduler.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef TASKSCHEDULER_H_
+#define TASKSCHEDULER_H_
+
+#include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*! \brief Runs tasks on a pool of threads using work stealing
+ *
+ *  Every thread has its own queue. Tasks submitted by a task are put into
+ *  the queue of its thread and run there next, tasks submitted from outside
+ *  are distributed over all queues. Threads with an empty queue take the
+ *  oldest task of another queue, so no thread idles while work is left.
+ *
+ *  Tasks must not throw exceptions.
+ */
+class TaskScheduler {
+public:
+    /*! \brief Constructor
+     *
+     *  \param threads number of threads, 0 uses all cores
+     */
+    TaskScheduler(uint32_t threads = 0);
+
+    /*! \brief waits for all tasks to finish */
+    virtual ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    void submit(std::function<void()> task);
+
+    /*! \brief blocks until all submitted tasks, including tasks submitted by them, are finished */
+    void wait();
+
+    uint32_t getThreadCount() { return m_threads.size(); }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void workerLoop(uint32_t index);
+
+    /*! \brief takes a task from the own queue or steals one, returns false if all queues are empty */
+    bool takeTask(uint32_t index, std::function<void()>& task);
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_taskQueued; //!< signaled when a task was queued or the scheduler stops
+    std::condition_variable m_tasksFinished; //!< signaled when no unfinished tasks are left
+    uint64_t m_queuedTasks; //!< tasks waiting in any queue
+    uint64_t m_unfinishedTasks; //!< tasks submitted but not finished
+    uint32_t m_nextQueue; //!< queue receiving the next task submitted from outside
+    bool m_stopping;
+};
+
+#endif /* TASKSCHEDULER_H_ */
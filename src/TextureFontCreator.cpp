@@ -8,15 +8,21 @@
 #include "TextureFontCreator.h"
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <set>
 #include <sstream>
 #include <filesystem>
-#include <iconv.h>
+#include <future>
+#include <chrono>
 
 #include <nlohmann/json.hpp>
-#include <QBuffer>
+
+#include "PngEncoder.h"
+#include "Instrumentation.h"
+#include "AtlasPacker.h"
+#include "TextureFontReader.h"
 
 
 
@@ -72,31 +78,52 @@ private:
 
 
 
-static std::u32string toU32String(const std::u8string& str) {
+/*! \brief decodes the UTF-8 sequence at pos and advances pos to the next sequence */
+static char32_t decodeUtf8(const std::u8string& str, size_t& i) {
+    char32_t ch = 0;
+    uint8_t byte = str.at(i);
+    if (byte < 0x80) {
+        ch = byte;
+        ++i;
+    } else if ((byte & 0xE0) == 0xC0) {
+        ch = ((byte & 0x1F) << 6) | (str.at(i + 1) & 0x3F);
+        i += 2;
+    } else if ((byte & 0xF0) == 0xE0) {
+        ch = ((byte & 0x0F) << 12) | ((str.at(i + 1) & 0x3F) << 6) | (str.at(i + 2) & 0x3F);
+        i += 3;
+    } else if ((byte & 0xF8) == 0xF0) {
+        ch = ((byte & 0x07) << 18) | ((str.at(i + 1) & 0x3F) << 12) | ((str.at(i + 2) & 0x3F) << 6) | (str.at(i + 3) & 0x3F);
+        i += 4;
+    } else {
+        throw std::runtime_error("Invalid UTF-8 sequence.");
+    }
+    return ch;
+}
+
+std::u32string toU32String(const std::u8string& str) {
     std::u32string result;
     for (size_t i = 0; i < str.size(); ) {
-        char32_t ch = 0;
-        uint8_t byte = str.at(i);
-        if (byte < 0x80) {
-            ch = byte;
-            ++i;
-        } else if ((byte & 0xE0) == 0xC0) {
-            ch = ((byte & 0x1F) << 6) | (str.at(i + 1) & 0x3F);
-            i += 2;
-        } else if ((byte & 0xF0) == 0xE0) {
-            ch = ((byte & 0x0F) << 12) | ((str.at(i + 1) & 0x3F) << 6) | (str.at(i + 2) & 0x3F);
-            i += 3;
-        } else if ((byte & 0xF8) == 0xF0) {
-            ch = ((byte & 0x07) << 18) | ((str.at(i + 1) & 0x3F) << 12) | ((str.at(i + 2) & 0x3F) << 6) | (str.at(i + 3) & 0x3F);
-            i += 4;
-        } else {
-            throw std::runtime_error("Invalid UTF-8 sequence.");
-        }
-        result.push_back(ch);
+        result.push_back(decodeUtf8(str, i));
     }
     return result;
 }
 
+/*! \brief key of a character in TextureFontCreator::m_characterIndex */
+static uint64_t characterKey(char32_t unicode, uint32_t variant, uint32_t phase) {
+    return (static_cast<uint64_t>(variant) << 40) | (static_cast<uint64_t>(phase) << 32) | unicode;
+}
+
+/*! \brief creates a font variant with the default values of all further settings */
+static FontVariant makeFontVariant(const std::filesystem::path& fontpath, double fontSize, const std::u8string& chars,
+                                   bool enableAntiAliasing, bool enableHinting) {
+    FontVariant variant;
+    variant.fontpath = fontpath;
+    variant.fontSize = fontSize;
+    variant.chars = chars;
+    variant.enableAntiAliasing = enableAntiAliasing;
+    variant.enableHinting = enableHinting;
+    return variant;
+}
 
 TextureFontCreator::TextureFontCreator(
     const std::filesystem::path& fontpath,
@@ -105,99 +132,491 @@ TextureFontCreator::TextureFontCreator(
     const std::u8string& chars,
     bool enableAntiAliasing,
     bool enableHinting)
+    : TextureFontCreator({makeFontVariant(fontpath, fontSize, chars, enableAntiAliasing, enableHinting)}, forcePowerOfTwoSize)
 {
+}
+
+/*! \brief Result of rendering all characters of a single font variant */
+struct RenderedVariant {
+    std::string fontName;
+    std::vector<std::string> faceNames;
+    std::vector<std::shared_ptr<ImageCharacter>> characters;
+    std::shared_ptr<FontSession> session; //!< the fonts of the variant, used again by the second pass of streaming
+};
 
-    FreeTypeRender renderer(fontpath, fontSize, enableAntiAliasing, enableHinting);
-    m_fontName = renderer.getFontName();
-  
-    std::u32string str = toU32String(chars);
+/*! \brief renders all characters of a variant, with streaming outlines are only measured */
+static RenderedVariant renderVariant(const FontVariant& variant, bool streaming) {
+    ScopedTimer timer("render variant");
 
-    // eliminate duplicates by putting the characters in a set
-    std::set<char32_t> characterSet;
-    for (int32_t pos = 0; pos < str.length(); pos++) {
-        characterSet.insert(str.at(pos));
+    std::shared_ptr<FontSession> session = variant.session;
+    if (!session) {
+        std::vector<std::filesystem::path> fontpaths = {variant.fontpath};
+        fontpaths.insert(fontpaths.end(), variant.fallbackFontpaths.begin(), variant.fallbackFontpaths.end());
+        session = std::make_shared<FontSession>(fontpaths, variant.faceIndex);
+    }
+
+    FreeTypeRender renderer(session, variant.fontSize, variant.enableAntiAliasing, variant.enableHinting, variant.enableLcdRendering, variant.variation);
+
+    RenderedVariant result;
+    result.fontName = renderer.getFontName();
+    for (uint32_t face = 0; face < renderer.getFaceCount(); face++) {
+        result.faceNames.push_back(renderer.getFaceName(face));
     }
 
+    std::u32string str = toU32String(variant.chars);
+
+    // eliminate duplicates by putting the characters in a set
+    std::set<char32_t> characterSet(str.begin(), str.end());
+
     for (char32_t unicode : characterSet) {
-        std::shared_ptr<ImageCharacter> imgChar = renderer.renderUnicodeCharacter(unicode);
-        ImageOffset imgOff;
-        imgOff.imgChar = imgChar;
-        m_imageCharacters.push_back(imgOff);
+        for (uint32_t phase = 0; phase < variant.subpixelPhases; phase++) {
+            std::shared_ptr<ImageCharacter> imgChar;
+            if (variant.glyphCache) {
+                imgChar = variant.glyphCache->find(variant, unicode, phase);
+            }
+            if (imgChar) {
+                Instrumentation::addCount("glyphs reused");
+            } else if (streaming) {
+                imgChar = renderer.measureUnicodeCharacter(unicode, phase, variant.subpixelPhases);
+            } else {
+                imgChar = renderer.renderUnicodeCharacter(unicode, phase, variant.subpixelPhases);
+            }
+            result.characters.push_back(imgChar);
+        }
+    }
+    result.session = session;
+    // streamed characters release their pixels, they must not end up in the cache
+    if (variant.glyphCache && !streaming) {
+        variant.glyphCache->assign(variant, result.characters);
     }
+    timer.setArgument("characters", result.characters.size());
 
-    stable_sort(m_imageCharacters.begin(), m_imageCharacters.end(), [](const ImageOffset& a, const ImageOffset& b) {
-        return (a.imgChar->image->getHeight() < b.imgChar->image->getHeight());
-    });
+    return result;
+}
+
+/*! \brief returns a copy of a character without its images, only the metrics are kept */
+static std::shared_ptr<ImageCharacter> releasePixels(const ImageCharacter& imgChar) {
+    std::shared_ptr<ImageCharacter> metrics(new ImageCharacter(imgChar));
+    metrics->image = nullptr;
+    metrics->colorImage = nullptr;
+    metrics->rgbaImage = nullptr;
+    return metrics;
+}
+
+/*! \brief returns the width of the extruded border of a character, characters without pixels have no border */
+static uint32_t getBorder(const ImageCharacter& imgChar, const AtlasOptions& options) {
+    if (imgChar.width == 0 || imgChar.height == 0) {
+        return 0;
+    }
+    return options.extrude;
+}
+
+/*! \brief places the characters in shelves into a square image
+ *
+ *  Sets the offsets of all characters. Every character occupies a cell of
+ *  its size plus its extruded border, cells are separated by the padding.
+ *
+ *  \param size width and height of the image
+ *  \return false if the characters do not fit into the image
+ */
+static bool packCharacters(std::vector<ImageOffset>& imageCharacters, uint32_t size, const AtlasOptions& options) {
+    ScopedTimer timer("pack");
+    timer.setArgument("size", size);
+    Instrumentation::addCount("packing attempts");
+
+    uint32_t top = 0;
+    uint32_t left = 0;
+    uint32_t max_height = 0;
+    for (ImageOffset& imgOff : imageCharacters) {
+        uint32_t border = getBorder(*imgOff.imgChar, options);
+        uint32_t cellWidth = imgOff.imgChar->width + 2 * border;
+        uint32_t cellHeight = imgOff.imgChar->height + 2 * border;
+
+        // a character wider than the image does not fit into any line
+        if (cellWidth >= size) {
+            timer.setArgument("fits", 0);
+            return false;
+        }
+
+        // now put imgOff.imgChar into image and increase top and/or left
+        if (cellWidth + left >= size) {
+            // image did not fit in line, use next line
+            top += max_height + options.padding;
+            left = 0;
+            max_height = 0;
+        }
+
+        if (cellHeight + top >= size) {
+            timer.setArgument("fits", 0);
+            return false;
+        }
+
+        imgOff.top = top + border;
+        imgOff.left = left + border;
 
+        left += cellWidth + options.padding;
+        if (cellHeight > max_height)
+            max_height = cellHeight;
+    }
+
+    timer.setArgument("fits", 1);
+    return true;
+}
+
+/*! \brief packs the characters into the smallest square image found
+ *
+ *  The size is searched by bisection with shelf packing, then a smaller
+ *  packing is searched if optimizePacking is set. The offsets of all
+ *  characters are set for the returned size rounded up to the size
+ *  alignment.
+ *
+ *  \return width and height of the image
+ */
+static uint32_t packAtlas(std::vector<ImageOffset>& imageCharacters, bool forcePowerOfTwoSize, const AtlasOptions& options) {
     Bisecter imageSize(forcePowerOfTwoSize);
 
     // determine required size
     while (!imageSize.isDone()) {
-        int32_t size = imageSize.getValue();
+        if (packCharacters(imageCharacters, imageSize.getValue(), options)) {
+            imageSize.bigEnough();
+        } else {
+            // image is too small to hold this font. We need to increase the texture size.
+            imageSize.notBigEnough();
+        }
+    }
 
-        int32_t top = 0;
-        int32_t left = 0;
-        uint32_t max_height = 0;
-        bool imageIsBigEnough = true;
-        for (ImageOffset& imgOff : m_imageCharacters) {
-            // now put imgOff.imgChar into image and increase top and/or left
-            if (imgOff.imgChar->image->getWidth() + left
-                    >= size) {
-                // image did not fit in line, use next line
-                top += max_height + 1;
-                left = 0;
-                max_height = 0;
-            }
+    // search a smaller packing than the shelves
+    uint32_t packedSize = imageSize.getValue();
+    bool optimized = false;
+    if (options.optimizePacking) {
+        std::vector<PackingRectangle> rectangles;
+        for (const ImageOffset& imgOff : imageCharacters) {
+            uint32_t border = getBorder(*imgOff.imgChar, options);
+            PackingRectangle rect;
+            rect.width = imgOff.imgChar->width + 2 * border;
+            rect.height = imgOff.imgChar->height + 2 * border;
+            rectangles.push_back(rect);
+        }
 
-            if (imgOff.imgChar->image->getHeight() + top
-                    >= size) {
-                // image is too small to hold this font. We need to increase the texture size.
-                imageSize.notBigEnough();
-                imageIsBigEnough = false;
-                break;
+        PackingResult result = optimizePacking(rectangles, options.padding, packedSize, forcePowerOfTwoSize,
+                                               std::chrono::milliseconds(options.optimizeTimeLimit));
+        if (result.size != 0 && result.size < packedSize) {
+            for (size_t i = 0; i < imageCharacters.size(); i++) {
+                uint32_t border = getBorder(*imageCharacters[i].imgChar, options);
+                imageCharacters[i].left = result.rectangles[i].left + border;
+                imageCharacters[i].top = result.rectangles[i].top + border;
             }
+            packedSize = result.size;
+            optimized = true;
+        }
+    }
 
-            imgOff.top = top;
-            imgOff.left = left;
+    uint32_t alignment = std::max(1u, options.sizeAlignment);
+    uint32_t size = (packedSize + alignment - 1) / alignment * alignment;
+    if (!optimized) {
+        packCharacters(imageCharacters, size, options);
+    }
+    return size;
+}
+
+TextureFontCreator::TextureFontCreator(
+    const std::vector<FontVariant>& variants,
+    bool forcePowerOfTwoSize,
+    const AtlasOptions& atlasOptions)
+    : m_atlasOptions(atlasOptions)
+{
+    if (variants.empty()) {
+        throw std::runtime_error("At least one font variant is required.");
+    }
+    for (const FontVariant& variant : variants) {
+        if (variant.subpixelPhases < 1 || variant.subpixelPhases > 64) {
+            throw std::runtime_error("The number of sub pixel phases has to be between 1 and 64.");
+        }
+    }
+    if (atlasOptions.padding > 0xffff || atlasOptions.extrude > 0xffff) {
+        throw std::runtime_error("Padding and extrusion must not exceed 65535 pixels.");
+    }
 
-            left += imgOff.imgChar->image->getWidth() + 1;
-            if (imgOff.imgChar->image->getHeight() > max_height)
-                max_height = imgOff.imgChar->image->getHeight();
+    // variants are rendered in parallel, variants sharing a font session
+    // synchronize on the lock of the session
+    std::vector<std::future<RenderedVariant>> futures;
+    for (const FontVariant& variant : variants) {
+        futures.push_back(std::async(std::launch::async, renderVariant, std::cref(variant), m_atlasOptions.streaming));
+    }
+    std::vector<std::shared_ptr<FontSession>> sessions;
+
+    for (uint32_t variantIndex = 0; variantIndex < futures.size(); variantIndex++) {
+        RenderedVariant rendered = futures[variantIndex].get();
+        const FontVariant& variant = variants[variantIndex];
+        sessions.push_back(rendered.session);
+
+        FontVariantInfo info;
+        info.fontName = rendered.fontName;
+        info.fontSize = variant.fontSize;
+        info.antiAliased = variant.enableAntiAliasing;
+        info.hinted = variant.enableHinting;
+        info.faceNames = rendered.faceNames;
+        info.subpixelPhases = variant.subpixelPhases;
+        info.lcd = variant.enableLcdRendering;
+        m_variants.push_back(info);
+
+        for (std::shared_ptr<ImageCharacter>& imgChar : rendered.characters) {
+            ImageOffset imgOff = {};
+            imgOff.imgChar = imgChar;
+            imgOff.variant = variantIndex;
+            m_imageCharacters.push_back(imgOff);
         }
+    }
 
-        if (imageIsBigEnough) {
-            imageSize.bigEnough();
+    m_fontName = m_variants.front().fontName;
+
+    stable_sort(m_imageCharacters.begin(), m_imageCharacters.end(), [](const ImageOffset& a, const ImageOffset& b) {
+        return (a.imgChar->height < b.imgChar->height);
+    });
+
+    // color glyphs are packed into a separate RGBA image
+    auto colorCharacters = std::stable_partition(m_imageCharacters.begin(), m_imageCharacters.end(), [](const ImageOffset& imgOff) {
+        return !imgOff.imgChar->rgbaImage;
+    });
+    std::vector<ImageOffset> colorPageCharacters(colorCharacters, m_imageCharacters.end());
+    m_imageCharacters.erase(colorCharacters, m_imageCharacters.end());
+
+    uint32_t size = packAtlas(m_imageCharacters, forcePowerOfTwoSize, m_atlasOptions);
+    m_image = std::shared_ptr<GrayImage> (new GrayImage(size, size));
+
+    bool lcd = std::any_of(m_variants.begin(), m_variants.end(), [](const FontVariantInfo& info) { return info.lcd; });
+    if (lcd) {
+        m_colorImage = std::shared_ptr<ColorImage>(new ColorImage(size, size, 3));
+    }
+
+    if (!colorPageCharacters.empty()) {
+        uint32_t pageSize = packAtlas(colorPageCharacters, forcePowerOfTwoSize, m_atlasOptions);
+        m_colorPage = std::shared_ptr<ColorImage>(new ColorImage(pageSize, pageSize, 4));
+        for (ImageOffset& imgOff : colorPageCharacters) {
+            imgOff.page = 1;
         }
+        m_imageCharacters.insert(m_imageCharacters.end(), colorPageCharacters.begin(), colorPageCharacters.end());
     }
 
     // create image with font
     {
-        m_image = std::shared_ptr<GrayImage> (new GrayImage(imageSize.getValue(), imageSize.getValue()));
-
-        int32_t top = 0;
-        int32_t left = 0;
-        uint32_t max_height = 0;
+        ScopedTimer timer("blit");
         for (ImageOffset& imgOff : m_imageCharacters) {
-            // now put imgOff.imgChar into image and increase top and/or left
-            if (imgOff.imgChar->image->getWidth() + left
-                    >= m_image->getWidth()) {
-                // image did not fit in line, use next line
-                top += max_height + 1;
-                left = 0;
-                max_height = 0;
+            if (!imgOff.imgChar->image) {
+                continue; // only measured, rendered by the second pass
+            }
+            blitCharacter(imgOff);
+            if (m_atlasOptions.streaming) {
+                imgOff.imgChar = releasePixels(*imgOff.imgChar);
             }
+        }
+    }
 
-            imgOff.top = top;
-            imgOff.left = left;
-            m_image->blit(*(imgOff.imgChar->image), left, top);
+    if (m_atlasOptions.streaming) {
+        ScopedTimer timer("stream");
+        // the variants write into disjoint cells of the image
+        std::vector<std::future<uint32_t>> streamed;
+        for (uint32_t variantIndex = 0; variantIndex < variants.size(); variantIndex++) {
+            streamed.push_back(std::async(std::launch::async, &TextureFontCreator::streamCharacters, this,
+                                          std::cref(variants[variantIndex]), sessions[variantIndex], variantIndex));
+        }
+        uint32_t grown = 0;
+        for (std::future<uint32_t>& future : streamed) {
+            grown += future.get();
+        }
+        if (grown > 0) {
+            Instrumentation::addCount("glyphs grown while streaming", grown);
+            repackImage(forcePowerOfTwoSize);
+        }
+    }
+
+    // create mip chain
+    ScopedTimer mipTimer("mip chain");
+    for (uint32_t level = 1; level != m_atlasOptions.mipLevels; level++) {
+        std::shared_ptr<GrayImage> previous = getMipLevel(level - 1);
+        if (previous->getWidth() == 1 && previous->getHeight() == 1) {
+            break;
+        }
+
+        m_mipLevels.push_back(previous->downsample());
+        if (m_colorImage) {
+            m_colorMipLevels.push_back(getColorMipLevel(level - 1)->downsample());
+        }
+    }
+    mipTimer.setArgument("levels", getMipLevelCount());
+
+    for (uint32_t index = 0; index < m_imageCharacters.size(); index++) {
+        const ImageOffset& imgOff = m_imageCharacters[index];
+        m_characterIndex.emplace(characterKey(imgOff.imgChar->unicode, imgOff.variant, imgOff.imgChar->phase), index);
+    }
+}
+
+void TextureFontCreator::blitCharacter(const ImageOffset& imgOff) {
+    ImageCharacter& imgChar = *imgOff.imgChar;
+    uint32_t border = getBorder(imgChar, m_atlasOptions);
+
+    // the border is only extruded into an image the character was copied into
+    auto throwBlitError = [&imgChar, &imgOff]() {
+        std::stringstream errorText;
+        errorText << "The character " << imgChar.unicode << " of size " << imgChar.width << "x" << imgChar.height
+                  << " does not fit into the image at " << imgOff.left << "," << imgOff.top << ".";
+        throw std::runtime_error(errorText.str());
+    };
+
+    if (imgOff.page == 1) {
+        if (!m_colorPage->blit(*(imgChar.rgbaImage), imgOff.left, imgOff.top)) {
+            throwBlitError();
+        }
+        m_colorPage->extrude(imgOff.left, imgOff.top, imgChar.width, imgChar.height, border);
+        return;
+    }
+
+    if (!m_image->blit(*(imgChar.image), imgOff.left, imgOff.top)) {
+        throwBlitError();
+    }
+    m_image->extrude(imgOff.left, imgOff.top, imgChar.width, imgChar.height, border);
+    if (m_colorImage) {
+        bool copied;
+        if (imgChar.colorImage) {
+            copied = m_colorImage->blit(*(imgChar.colorImage), imgOff.left, imgOff.top);
+        } else {
+            ColorImage colorCopy(*(imgChar.image), m_colorImage->getChannels());
+            copied = m_colorImage->blit(colorCopy, imgOff.left, imgOff.top);
+        }
+        if (!copied) {
+            throwBlitError();
+        }
+        m_colorImage->extrude(imgOff.left, imgOff.top, imgChar.width, imgChar.height, border);
+    }
+}
 
-            left += imgOff.imgChar->image->getWidth() + 1;
-            if (imgOff.imgChar->image->getHeight() > max_height)
-                max_height = imgOff.imgChar->image->getHeight();
+uint32_t TextureFontCreator::streamCharacters(const FontVariant& variant, std::shared_ptr<FontSession> session, uint32_t variantIndex) {
+    FreeTypeRender renderer(session, variant.fontSize, variant.enableAntiAliasing, variant.enableHinting, variant.enableLcdRendering, variant.variation);
+
+    uint32_t grown = 0;
+    for (ImageOffset& imgOff : m_imageCharacters) {
+        if (imgOff.variant != variantIndex || imgOff.imgChar->image || imgOff.page != 0) {
+            continue;
         }
+
+        // the trimmed character usually lies inside of the measured box it was packed with
+        const ImageCharacter& measured = *imgOff.imgChar;
+        std::shared_ptr<ImageCharacter> imgChar = renderer.renderUnicodeCharacter(measured.unicode, measured.phase, variant.subpixelPhases);
+        // color glyphs are rendered by the first pass, one showing up here is stored in the image like other characters
+        imgChar->rgbaImage = nullptr;
+        if (imgChar->width > 0 && imgChar->height > 0) {
+            int32_t offsetX = imgChar->bitmap_left - measured.bitmap_left;
+            int32_t offsetY = measured.bitmap_top - imgChar->bitmap_top;
+            if (offsetX < 0 || offsetY < 0 || offsetX + imgChar->width > measured.width || offsetY + imgChar->height > measured.height) {
+                imgOff.imgChar = imgChar;
+                grown++;
+                continue;
+            }
+            imgOff.left += offsetX;
+            imgOff.top += offsetY;
+        }
+
+        imgOff.imgChar = imgChar;
+        blitCharacter(imgOff);
+        imgOff.imgChar = releasePixels(*imgChar);
+        Instrumentation::addCount("glyphs streamed");
+    }
+    return grown;
+}
+
+/*! \brief copies the cell of a character including its extruded border between two images of the same format */
+template <typename Image>
+static void copyCell(Image& destination, const ImageOffset& to, Image& source, const ImageOffset& from, uint32_t border, uint32_t bytesPerPixel) {
+    const ImageCharacter& imgChar = *to.imgChar;
+    if (imgChar.width == 0 || imgChar.height == 0) {
+        return;
+    }
+    size_t rowLength = static_cast<size_t>(imgChar.width + 2 * border) * bytesPerPixel;
+    for (uint32_t row = 0; row < imgChar.height + 2 * border; row++) {
+        memcpy(destination.getRow(to.top - border + row) + static_cast<size_t>(to.left - border) * bytesPerPixel,
+               source.getRow(from.top - border + row) + static_cast<size_t>(from.left - border) * bytesPerPixel, rowLength);
     }
 }
 
+void TextureFontCreator::repackImage(bool forcePowerOfTwoSize) {
+    ScopedTimer timer("repack");
+
+    // the characters of the color page are stored after the characters of the image
+    auto colorCharacters = std::find_if(m_imageCharacters.begin(), m_imageCharacters.end(), [](const ImageOffset& imgOff) {
+        return imgOff.page == 1;
+    });
+    std::vector<ImageOffset> previous(m_imageCharacters.begin(), colorCharacters);
+    std::vector<ImageOffset> repacked = previous;
+    std::vector<uint32_t> order(repacked.size());
+    for (uint32_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&repacked](uint32_t a, uint32_t b) {
+        return repacked[a].imgChar->height < repacked[b].imgChar->height;
+    });
+    std::vector<ImageOffset> sorted;
+    for (uint32_t index : order) {
+        sorted.push_back(repacked[index]);
+    }
+    uint32_t size = packAtlas(sorted, forcePowerOfTwoSize, m_atlasOptions);
+    for (uint32_t i = 0; i < order.size(); i++) {
+        repacked[order[i]] = sorted[i];
+    }
+
+    std::shared_ptr<GrayImage> image(new GrayImage(size, size));
+    std::shared_ptr<ColorImage> colorImage;
+    if (m_colorImage) {
+        colorImage.reset(new ColorImage(size, size, m_colorImage->getChannels()));
+    }
+    std::swap(image, m_image);
+    std::swap(colorImage, m_colorImage);
+
+    for (size_t i = 0; i < repacked.size(); i++) {
+        ImageOffset& imgOff = repacked[i];
+        if (imgOff.imgChar->image) {
+            blitCharacter(imgOff);
+            imgOff.imgChar = releasePixels(*imgOff.imgChar);
+            continue;
+        }
+        uint32_t border = getBorder(*imgOff.imgChar, m_atlasOptions);
+        copyCell(*m_image, imgOff, *image, previous[i], border, 1);
+        if (m_colorImage) {
+            copyCell(*m_colorImage, imgOff, *colorImage, previous[i], border, m_colorImage->getChannels());
+        }
+    }
+    std::copy(repacked.begin(), repacked.end(), m_imageCharacters.begin());
+    timer.setArgument("size", size);
+}
+
+const ImageOffset* TextureFontCreator::findCharacter(char32_t unicode, uint32_t variant, uint32_t phase) {
+    auto it = m_characterIndex.find(characterKey(unicode, variant, phase));
+    if (it == m_characterIndex.end()) {
+        return nullptr;
+    }
+    return &m_imageCharacters[it->second];
+}
+
+/*! \brief encodes binary data as base64 string */
+static std::string toBase64(const std::vector<uint8_t>& data) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    std::string result;
+    result.reserve((data.size() + 2) / 3 * 4);
+    for (size_t pos = 0; pos < data.size(); pos += 3) {
+        uint32_t remaining = std::min<size_t>(3, data.size() - pos);
+        uint32_t block = data[pos] << 16;
+        if (remaining > 1) block |= data[pos + 1] << 8;
+        if (remaining > 2) block |= data[pos + 2];
+
+        result.push_back(alphabet[(block >> 18) & 0x3f]);
+        result.push_back(alphabet[(block >> 12) & 0x3f]);
+        result.push_back(remaining > 1 ? alphabet[(block >> 6) & 0x3f] : '=');
+        result.push_back(remaining > 2 ? alphabet[block & 0x3f] : '=');
+    }
+
+    return result;
+}
+
 /**
  * Writes a plain old data type to a stream.
  *
@@ -210,44 +629,58 @@ void writeToStream(std::ostream& stream, const T& data)
     stream.write(reinterpret_cast<const char*>(&data), sizeof(T));
 }
 
-void TextureFontCreator::writeToFile(const std::filesystem::path& path) {
-    // This code was only tested on little endian systems.
-    // If not otherwise specified all values are little endian.
+/*! \brief opens a file for writing, throws if it cannot be opened */
+static std::fstream openOutputFile(const std::filesystem::path& path) {
     std::fstream fp(path, std::fstream::out | std::fstream::binary);
     if (fp.fail()) {
         std::stringstream errorText;
         errorText << "Could not open file \"" << path.native() << "\" for writing. Aborting...";
         throw std::runtime_error(errorText.str());
     }
+    return fp;
+}
 
-    std::string fileSignature = "ytf252";
-
-    fp.write(fileSignature.data(), fileSignature.size());
-
-    uint16_t formatVersion = 4;
-    writeToStream(fp, formatVersion);
-
-    // write font name
-    uint32_t fontNameLength = m_fontName.size();
-    writeToStream(fp, fontNameLength);
-    fp.write(m_fontName.data(), fontNameLength);
+/*! \brief closes a file opened by openOutputFile(), throws if it could not be written completely */
+static void closeOutputFile(std::fstream& fp, const std::filesystem::path& path) {
+    fp.close();
+    if (fp.fail()) {
+        std::stringstream errorText;
+        errorText << "Could not write file \"" << path.native() << "\". Aborting...";
+        throw std::runtime_error(errorText.str());
+    }
+}
 
-    uint32_t width  = m_image->getWidth();
-    uint32_t height = m_image->getHeight();
-    writeToStream(fp, width);  // write width of image
-    writeToStream(fp, height); // write height of image
+/*! \brief writes the character table of a single font variant to a binary file
+ *
+ *  \param extended if true the records contain the additional fields of the extended format
+ *  \param withPage if true the records contain the page, see FORMAT_FEATURE_COLOR_PAGE
+ *  \param encoding encoding of the table, only the extended format supports other encodings than MetricsEncoding::Plain
+ */
+static void writeCharacterTable(std::ostream& fp, const std::vector<ImageOffset>& imageCharacters, uint32_t variant, bool extended, bool withPage, MetricsEncoding encoding) {
+    uint32_t noOfCharacters = std::count_if(imageCharacters.begin(), imageCharacters.end(), [variant](const ImageOffset& imgOff) {
+        return imgOff.variant == variant;
+    });
+    writeToStream(fp, noOfCharacters); // write number of characters
 
-    {
-        GrayImage imageCopy(*m_image);
-        for (uint32_t row = 0; row < imageCopy.getHeight(); row++) { // write image to file
-            fp.write(reinterpret_cast<const char*>(imageCopy.getRow(row)),
-                     imageCopy.getWidth());
+    if (encoding != MetricsEncoding::Plain) {
+        std::vector<CompactGlyphMetrics> metrics;
+        for (const ImageOffset& imgOff : imageCharacters) {
+            if (imgOff.variant == variant) {
+                metrics.push_back(makeCompactGlyphMetrics(*imgOff.imgChar, imgOff.left, imgOff.top, imgOff.page));
+            }
         }
+
+        std::vector<uint8_t> table = encodeGlyphMetrics(metrics, encoding, withPage);
+        uint32_t tableSize = table.size();
+        writeToStream(fp, tableSize); // write size of encoded table in bytes
+        fp.write(reinterpret_cast<const char*>(table.data()), table.size());
+        return;
     }
+    for (const ImageOffset& imgOff : imageCharacters) {
+        if (imgOff.variant != variant) {
+            continue;
+        }
 
-    uint32_t noOfCharacters = m_imageCharacters.size();
-    writeToStream(fp, noOfCharacters); // write number of characters
-    for (ImageOffset& imgOff : m_imageCharacters) {
         writeToStream(fp, imgOff.imgChar->unicode); // write unicode codepoint of character
         writeToStream(fp, imgOff.imgChar->bitmap_left); // write left bearing of character
         writeToStream(fp, imgOff.imgChar->bitmap_top); // write top bearing of character
@@ -256,37 +689,30 @@ void TextureFontCreator::writeToFile(const std::filesystem::path& path) {
         writeToStream(fp, imgOff.left); // left offset of character in image
         writeToStream(fp, imgOff.top); // top offset of character in image
 
-        uint32_t charWidth = imgOff.imgChar->image->getWidth();
-        uint32_t charHeight = imgOff.imgChar->image->getHeight();
+        uint32_t charWidth = imgOff.imgChar->width;
+        uint32_t charHeight = imgOff.imgChar->height;
 
         writeToStream(fp, charWidth); // width of character
         writeToStream(fp, charHeight); // height of character
-    }
 
+        if (extended) {
+            writeToStream(fp, (uint16_t)imgOff.imgChar->face); // index of font face the character was rendered from
+            writeToStream(fp, (uint8_t)imgOff.imgChar->phase); // sub pixel phase of the character
+        }
+        if (withPage) {
+            writeToStream(fp, (uint8_t)imgOff.page); // 1 if the character is stored in the color page
+        }
+    }
 }
 
+/*! \brief creates the JSON character table of a single font variant */
+static nlohmann::json getJsonCharacters(const std::vector<ImageOffset>& imageCharacters, uint32_t variant, bool extended, bool withPage) {
+    nlohmann::json characters = nlohmann::json::array();
 
-void TextureFontCreator::writeToJsonFile(const std::filesystem::path& path)
-{
-    nlohmann::json json;
-
-    json["format"] = "ytf252";
-    json["format_version"] = 4;
-    json["font_name"] = m_fontName;
-
-    json["image_width"] = m_image->getWidth();
-    json["image_height"] = m_image->getHeight();
-
-    auto qImage = m_image->getQImage();
-    // now get PNG data base64 encoded
-    QByteArray byteArray;
-    QBuffer buffer(&byteArray);
-    buffer.open(QIODevice::WriteOnly);
-    qImage->save(&buffer, "PNG");
-    json["image_data_png"] = byteArray.toBase64().toStdString();
-    json["characters"] = nlohmann::json::array();
-
-    for (ImageOffset& imgOff : m_imageCharacters) {
+    for (const ImageOffset& imgOff : imageCharacters) {
+        if (imgOff.variant != variant) {
+            continue;
+        }
 
         nlohmann::json character;
 
@@ -297,75 +723,301 @@ void TextureFontCreator::writeToJsonFile(const std::filesystem::path& path)
         character["vert_advance"] = imgOff.imgChar->vertAdvance;
         character["left"] = imgOff.left;
         character["top"] = imgOff.top;
-        character["width"] = imgOff.imgChar->image->getWidth();
-        character["height"] = imgOff.imgChar->image->getHeight();
+        character["width"] = imgOff.imgChar->width;
+        character["height"] = imgOff.imgChar->height;
+        if (extended) {
+            character["face"] = imgOff.imgChar->face;
+            character["phase"] = imgOff.imgChar->phase;
+        }
+        if (withPage) {
+            character["page"] = imgOff.page;
+        }
 
-        json["characters"].push_back(character);
+        characters.push_back(character);
+    }
 
+    return characters;
+}
+
+/*! \brief returns the version of the ytf252 format needed to store this texture font
+ *
+ *  The legacy version is written for texture fonts using a single font
+ *  variant without fallback fonts, sub pixel phases, LCD rendering, color
+ *  glyphs or mip maps. All other texture fonts and texture fonts using
+ *  compact metrics or block compression are written in the extended
+ *  version, which contains the number of channels and the block compression
+ *  of the image, the optional features, the padding and extrusion of the
+ *  characters, the mip chain, the encoding of the character tables, a table
+ *  of characters for every variant, the names of the fallback fonts, the
+ *  font each character was rendered from and the sub pixel phase of each
+ *  character. See getFormatFeatures() for the optional parts.
+ */
+uint16_t TextureFontCreator::getFormatVersion(MetricsEncoding encoding, BlockFormat imageFormat) {
+    const FontVariantInfo& info = m_variants.front();
+    if (m_variants.size() == 1 && info.faceNames.size() == 1 && info.subpixelPhases == 1 && !info.lcd && !m_colorPage
+            && getMipLevelCount() == 1 && encoding == MetricsEncoding::Plain && imageFormat == BlockFormat::None) {
+        return LEGACY_FORMAT_VERSION;
     }
+    return EXTENDED_FORMAT_VERSION;
+}
 
-    std::fstream fp(path, std::fstream::out | std::fstream::binary);
-    if (fp.fail()) {
+/*! \brief returns the optional features of the extended format this texture font uses
+ *
+ *  With FORMAT_FEATURE_COLOR_PAGE the color page follows the mip chain and
+ *  every character record contains its page.
+ */
+uint32_t TextureFontCreator::getFormatFeatures() {
+    return m_colorPage ? FORMAT_FEATURE_COLOR_PAGE : 0;
+}
+
+void TextureFontCreator::checkBlockCompression(BlockFormat imageFormat) {
+    if (imageFormat == BlockFormat::None) {
+        return;
+    }
+    if (m_colorImage) {
+        throw std::runtime_error("Block compression is only supported for texture fonts without LCD rendering.");
+    }
+    if (m_image->getWidth() % 4 != 0 || m_image->getHeight() % 4 != 0) {
         std::stringstream errorText;
-        errorText <<"Could not open file \"" << path.native() << "\" for writing. Aborting...";
+        errorText << "The image size " << m_image->getWidth() << "x" << m_image->getHeight()
+                  << " is not a multiple of the block size, use a size alignment of 4.";
         throw std::runtime_error(errorText.str());
     }
+}
 
-    fp << json.dump(4);
-    fp.close();
+std::vector<std::shared_ptr<GrayImage>> TextureFontCreator::getMipChain() {
+    std::vector<std::shared_ptr<GrayImage>> mipChain = {m_image};
+    mipChain.insert(mipChain.end(), m_mipLevels.begin(), m_mipLevels.end());
+    return mipChain;
 }
 
+void TextureFontCreator::writeMipLevel(std::ostream& fp, uint32_t level, BlockFormat imageFormat) {
+    if (imageFormat != BlockFormat::None) {
+        std::vector<uint8_t> blocks = compressImage(*getMipLevel(level), imageFormat);
+        fp.write(reinterpret_cast<const char*>(blocks.data()), blocks.size()); // write compressed blocks to file
+    } else if (m_colorImage) {
+        std::shared_ptr<ColorImage> image = getColorMipLevel(level);
+        for (uint32_t row = 0; row < image->getHeight(); row++) { // write interleaved image to file
+            fp.write(reinterpret_cast<const char*>(image->getRow(row)),
+                     image->getWidth() * image->getChannels());
+        }
+    } else {
+        std::shared_ptr<GrayImage> image = getMipLevel(level);
+        for (uint32_t row = 0; row < image->getHeight(); row++) { // write image to file
+            fp.write(reinterpret_cast<const char*>(image->getRow(row)),
+                     image->getWidth());
+        }
+    }
+}
 
-class UTF32toCP437Converter {
-public:
-    UTF32toCP437Converter()
-    {
-        if ((m_cd = iconv_open("CP437", "UTF-32")) == (iconv_t)(-1))
-        {
-            throw std::runtime_error("Cannot open converter");
+void TextureFontCreator::writeToFile(const std::filesystem::path& path, MetricsEncoding encoding, BlockFormat imageFormat) {
+    checkBlockCompression(imageFormat);
+
+    std::fstream fp = openOutputFile(path);
+    writeToFile(fp, encoding, imageFormat);
+    closeOutputFile(fp, path);
+}
+
+void TextureFontCreator::writeToFile(std::ostream& fp, MetricsEncoding encoding, BlockFormat imageFormat) {
+    ScopedTimer timer("write binary file");
+    checkBlockCompression(imageFormat);
+
+    // This code was only tested on little endian systems.
+    // If not otherwise specified all values are little endian.
+    std::streampos start = fp.tellp();
+
+    std::string fileSignature = "ytf252";
+
+    fp.write(fileSignature.data(), fileSignature.size());
+
+    uint16_t formatVersion = getFormatVersion(encoding, imageFormat);
+    writeToStream(fp, formatVersion);
+
+    // write font name
+    uint32_t fontNameLength = m_fontName.size();
+    writeToStream(fp, fontNameLength);
+    fp.write(m_fontName.data(), fontNameLength);
+
+    uint32_t width  = m_image->getWidth();
+    uint32_t height = m_image->getHeight();
+    writeToStream(fp, width);  // write width of image
+    writeToStream(fp, height); // write height of image
+
+    if (formatVersion == LEGACY_FORMAT_VERSION) {
+        GrayImage imageCopy(*m_image);
+        for (uint32_t row = 0; row < imageCopy.getHeight(); row++) { // write image to file
+            fp.write(reinterpret_cast<const char*>(imageCopy.getRow(row)),
+                     imageCopy.getWidth());
         }
+
+        writeCharacterTable(fp, m_imageCharacters, 0, false, false, MetricsEncoding::Plain);
+        Instrumentation::addCount("bytes written", fp.tellp() - start);
+        return;
     }
 
-    ~UTF32toCP437Converter()
-    {
-        iconv_close(m_cd);
+    uint8_t channels = m_colorImage ? m_colorImage->getChannels() : 1;
+    writeToStream(fp, channels); // write number of channels of image
+    writeToStream(fp, imageFormat); // write block compression of image
+    uint32_t features = getFormatFeatures();
+    writeToStream(fp, features); // write bit mask of optional features
+    writeMipLevel(fp, 0, imageFormat);
+
+    writeToStream(fp, (uint16_t)m_atlasOptions.padding); // empty pixels between characters
+    writeToStream(fp, (uint16_t)m_atlasOptions.extrude); // width of the extruded border of characters
+
+    uint8_t noOfMipLevels = getMipLevelCount();
+    writeToStream(fp, noOfMipLevels); // write number of images in mip chain
+    for (uint32_t level = 1; level < noOfMipLevels; level++) {
+        uint32_t levelWidth = getMipLevel(level)->getWidth();
+        uint32_t levelHeight = getMipLevel(level)->getHeight();
+        writeToStream(fp, levelWidth);  // write width of mip map
+        writeToStream(fp, levelHeight); // write height of mip map
+        writeMipLevel(fp, level, imageFormat);
     }
 
+    if (features & FORMAT_FEATURE_COLOR_PAGE) {
+        uint32_t pageWidth = m_colorPage->getWidth();
+        uint32_t pageHeight = m_colorPage->getHeight();
+        writeToStream(fp, pageWidth);  // write width of color page
+        writeToStream(fp, pageHeight); // write height of color page
+        for (uint32_t row = 0; row < pageHeight; row++) { // write RGBA pixels of color page
+            fp.write(reinterpret_cast<const char*>(m_colorPage->getRow(row)), pageWidth * m_colorPage->getChannels());
+        }
+    }
 
-    std::string convert(const std::u32string& str)
-    {
-        std::vector<char> inVec((const char*)str.data(), ((const char*)str.data()) + str.size() * 4);
+    writeToStream(fp, encoding); // write encoding of character tables
+
+    uint32_t noOfVariants = m_variants.size();
+    writeToStream(fp, noOfVariants); // write number of font variants
+    for (uint32_t variant = 0; variant < noOfVariants; variant++) {
+        const FontVariantInfo& info = m_variants[variant];
+
+        uint32_t variantNameLength = info.fontName.size();
+        writeToStream(fp, variantNameLength);
+        fp.write(info.fontName.data(), variantNameLength); // write font name of variant
+        writeToStream(fp, info.fontSize); // font size in pixels
+        writeToStream(fp, (uint8_t)info.antiAliased); // 1 if anti aliased
+        writeToStream(fp, (uint8_t)info.hinted); // 1 if hinted
+
+        uint32_t noOfFaces = info.faceNames.size();
+        writeToStream(fp, noOfFaces); // write number of fonts in fallback chain
+        for (const std::string& faceName : info.faceNames) {
+            uint32_t faceNameLength = faceName.size();
+            writeToStream(fp, faceNameLength);
+            fp.write(faceName.data(), faceNameLength); // write font name of face
+        }
+        writeToStream(fp, (uint8_t)info.subpixelPhases); // number of sub pixel phases per character
+        writeToStream(fp, (uint8_t)info.lcd); // 1 if LCD rendered
+
+        writeCharacterTable(fp, m_imageCharacters, variant, true, features & FORMAT_FEATURE_COLOR_PAGE, encoding);
+    }
+    Instrumentation::addCount("bytes written", fp.tellp() - start);
+}
+
+void TextureFontCreator::writeToJsonFile(const std::filesystem::path& path)
+{
+    std::fstream fp = openOutputFile(path);
+    writeToJsonFile(fp);
+    closeOutputFile(fp, path);
+}
 
-        char* inptr = inVec.data();
-        size_t inleft = inVec.size();
+void TextureFontCreator::writeToJsonFile(std::ostream& fp)
+{
+    ScopedTimer timer("write JSON file");
+    nlohmann::json json;
 
-        std::vector<char> outVec(inVec.size());
-        char* outptr = outVec.data();
-        size_t outleft = outVec.size();
+    json["format"] = "ytf252";
+    json["format_version"] = getFormatVersion();
+    json["font_name"] = m_fontName;
 
-        int rc = iconv(m_cd, &inptr, &inleft, &outptr, &outleft);
-        if (rc == -1)
-        {
-            throw std::runtime_error("Error in converting characters");
+    json["image_width"] = m_image->getWidth();
+    json["image_height"] = m_image->getHeight();
+
+    // now get PNG data base64 encoded
+    std::vector<uint8_t> png = m_colorImage ? encodePng(*m_colorImage) : encodePng(*m_image);
+    json["image_data_png"] = toBase64(png);
+
+    uint32_t features = getFormatFeatures();
+    if (getFormatVersion() == LEGACY_FORMAT_VERSION) {
+        json["characters"] = getJsonCharacters(m_imageCharacters, 0, false, false);
+    } else {
+        json["features"] = features;
+        json["image_channels"] = m_colorImage ? m_colorImage->getChannels() : 1;
+        json["padding"] = m_atlasOptions.padding;
+        json["extrude"] = m_atlasOptions.extrude;
+
+        json["mip_maps"] = nlohmann::json::array();
+        for (uint32_t level = 1; level < getMipLevelCount(); level++) {
+            nlohmann::json mipMap;
+            mipMap["width"] = getMipLevel(level)->getWidth();
+            mipMap["height"] = getMipLevel(level)->getHeight();
+            std::vector<uint8_t> mipPng = m_colorImage ? encodePng(*getColorMipLevel(level)) : encodePng(*getMipLevel(level));
+            mipMap["image_data_png"] = toBase64(mipPng);
+            json["mip_maps"].push_back(mipMap);
         }
+        if (features & FORMAT_FEATURE_COLOR_PAGE) {
+            nlohmann::json colorPage;
+            colorPage["width"] = m_colorPage->getWidth();
+            colorPage["height"] = m_colorPage->getHeight();
+            colorPage["image_data_png"] = toBase64(encodePng(*m_colorPage));
+            json["color_page"] = colorPage;
+        }
+        json["variants"] = nlohmann::json::array();
+        for (uint32_t variant = 0; variant < m_variants.size(); variant++) {
+            const FontVariantInfo& info = m_variants[variant];
+
+            nlohmann::json jsonVariant;
+            jsonVariant["font_name"] = info.fontName;
+            jsonVariant["font_size"] = info.fontSize;
+            jsonVariant["anti_aliased"] = info.antiAliased;
+            jsonVariant["hinted"] = info.hinted;
+            jsonVariant["faces"] = info.faceNames;
+            jsonVariant["subpixel_phases"] = info.subpixelPhases;
+            jsonVariant["lcd"] = info.lcd;
+            jsonVariant["characters"] = getJsonCharacters(m_imageCharacters, variant, true, features & FORMAT_FEATURE_COLOR_PAGE);
+
+            json["variants"].push_back(jsonVariant);
+        }
+    }
+
+    std::streampos start = fp.tellp();
+    fp << json.dump(4);
+    Instrumentation::addCount("bytes written", fp.tellp() - start);
+}
 
-        return std::string(outVec.data(), outVec.size() - outleft);
+
+void TextureFontCreator::checkSimpleFormat() {
+    if (m_variants.size() > 1) {
+        throw std::runtime_error("The simple font format supports only a single font variant.");
+    }
+    if (m_variants.front().subpixelPhases > 1) {
+        throw std::runtime_error("The simple font format does not support sub pixel phases.");
+    }
+    if (m_colorImage) {
+        throw std::runtime_error("The simple font format does not support LCD rendering.");
     }
+    if (m_colorPage) {
+        throw std::runtime_error("The simple font format does not support color glyphs.");
+    }
+}
 
-private:
-    iconv_t m_cd;
-};
+void TextureFontCreator::writeToSimpleFile(const std::filesystem::path& path, Codepage codepage, UnmappableCharacters unmappable, uint8_t substitute)
+{
+    checkSimpleFormat();
 
-void TextureFontCreator::writeToSimpleFile(const std::filesystem::path& path)
+    std::fstream fp = openOutputFile(path);
+    writeToSimpleFile(fp, codepage, unmappable, substitute);
+    closeOutputFile(fp, path);
+}
+
+void TextureFontCreator::writeToSimpleFile(std::ostream& fp, Codepage codepage, UnmappableCharacters unmappable, uint8_t substitute)
 {
+    ScopedTimer timer("write simple file");
+    checkSimpleFormat();
+
     // This code was only tested on little endian systems.
     // If not otherwise specified all values are little endian.
-    std::fstream fp(path, std::fstream::out | std::fstream::binary);
-    if (fp.fail()) {
-        std::stringstream errorText;
-        errorText << "Could not open file \"" << path.native() << "\" for writing. Aborting...";
-        throw std::runtime_error(errorText.str());
-    }
+    std::streampos start = fp.tellp();
 
     std::string fileSignature = "stf252";
     fp.write(fileSignature.data(), fileSignature.size());
@@ -386,30 +1038,90 @@ void TextureFontCreator::writeToSimpleFile(const std::filesystem::path& path)
         }
     }
 
-    uint16_t noOfCharacters = m_imageCharacters.size();
+    // readers draw unmappable characters with the substitute code, so its character has to be stored
+    if (unmappable == UnmappableCharacters::Substitute) {
+        char32_t substituteCharacter = decodeCodepoint(substitute, codepage);
+        bool substituteStored = substituteCharacter != 0 && std::any_of(m_imageCharacters.begin(), m_imageCharacters.end(), [&](const ImageOffset& imgOff) {
+            return imgOff.imgChar->unicode == substituteCharacter;
+        });
+        if (!substituteStored) {
+            std::stringstream errorText;
+            errorText << "The substitute code " << static_cast<uint32_t>(substitute) << " of code page " << getCodepageName(codepage)
+                      << " is not the code of a character of the texture font.";
+            throw std::runtime_error(errorText.str());
+        }
+    }
+
+    // map all characters first, as the number of characters precedes them
+    std::vector<std::pair<uint8_t, const ImageOffset*>> characters;
+    for (const ImageOffset& imgOff : m_imageCharacters) {
+        uint8_t code;
+        if (encodeCodepoint(imgOff.imgChar->unicode, codepage, code)) {
+            characters.push_back({code, &imgOff});
+            continue;
+        }
+
+        switch (unmappable) {
+            case UnmappableCharacters::Skip:
+            case UnmappableCharacters::Substitute:
+                break;
+
+            case UnmappableCharacters::Error: {
+                std::stringstream errorText;
+                errorText << "Character " << imgOff.imgChar->unicode << " does not exist in code page " << getCodepageName(codepage) << ".";
+                throw std::runtime_error(errorText.str());
+            }
+        }
+    }
+
+    uint16_t noOfCharacters = characters.size();
     writeToStream(fp, noOfCharacters); // write number of characters
 
-    UTF32toCP437Converter converter;
-    for (ImageOffset& imgOff : m_imageCharacters)
+    for (const auto& [code, imgOff] : characters)
     {
-        std::u32string in;
-        in.push_back(imgOff.imgChar->unicode);
-        std::string cp437 = converter.convert(in);
-        writeToStream(fp, (uint8_t)cp437.at(0)); // write cp437 codepoint of character
-        writeToStream(fp, (int16_t)imgOff.imgChar->bitmap_left); // write left bearing of character
-        writeToStream(fp, (int16_t)imgOff.imgChar->bitmap_top); // write top bearing of character
-        writeToStream(fp, (int16_t)ceil(imgOff.imgChar->horiAdvance)); // horizontal advance of character
-        writeToStream(fp, (int16_t)ceil(imgOff.imgChar->vertAdvance)); // vertical advance of character
-        writeToStream(fp, (int16_t)imgOff.left); // left offset of character in image
-        writeToStream(fp, (int16_t)imgOff.top); // top offset of character in image
-
-        uint32_t charWidth = imgOff.imgChar->image->getWidth();
-        uint32_t charHeight = imgOff.imgChar->image->getHeight();
+        writeToStream(fp, code); // write codepoint of character in the code page
+        writeToStream(fp, (int16_t)imgOff->imgChar->bitmap_left); // write left bearing of character
+        writeToStream(fp, (int16_t)imgOff->imgChar->bitmap_top); // write top bearing of character
+        writeToStream(fp, (int16_t)ceil(imgOff->imgChar->horiAdvance)); // horizontal advance of character
+        writeToStream(fp, (int16_t)ceil(imgOff->imgChar->vertAdvance)); // vertical advance of character
+        writeToStream(fp, (int16_t)imgOff->left); // left offset of character in image
+        writeToStream(fp, (int16_t)imgOff->top); // top offset of character in image
+
+        uint32_t charWidth = imgOff->imgChar->width;
+        uint32_t charHeight = imgOff->imgChar->height;
 
         writeToStream(fp, (int16_t)charWidth); // width of character
         writeToStream(fp, (int16_t)charHeight); // height of character
     }
 
+    Instrumentation::addCount("bytes written", fp.tellp() - start);
+}
+
+
+void TextureFontCreator::writeToPngFile(const std::filesystem::path& path, const PngOptions& options)
+{
+    ScopedTimer timer("write PNG file");
+    if (m_colorImage) {
+        writePngFile(path, *m_colorImage, options);
+    } else {
+        writePngFile(path, *m_image, options);
+    }
+}
+
+
+void TextureFontCreator::writeToDdsFile(const std::filesystem::path& path, uint32_t threads)
+{
+    ScopedTimer timer("write DDS file");
+    checkBlockCompression(BlockFormat::BC4);
+    writeDdsFile(path, getMipChain(), threads);
+}
+
+
+void TextureFontCreator::writeToKtxFile(const std::filesystem::path& path, BlockFormat format, uint32_t threads)
+{
+    ScopedTimer timer("write KTX file");
+    checkBlockCompression(format);
+    writeKtxFile(path, getMipChain(), format, threads);
 }
 
 
@@ -417,51 +1129,140 @@ TextureFontCreator::~TextureFontCreator() {
     // TODO Auto-generated destructor stub
 }
 
-enum class DrawStage
+std::shared_ptr<GrayImage> TextureFontCreator::renderText(const std::u8string& text, uint32_t variant, BlendMode mode)
 {
-    CALCULATE_SIZE,
-    DRAW_IMAGE
-};
+    // without sub pixel phases every advance is rounded up to full pixels
+    uint32_t phases = m_variants.at(variant).subpixelPhases;
+
+    struct PlacedCharacter {
+        const ImageOffset* imgOff;
+        int32_t left;
+        int32_t top;
+    };
+
+    // place all characters first, so the size of the image is known before drawing
+    std::vector<PlacedCharacter> placed;
+    placed.reserve(text.size());
+
+    // extents of the placed characters, the pen starts at the origin
+    double pen = 0;
+    int32_t minX = 0;
+    int32_t maxX = 0;
+    int32_t minY = 0;
+    int32_t maxY = 0;
+    for (size_t pos = 0; pos < text.size(); ) {
+        char32_t unicode = decodeUtf8(text, pos);
+
+        int32_t left = floor(pen);
+        uint32_t phase = (pen - left) * phases;
+
+        const ImageOffset* imgOff = findCharacter(unicode, variant, phase);
+        if (!imgOff) {
+            continue;
+        }
 
-std::shared_ptr<GrayImage> TextureFontCreator::renderText(const std::u8string& text)
+        const ImageCharacter& imgChar = *imgOff->imgChar;
+        int32_t top = ceil(imgChar.vertAdvance) - imgChar.bitmap_top;
+        placed.push_back({imgOff, left + imgChar.bitmap_left, top});
+
+        if (phases > 1) {
+            pen += imgChar.horiAdvance;
+        } else {
+            pen += ceil(imgChar.horiAdvance);
+        }
+
+        // characters without pixels only advance the pen and keep the height of the line
+        maxY = std::max<int32_t>(maxY, top + imgChar.height);
+        if (imgChar.width > 0 && imgChar.height > 0) {
+            minX = std::min<int32_t>(minX, left + imgChar.bitmap_left);
+            maxX = std::max<int32_t>(maxX, left + imgChar.bitmap_left + imgChar.width);
+            minY = std::min<int32_t>(minY, top);
+        }
+    }
+    maxX = std::max<int32_t>(maxX, ceil(pen));
+
+    // negative bearings and overhangs move the origin into the image
+    std::shared_ptr<GrayImage> result(new GrayImage(maxX - minX, maxY - minY));
+    std::vector<uint8_t> grayPixels; // color glyphs converted to gray, reused for all of them
+    for (const PlacedCharacter& character : placed) {
+        // the pixels are read from the image, streamed characters keep none of their own
+        const ImageOffset& imgOff = *character.imgOff;
+        uint32_t width = imgOff.imgChar->width;
+        uint32_t height = imgOff.imgChar->height;
+        if (width == 0 || height == 0) {
+            continue;
+        }
+        if (imgOff.page == 1) {
+            grayPixels.resize(std::max<size_t>(grayPixels.size(), static_cast<size_t>(width) * height));
+            m_colorPage->getGrayPixels(imgOff.left, imgOff.top, width, height, grayPixels.data(), width);
+            result->composite(grayPixels.data(), width, width, height, character.left - minX, character.top - minY, mode);
+        } else {
+            result->composite(m_image->getRow(imgOff.top) + imgOff.left, m_image->getPitch(), width, height, character.left - minX, character.top - minY, mode);
+        }
+    }
+
+    return result;
+}
+
+void TextureFontCreator::layoutText(const std::vector<std::u8string>& texts, TextQuads& quads, uint32_t variant)
 {
-    std::u32string utf32 = toU32String(text);
+    // without sub pixel phases every advance is rounded up to full pixels
+    uint32_t phases = m_variants.at(variant).subpixelPhases;
+    float scaleU[2] = {1.0f / m_image->getWidth(), 0.0f};
+    float scaleV[2] = {1.0f / m_image->getHeight(), 0.0f};
+    if (m_colorPage) {
+        scaleU[1] = 1.0f / m_colorPage->getWidth();
+        scaleV[1] = 1.0f / m_colorPage->getHeight();
+    }
 
-    std::shared_ptr<GrayImage> result;
+    quads.vertices.clear();
+    quads.stringOffsets.clear();
+    quads.stringAdvances.clear();
+    quads.pages.clear();
 
-    for (DrawStage stage : {DrawStage::CALCULATE_SIZE, DrawStage::DRAW_IMAGE})
-    {
-        int32_t top = 0;
-        int32_t left = 0;
-        int32_t maxHeight = 0;
-        for (char32_t unicode : utf32) {
-            for (ImageOffset& imgOff : m_imageCharacters) {
-                if (imgOff.imgChar->unicode == unicode) {
-                    if (stage == DrawStage::DRAW_IMAGE)
-                    {
-                        result->blit(*(imgOff.imgChar->image), left + imgOff.imgChar->bitmap_left, ceil(imgOff.imgChar->vertAdvance) - imgOff.imgChar->bitmap_top);
-                    }
-
-                    left += ceil(imgOff.imgChar->horiAdvance);
-
-                    auto height = ceil(imgOff.imgChar->vertAdvance) - imgOff.imgChar->bitmap_top + imgOff.imgChar->image->getHeight();
-
-                    if (height > maxHeight)
-                    {
-                        maxHeight = height;
-                    }
-                        
-                    break;
-                }
+    for (const std::u8string& text : texts) {
+        quads.stringOffsets.push_back(quads.getQuadCount());
+
+        double pen = 0;
+        for (size_t pos = 0; pos < text.size(); ) {
+            char32_t unicode = decodeUtf8(text, pos);
+
+            int32_t left = floor(pen);
+            uint32_t phase = (pen - left) * phases;
+
+            const ImageOffset* imgOff = findCharacter(unicode, variant, phase);
+            if (!imgOff) {
+                continue;
+            }
+
+            const ImageCharacter& imgChar = *imgOff->imgChar;
+            uint32_t width = imgChar.width;
+            uint32_t height = imgChar.height;
+
+            // characters without pixels (e.g. spaces) only advance the pen
+            if (width > 0 && height > 0) {
+                float x0 = left + imgChar.bitmap_left;
+                float y0 = -imgChar.bitmap_top;
+                float u0 = imgOff->left * scaleU[imgOff->page];
+                float v0 = imgOff->top * scaleV[imgOff->page];
+
+                float quad[TextQuads::FLOATS_PER_QUAD] = {
+                    x0, y0, x0 + width, y0 + height,
+                    u0, v0, u0 + width * scaleU[imgOff->page], v0 + height * scaleV[imgOff->page]
+                };
+                quads.vertices.insert(quads.vertices.end(), quad, quad + TextQuads::FLOATS_PER_QUAD);
+                quads.pages.push_back(imgOff->page);
             }
-        }
 
-        if (stage == DrawStage::CALCULATE_SIZE)
-        {
-            result = std::shared_ptr<GrayImage>(new GrayImage(left, maxHeight));
+            if (phases > 1) {
+                pen += imgChar.horiAdvance;
+            } else {
+                pen += ceil(imgChar.horiAdvance);
+            }
         }
+
+        quads.stringAdvances.push_back(pen);
     }
-    
 
-    return result;
+    quads.stringOffsets.push_back(quads.getQuadCount());
 }
@@ -12,14 +12,145 @@
 #include <vector>
 #include <memory>
 #include <filesystem>
+#include <ostream>
+#include <unordered_map>
 
 #include "GrayImage.h"
 #include "FreeTypeRender.h"
+#include "PngEncoder.h"
+#include "GlyphMetrics.h"
+#include "BlockCompression.h"
+#include "Codepage.h"
+#include "GlyphCache.h"
+
+/*! \brief revision of the texture fonts written by TextureFontCreator
+ *
+ *  Increment it with every change making texture fonts built from the same
+ *  inputs differ, e.g. in rendering, packing or writing, so texture fonts
+ *  of an earlier revision are built again, see BuildManifest.
+ */
+constexpr uint32_t GENERATOR_REVISION = 1;
 
 struct ImageOffset {
     std::shared_ptr<ImageCharacter> imgChar;
     int32_t left;
     int32_t top;
+    uint32_t variant; //!< index of the font variant this character belongs to
+    uint32_t page = 0; //!< 0 if the character is stored in the image, 1 if it is a color glyph stored in the color page
+};
+
+/*! \brief Description of a single font variant
+ *
+ *  A texture font may contain several variants of a font (e.g. the same
+ *  font at different sizes, or a different font for other scripts) that
+ *  all share one image.
+ */
+struct FontVariant {
+    std::filesystem::path fontpath; //!< path to the TrueType font
+    double fontSize; //!< size of the font in pixels
+    std::u8string chars; //!< characters to render for this variant
+    bool enableAntiAliasing;
+    bool enableHinting;
+    std::vector<std::filesystem::path> fallbackFontpaths; //!< fonts used for characters missing in fontpath
+    std::shared_ptr<FontSession> session; //!< if set, the fonts of this session are used instead of loading fontpath and fallbackFontpaths
+    uint32_t subpixelPhases = 1; //!< number of horizontally shifted copies rendered of every character
+    bool enableLcdRendering = false; //!< render characters with RGB subpixels, the texture font image then has three channels
+    std::shared_ptr<GlyphCache> glyphCache; //!< if set, characters of the last build found in the cache are not rendered again
+    uint32_t faceIndex = 0; //!< index of the face in fontpath if it is a font collection (TTC), not used if session is set
+    FontVariation variation; //!< instance of fontpath if it is a variable font
+};
+
+/*! \brief Information about a font variant contained in a texture font */
+struct FontVariantInfo {
+    std::string fontName;
+    double fontSize;
+    bool antiAliased;
+    bool hinted;
+    std::vector<std::string> faceNames; //!< names of the font and its fallback fonts
+    uint32_t subpixelPhases;
+    bool lcd;
+};
+
+/*! \brief Options for packing the characters into the texture font image */
+struct AtlasOptions {
+    uint32_t padding = 1; //!< number of empty pixels between neighbouring characters
+
+    /*! \brief number of pixels the edges of every character are extended by
+     *
+     *  The edge pixels of every character are repeated into a border of this
+     *  width, so bilinear filtering at the edge of a character does not pick
+     *  up empty or foreign pixels. The offsets stored for a character still
+     *  point to the character itself, not to its border.
+     */
+    uint32_t extrude = 0;
+
+    /*! \brief number of images in the mip chain, including the full size image
+     *
+     *  1 creates no mip maps, 0 creates the full chain down to a single pixel.
+     *  Mip maps are created with a box filter. Use padding and extrusion of
+     *  at least 2^(levels - 1) pixels to avoid bleeding between characters
+     *  in the smaller levels.
+     */
+    uint32_t mipLevels = 1;
+
+    /*! \brief the image size is rounded up to a multiple of this value
+     *
+     *  Use 4 for images that are block compressed.
+     */
+    uint32_t sizeAlignment = 1;
+
+    /*! \brief search the smallest image with several packing algorithms and character orders
+     *
+     *  Shelf, skyline and MaxRects packing are tried with the characters
+     *  ordered by height, width, area and perimeter on all cores, see
+     *  optimizePacking(). The default packing is kept if no candidate is
+     *  smaller.
+     */
+    bool optimizePacking = false;
+
+    /*! \brief time in milliseconds the search of optimizePacking may take, 0 for no limit */
+    uint32_t optimizeTimeLimit = 0;
+
+    /*! \brief build the texture font in two passes with bounded memory
+     *
+     *  The first pass only measures the characters, see
+     *  FreeTypeRender::measureUnicodeCharacter(), and packs them. The second
+     *  pass renders the characters one by one straight into the image and
+     *  releases their pixels, so the memory needed is about the size of the
+     *  image instead of the image plus all rendered characters. The cells
+     *  of the characters are the boxes of their outlines, so the image is
+     *  slightly larger than without streaming. A character rendered larger
+     *  than its box, e.g. by hinting, keeps its pixels and the image is
+     *  packed again once all characters are rendered. Characters found in the
+     *  glyph cache are used, but no characters are added to it.
+     */
+    bool streaming = false;
+};
+
+/*! \brief decodes a UTF-8 string, throws on invalid sequences */
+std::u32string toU32String(const std::u8string& str);
+
+/*! \brief Quads of a batch of laid out strings
+ *
+ *  Every quad consists of FLOATS_PER_QUAD floats stored consecutively in
+ *  vertices: x0, y0, x1, y1 is the rectangle of the character in pixels
+ *  relative to the start of its string on the baseline (y pointing down),
+ *  u0, v0, u1, v1 are the texture coordinates of the character in the
+ *  image of the texture font, ranging from 0 to 1. Color glyphs are stored
+ *  in the color page, their texture coordinates refer to it.
+ *
+ *  The buffers are cleared but not released by TextureFontCreator::layoutText,
+ *  so reusing a TextQuads object avoids allocations.
+ */
+struct TextQuads {
+    static constexpr uint32_t FLOATS_PER_QUAD = 8;
+
+    std::vector<float> vertices;
+    std::vector<uint32_t> stringOffsets; //!< index of the first quad of every string, followed by the total number of quads
+    std::vector<float> stringAdvances; //!< horizontal advance of every string in pixels
+    std::vector<uint32_t> pages; //!< image of every quad, see ImageOffset::page
+
+    uint32_t getQuadCount() const { return vertices.size() / FLOATS_PER_QUAD; }
 };
 
 class TextureFontCreator {
@@ -33,19 +164,183 @@ public:
         bool enableAntiAliasing,
         bool enableHinting);
 
+    /*! \brief Constructor for texture fonts containing several font variants
+     *
+     *  All variants are rendered in parallel and packed into a single image.
+     *
+     *  \param variants the font variants to put into the texture font
+     *  \param forcePowerOfTwoSize if true the image size will be a power of two
+     *  \param atlasOptions padding, extrusion and mip maps of the image
+     */
+    TextureFontCreator(
+        const std::vector<FontVariant>& variants,
+        bool forcePowerOfTwoSize,
+        const AtlasOptions& atlasOptions = AtlasOptions());
+
     std::shared_ptr<GrayImage> getImage() { return m_image; }
 
-    void writeToFile(const std::filesystem::path& path);
+    /*! \brief returns the RGB image of the texture font
+     *
+     *  The RGB image only exists if at least one variant uses LCD rendering,
+     *  otherwise an empty pointer is returned. Characters of variants not
+     *  using LCD rendering are stored with equal values in all channels.
+     */
+    std::shared_ptr<ColorImage> getColorImage() { return m_colorImage; }
+
+    /*! \brief returns the RGBA image holding the color glyphs, e.g. emoji
+     *
+     *  The color page only exists if at least one character was rendered
+     *  from a color font, otherwise an empty pointer is returned. Its pixels
+     *  are premultiplied by their alpha. The color page has the padding and
+     *  extrusion of the image but no mip maps.
+     */
+    std::shared_ptr<ColorImage> getColorPage() { return m_colorPage; }
+
+    /*! \brief returns the number of images in the mip chain, including the full size image */
+    uint32_t getMipLevelCount() { return m_mipLevels.size() + 1; }
+
+    /*! \brief returns an image of the mip chain, level 0 is the full size image */
+    std::shared_ptr<GrayImage> getMipLevel(uint32_t level) { return (level == 0) ? m_image : m_mipLevels.at(level - 1); }
+
+    /*! \brief returns an RGB image of the mip chain, only exists if getColorImage() exists */
+    std::shared_ptr<ColorImage> getColorMipLevel(uint32_t level) { return (level == 0) ? m_colorImage : m_colorMipLevels.at(level - 1); }
+
+    /*! \brief writes the texture font to a binary ytf252 file
+     *
+     *  \param path the file to write
+     *  \param encoding encoding of the character tables, every encoding
+     *         other than MetricsEncoding::Plain requires the extended format version
+     *  \param imageFormat block compression of the image and its mip maps,
+     *         requires the extended format version, a single channel image and an
+     *         image size that is a multiple of 4
+     */
+    void writeToFile(const std::filesystem::path& path, MetricsEncoding encoding = MetricsEncoding::Plain, BlockFormat imageFormat = BlockFormat::None);
+
+    /*! \brief writes the texture font in the binary ytf252 format to a stream, see writeToFile() */
+    void writeToFile(std::ostream& fp, MetricsEncoding encoding = MetricsEncoding::Plain, BlockFormat imageFormat = BlockFormat::None);
+
     void writeToJsonFile(const std::filesystem::path& path);
-    void writeToSimpleFile(const std::filesystem::path& path);
+
+    /*! \brief writes the texture font in the JSON format to a stream */
+    void writeToJsonFile(std::ostream& fp);
+
+    /*! \brief writes the texture font to a simple stf252 file
+     *
+     *  The simple format stores characters with 8bit codes of a code page.
+     *
+     *  \param path the file to write
+     *  \param codepage the code page the characters are stored in
+     *  \param unmappable how characters that do not exist in the code page are handled
+     *  \param substitute code used with UnmappableCharacters::Substitute, the character
+     *         of this code has to be part of the texture font, otherwise an exception
+     *         is thrown
+     */
+    void writeToSimpleFile(const std::filesystem::path& path, Codepage codepage = Codepage::CP437,
+                           UnmappableCharacters unmappable = UnmappableCharacters::Error, uint8_t substitute = '?');
+
+    /*! \brief writes the texture font in the simple stf252 format to a stream, see writeToSimpleFile() */
+    void writeToSimpleFile(std::ostream& fp, Codepage codepage = Codepage::CP437,
+                           UnmappableCharacters unmappable = UnmappableCharacters::Error, uint8_t substitute = '?');
+
+    /*! \brief writes the image of the texture font to a PNG file
+     *
+     *  This allows to store the image next to the metrics, e.g. for tools
+     *  that load images with their own PNG decoder. The color page is
+     *  only stored in the binary and JSON formats.
+     */
+    void writeToPngFile(const std::filesystem::path& path, const PngOptions& options = PngOptions());
+
+    /*! \brief writes the image and its mip maps BC4 compressed to a DDS file
+     *
+     *  \param threads number of threads used for compression, 0 uses all cores
+     */
+    void writeToDdsFile(const std::filesystem::path& path, uint32_t threads = 0);
+
+    /*! \brief writes the image and its mip maps block compressed to a KTX file
+     *
+     *  \param format BlockFormat::BC4 or BlockFormat::EacR11
+     *  \param threads number of threads used for compression, 0 uses all cores
+     */
+    void writeToKtxFile(const std::filesystem::path& path, BlockFormat format, uint32_t threads = 0);
 
     std::string getFontName() { return m_fontName; }
+    const std::vector<FontVariantInfo>& getVariants() { return m_variants; }
+
+    /*! \brief returns all characters of all variants with their offsets in the images */
+    const std::vector<ImageOffset>& getImageCharacters() { return m_imageCharacters; }
+
+    const AtlasOptions& getAtlasOptions() { return m_atlasOptions; }
+
+    /*! \brief renders a string using the characters of the texture font
+     *
+     *  The image contains all pixels of the characters, a negative left
+     *  bearing or a character reaching above the line moves the origin of the
+     *  pen into the image. Overlapping characters are combined using mode.
+     *
+     *  \param text the string to render
+     *  \param variant the font variant to use
+     *  \param mode how overlapping characters are combined
+     */
+    std::shared_ptr<GrayImage> renderText(const std::u8string& text, uint32_t variant = 0, BlendMode mode = BlendMode::Max);
+
+    /*! \brief lays out several strings at once
+     *
+     *  The strings are laid out like renderText() does, but instead of
+     *  rendering an image a quad is emitted for every visible character.
+     *  Characters missing in the texture font are skipped.
+     *
+     *  \param texts the strings to lay out
+     *  \param quads receives the quads of all strings
+     *  \param variant the font variant to use
+     */
+    void layoutText(const std::vector<std::u8string>& texts, TextQuads& quads, uint32_t variant = 0);
+
+private:
+    uint16_t getFormatVersion(MetricsEncoding encoding = MetricsEncoding::Plain, BlockFormat imageFormat = BlockFormat::None);
+    uint32_t getFormatFeatures();
+
+    /*! \brief throws if the image cannot be compressed with the given format */
+    void checkBlockCompression(BlockFormat imageFormat);
+
+    /*! \brief throws if the texture font cannot be stored in the simple format */
+    void checkSimpleFormat();
+
+    /*! \brief returns all images of the mip chain, starting with the full size image */
+    std::vector<std::shared_ptr<GrayImage>> getMipChain();
+
+    /*! \brief finds a character of the texture font, returns nullptr if it does not exist */
+    const ImageOffset* findCharacter(char32_t unicode, uint32_t variant, uint32_t phase);
+
+    /*! \brief copies the pixels of a character into the image or the color page and extrudes its edges */
+    void blitCharacter(const ImageOffset& imgOff);
+
+    /*! \brief renders the measured characters of a variant into the image, the second pass of AtlasOptions::streaming
+     *
+     *  \return number of characters larger than the box they were measured with,
+     *          they keep their pixels and are placed by repackImage()
+     */
+    uint32_t streamCharacters(const FontVariant& variant, std::shared_ptr<FontSession> session, uint32_t variantIndex);
+
+    /*! \brief packs the characters of the image again with their final sizes
+     *
+     *  The pixels of characters already in the image are moved to their new
+     *  cells, characters still holding their pixels are blitted.
+     */
+    void repackImage(bool forcePowerOfTwoSize);
 
-    std::shared_ptr<GrayImage> renderText(const std::u8string& text);
+    /*! \brief writes the pixels of an image of the mip chain to a binary file */
+    void writeMipLevel(std::ostream& fp, uint32_t level, BlockFormat imageFormat);
 
 private:
     std::shared_ptr<GrayImage> m_image;
+    std::shared_ptr<ColorImage> m_colorImage;
+    std::vector<std::shared_ptr<GrayImage>> m_mipLevels; //!< smaller images of the mip chain, starting with half the size of m_image
+    std::vector<std::shared_ptr<ColorImage>> m_colorMipLevels; //!< smaller images of the mip chain of m_colorImage
+    std::shared_ptr<ColorImage> m_colorPage; //!< RGBA image of the color glyphs
     std::vector<ImageOffset> m_imageCharacters;
+    std::vector<FontVariantInfo> m_variants;
+    AtlasOptions m_atlasOptions;
+    std::unordered_map<uint64_t, uint32_t> m_characterIndex; //!< index into m_imageCharacters by variant, phase and codepoint
     std::string m_fontName;
 };
 
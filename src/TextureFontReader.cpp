@@ -0,0 +1,546 @@
+/*
+ * TextureFontReader.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "TextureFontReader.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include <nlohmann/json.hpp>
+
+#include "MappedFile.h"
+#include "PngEncoder.h"
+
+/*! \brief bounds checked reader for little endian binary data */
+class ByteReader {
+public:
+    ByteReader(const uint8_t* data, size_t size) : m_data(data), m_size(size), m_pos(0) {}
+
+    template <typename T>
+    T read() {
+        T value;
+        memcpy(&value, skip(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    /*! \brief reads a string preceded by its 32bit length */
+    std::string readString() {
+        uint32_t length = read<uint32_t>();
+        const uint8_t* data = skip(length);
+        return std::string(reinterpret_cast<const char*>(data), length);
+    }
+
+    /*! \brief skips the given number of bytes and returns a pointer to them */
+    const uint8_t* skip(size_t length) {
+        if (length > m_size - m_pos) {
+            throw std::runtime_error("Texture font file is truncated.");
+        }
+        const uint8_t* data = m_data + m_pos;
+        m_pos += length;
+        return data;
+    }
+
+    size_t getPosition() { return m_pos; }
+    size_t getRemaining() { return m_size - m_pos; }
+
+private:
+    const uint8_t* m_data;
+    size_t m_size;
+    size_t m_pos;
+};
+
+/*! \brief largest width or height of an image the reader accepts */
+static const uint32_t MAX_IMAGE_DIMENSION = 65536;
+
+/*! \brief returns the number of bytes of an uncompressed image, throws if the dimensions are invalid
+ *
+ *  The dimensions are limited, so that the size can neither overflow here
+ *  nor in the row offsets of ColorImage.
+ */
+static size_t getImageSize(uint32_t width, uint32_t height, uint32_t channels) {
+    if (width > MAX_IMAGE_DIMENSION || height > MAX_IMAGE_DIMENSION) {
+        std::stringstream errorText;
+        errorText << "Texture font file contains an image of invalid size " << width << "x" << height << ".";
+        throw std::runtime_error(errorText.str());
+    }
+    return static_cast<size_t>(width) * height * channels;
+}
+
+/*! \brief decodes a base64 string, see toBase64() in TextureFontCreator.cpp */
+static std::vector<uint8_t> fromBase64(const std::string& text) {
+    std::vector<uint8_t> result;
+    result.reserve(text.size() / 4 * 3);
+
+    uint32_t block = 0;
+    uint32_t bits = 0;
+    for (char c : text) {
+        int32_t value;
+        if (c >= 'A' && c <= 'Z') value = c - 'A';
+        else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+        else if (c >= '0' && c <= '9') value = c - '0' + 52;
+        else if (c == '+') value = 62;
+        else if (c == '/') value = 63;
+        else if (c == '=') break;
+        else throw std::runtime_error("Texture font file contains invalid base64 data.");
+
+        block = (block << 6) | value;
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            result.push_back(block >> bits);
+        }
+    }
+
+    return result;
+}
+
+TextureFontReader::TextureFontReader(const std::filesystem::path& path) {
+    m_file.reset(new MappedFile(path));
+    m_data = m_file->getData();
+    m_size = m_file->getSize();
+    parse();
+}
+
+TextureFontReader::TextureFontReader(const uint8_t* data, size_t size) {
+    m_buffer.assign(data, data + size);
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+    parse();
+}
+
+TextureFontReader::~TextureFontReader() {
+}
+
+void TextureFontReader::parse() {
+    m_formatVersion = 0;
+    m_formatFeatures = 0;
+    m_width = 0;
+    m_height = 0;
+    m_channels = 1;
+    m_blockFormat = BlockFormat::None;
+    m_metricsEncoding = MetricsEncoding::Plain;
+    m_padding = 1;
+    m_extrude = 0;
+    m_colorPage = {0, 0, 0, 0, nullptr};
+
+    if (m_size >= 6 && memcmp(m_data, "ytf252", 6) == 0) {
+        m_format = TextureFontFormat::Binary;
+        parseBinary();
+    } else if (m_size >= 6 && memcmp(m_data, "stf252", 6) == 0) {
+        m_format = TextureFontFormat::Simple;
+        parseSimple();
+    } else {
+        const uint8_t* first = std::find_if(m_data, m_data + m_size, [](uint8_t c) { return !isspace(c); });
+        if (first == m_data + m_size || *first != '{') {
+            throw std::runtime_error("Unknown texture font file format.");
+        }
+        m_format = TextureFontFormat::Json;
+        parseJson();
+    }
+
+    checkCharacters();
+}
+
+/*! \brief reads the character table of a variant in a binary file
+ *
+ *  \param extended if true the records contain the additional fields of the extended format
+ *  \param withPage if true the records contain the page, see FORMAT_FEATURE_COLOR_PAGE
+ */
+static void readCharacterTable(ByteReader& reader, TextureFontVariant& variant, bool extended, bool withPage, MetricsEncoding encoding) {
+    uint32_t noOfCharacters = reader.read<uint32_t>();
+
+    if (encoding != MetricsEncoding::Plain) {
+        uint32_t tableSize = reader.read<uint32_t>();
+        const uint8_t* table = reader.skip(tableSize);
+        for (const CompactGlyphMetrics& metrics : decodeGlyphMetrics(table, tableSize, noOfCharacters, encoding, withPage)) {
+            TextureFontCharacter character;
+            character.unicode = metrics.unicode;
+            character.bitmapLeft = metrics.bitmapLeft;
+            character.bitmapTop = metrics.bitmapTop;
+            character.horiAdvance = fromFixed16_16(metrics.horiAdvance);
+            character.vertAdvance = fromFixed16_16(metrics.vertAdvance);
+            character.left = metrics.left;
+            character.top = metrics.top;
+            character.width = metrics.width;
+            character.height = metrics.height;
+            character.face = metrics.face;
+            character.phase = metrics.phase;
+            character.page = metrics.page;
+            variant.characters.push_back(character);
+        }
+        return;
+    }
+
+    size_t recordSize = 44 + (extended ? 3 : 0) + (withPage ? 1 : 0);
+    if (noOfCharacters > reader.getRemaining() / recordSize) {
+        throw std::runtime_error("Texture font file is truncated.");
+    }
+
+    variant.characters.reserve(noOfCharacters);
+    for (uint32_t i = 0; i < noOfCharacters; i++) {
+        TextureFontCharacter character;
+        character.unicode = reader.read<uint32_t>();
+        character.bitmapLeft = reader.read<int32_t>();
+        character.bitmapTop = reader.read<int32_t>();
+        character.horiAdvance = reader.read<double>();
+        character.vertAdvance = reader.read<double>();
+        character.left = reader.read<int32_t>();
+        character.top = reader.read<int32_t>();
+        character.width = reader.read<uint32_t>();
+        character.height = reader.read<uint32_t>();
+        if (extended) {
+            character.face = reader.read<uint16_t>();
+            character.phase = reader.read<uint8_t>();
+        }
+        if (withPage) {
+            character.page = reader.read<uint8_t>();
+        }
+        variant.characters.push_back(character);
+    }
+}
+
+void TextureFontReader::parseBinary() {
+    ByteReader reader(m_data, m_size);
+    reader.skip(6);
+
+    m_formatVersion = reader.read<uint16_t>();
+    if (m_formatVersion != LEGACY_FORMAT_VERSION && m_formatVersion != EXTENDED_FORMAT_VERSION) {
+        std::stringstream errorText;
+        errorText << "Unsupported version " << m_formatVersion << " of the binary texture font format.";
+        throw std::runtime_error(errorText.str());
+    }
+
+    m_fontName = reader.readString();
+    m_width = reader.read<uint32_t>();
+    m_height = reader.read<uint32_t>();
+
+    if (m_formatVersion == LEGACY_FORMAT_VERSION) {
+        size_t size = getImageSize(m_width, m_height, 1);
+        size_t offset = reader.getPosition();
+        reader.skip(size);
+        m_levels.push_back({m_width, m_height, offset, size, nullptr});
+
+        TextureFontVariant variant;
+        variant.fontName = m_fontName;
+        variant.faceNames.push_back(m_fontName);
+        readCharacterTable(reader, variant, false, false, MetricsEncoding::Plain);
+        m_variants.push_back(variant);
+        return;
+    }
+
+    m_channels = reader.read<uint8_t>();
+    m_blockFormat = reader.read<BlockFormat>();
+    if (m_channels < 1 || m_channels > 4) {
+        throw std::runtime_error("Texture font file contains an invalid number of channels.");
+    }
+    if (m_blockFormat != BlockFormat::None && (m_blockFormat > BlockFormat::EacR11 || m_channels != 1)) {
+        throw std::runtime_error("Texture font file contains an invalid block compression.");
+    }
+    m_formatFeatures = reader.read<uint32_t>();
+    checkFormatFeatures();
+
+    auto addLevel = [&](uint32_t width, uint32_t height) {
+        size_t size = getImageSize(width, height, m_channels);
+        if (m_blockFormat != BlockFormat::None) {
+            size = getCompressedSize(width, height, m_blockFormat);
+        }
+        size_t offset = reader.getPosition();
+        reader.skip(size);
+        m_levels.push_back({width, height, offset, size, nullptr});
+    };
+    addLevel(m_width, m_height);
+
+    m_padding = reader.read<uint16_t>();
+    m_extrude = reader.read<uint16_t>();
+
+    uint8_t noOfMipLevels = reader.read<uint8_t>();
+    if (noOfMipLevels < 1) {
+        throw std::runtime_error("Texture font file contains an invalid number of mip maps.");
+    }
+    for (uint32_t level = 1; level < noOfMipLevels; level++) {
+        uint32_t width = reader.read<uint32_t>();
+        uint32_t height = reader.read<uint32_t>();
+        if (width != std::max(1u, m_levels.back().width / 2) || height != std::max(1u, m_levels.back().height / 2)) {
+            throw std::runtime_error("Texture font file contains a mip map of invalid size.");
+        }
+        addLevel(width, height);
+    }
+
+    if (m_formatFeatures & FORMAT_FEATURE_COLOR_PAGE) {
+        m_colorPage.width = reader.read<uint32_t>();
+        m_colorPage.height = reader.read<uint32_t>();
+        if (m_colorPage.width == 0 || m_colorPage.height == 0) {
+            throw std::runtime_error("Texture font file contains a color page of invalid size.");
+        }
+        m_colorPage.size = getImageSize(m_colorPage.width, m_colorPage.height, 4);
+        m_colorPage.offset = reader.getPosition();
+        reader.skip(m_colorPage.size);
+    }
+
+    m_metricsEncoding = reader.read<MetricsEncoding>();
+    if (m_metricsEncoding > MetricsEncoding::CompactDelta) {
+        throw std::runtime_error("Texture font file contains an invalid metrics encoding.");
+    }
+
+    uint32_t noOfVariants = reader.read<uint32_t>();
+    if (noOfVariants < 1) {
+        throw std::runtime_error("Texture font file contains no font variant.");
+    }
+    for (uint32_t i = 0; i < noOfVariants; i++) {
+        TextureFontVariant variant;
+        variant.fontName = reader.readString();
+        variant.fontSize = reader.read<double>();
+        variant.antiAliased = reader.read<uint8_t>();
+        variant.hinted = reader.read<uint8_t>();
+
+        uint32_t noOfFaces = reader.read<uint32_t>();
+        for (uint32_t face = 0; face < noOfFaces; face++) {
+            variant.faceNames.push_back(reader.readString());
+        }
+        variant.subpixelPhases = reader.read<uint8_t>();
+        variant.lcd = reader.read<uint8_t>();
+
+        readCharacterTable(reader, variant, true, hasColorPage(), m_metricsEncoding);
+        m_variants.push_back(variant);
+    }
+}
+
+void TextureFontReader::parseSimple() {
+    ByteReader reader(m_data, m_size);
+    reader.skip(6);
+
+    m_formatVersion = reader.read<uint16_t>();
+    if (m_formatVersion != 1) {
+        std::stringstream errorText;
+        errorText << "Unsupported version " << m_formatVersion << " of the simple texture font format.";
+        throw std::runtime_error(errorText.str());
+    }
+
+    m_width = reader.read<uint16_t>();
+    m_height = reader.read<uint16_t>();
+
+    size_t size = getImageSize(m_width, m_height, 1);
+    size_t offset = reader.getPosition();
+    reader.skip(size);
+    m_levels.push_back({m_width, m_height, offset, size, nullptr});
+
+    TextureFontVariant variant;
+    uint16_t noOfCharacters = reader.read<uint16_t>();
+    for (uint32_t i = 0; i < noOfCharacters; i++) {
+        TextureFontCharacter character;
+        character.unicode = reader.read<uint8_t>();
+        character.bitmapLeft = reader.read<int16_t>();
+        character.bitmapTop = reader.read<int16_t>();
+        character.horiAdvance = reader.read<int16_t>();
+        character.vertAdvance = reader.read<int16_t>();
+        character.left = reader.read<int16_t>();
+        character.top = reader.read<int16_t>();
+        character.width = reader.read<int16_t>();
+        character.height = reader.read<int16_t>();
+        variant.characters.push_back(character);
+    }
+    m_variants.push_back(variant);
+}
+
+/*! \brief reads the JSON character table of a font variant */
+static void readJsonCharacters(const nlohmann::json& characters, TextureFontVariant& variant, bool extended, bool withPage) {
+    for (const nlohmann::json& json : characters) {
+        TextureFontCharacter character;
+        character.unicode = json.at("unicode").get<uint32_t>();
+        character.bitmapLeft = json.at("bitmap_left").get<int32_t>();
+        character.bitmapTop = json.at("bitmap_top").get<int32_t>();
+        character.horiAdvance = json.at("hori_advance").get<double>();
+        character.vertAdvance = json.at("vert_advance").get<double>();
+        character.left = json.at("left").get<int32_t>();
+        character.top = json.at("top").get<int32_t>();
+        character.width = json.at("width").get<uint32_t>();
+        character.height = json.at("height").get<uint32_t>();
+        if (extended) {
+            character.face = json.at("face").get<uint32_t>();
+            character.phase = json.at("phase").get<uint32_t>();
+        }
+        if (withPage) {
+            character.page = json.at("page").get<uint32_t>();
+        }
+        variant.characters.push_back(character);
+    }
+}
+
+void TextureFontReader::parseJson() {
+    // the JSON library reports malformed documents and wrong types with its own exceptions
+    try {
+        nlohmann::json json = nlohmann::json::parse(m_data, m_data + m_size);
+
+        if (json.at("format").get<std::string>() != "ytf252") {
+            throw std::runtime_error("Unknown texture font file format.");
+        }
+        m_formatVersion = json.at("format_version").get<uint16_t>();
+        if (m_formatVersion != LEGACY_FORMAT_VERSION && m_formatVersion != EXTENDED_FORMAT_VERSION) {
+            std::stringstream errorText;
+            errorText << "Unsupported version " << m_formatVersion << " of the JSON texture font format.";
+            throw std::runtime_error(errorText.str());
+        }
+
+        m_fontName = json.at("font_name").get<std::string>();
+        m_width = json.at("image_width").get<uint32_t>();
+        m_height = json.at("image_height").get<uint32_t>();
+        getImageSize(m_width, m_height, 1);
+        m_levels.push_back({m_width, m_height, 0, 0, nullptr});
+        m_pngData.push_back(fromBase64(json.at("image_data_png").get<std::string>()));
+
+        if (m_formatVersion == LEGACY_FORMAT_VERSION) {
+            TextureFontVariant variant;
+            variant.fontName = m_fontName;
+            variant.faceNames.push_back(m_fontName);
+            readJsonCharacters(json.at("characters"), variant, false, false);
+            m_variants.push_back(variant);
+            return;
+        }
+
+        m_formatFeatures = json.at("features").get<uint32_t>();
+        checkFormatFeatures();
+        m_channels = json.at("image_channels").get<uint32_t>();
+        m_padding = json.at("padding").get<uint32_t>();
+        m_extrude = json.at("extrude").get<uint32_t>();
+        for (const nlohmann::json& mipMap : json.at("mip_maps")) {
+            uint32_t width = mipMap.at("width").get<uint32_t>();
+            uint32_t height = mipMap.at("height").get<uint32_t>();
+            getImageSize(width, height, 1);
+            m_levels.push_back({width, height, 0, 0, nullptr});
+            m_pngData.push_back(fromBase64(mipMap.at("image_data_png").get<std::string>()));
+        }
+        if (m_formatFeatures & FORMAT_FEATURE_COLOR_PAGE) {
+            const nlohmann::json& colorPage = json.at("color_page");
+            m_colorPage.width = colorPage.at("width").get<uint32_t>();
+            m_colorPage.height = colorPage.at("height").get<uint32_t>();
+            m_colorPagePng = fromBase64(colorPage.at("image_data_png").get<std::string>());
+            if (m_colorPage.width == 0 || m_colorPage.height == 0) {
+                throw std::runtime_error("Texture font file contains a color page of invalid size.");
+            }
+            getImageSize(m_colorPage.width, m_colorPage.height, 4);
+        }
+
+        for (const nlohmann::json& jsonVariant : json.at("variants")) {
+            TextureFontVariant variant;
+            variant.fontName = jsonVariant.at("font_name").get<std::string>();
+            variant.fontSize = jsonVariant.at("font_size").get<double>();
+            variant.antiAliased = jsonVariant.at("anti_aliased").get<bool>();
+            variant.hinted = jsonVariant.at("hinted").get<bool>();
+            variant.faceNames = jsonVariant.at("faces").get<std::vector<std::string>>();
+            variant.subpixelPhases = jsonVariant.at("subpixel_phases").get<uint32_t>();
+            variant.lcd = jsonVariant.at("lcd").get<bool>();
+            readJsonCharacters(jsonVariant.at("characters"), variant, true, hasColorPage());
+            m_variants.push_back(variant);
+        }
+        if (m_variants.empty()) {
+            throw std::runtime_error("Texture font file contains no font variant.");
+        }
+    } catch (const nlohmann::json::exception& e) {
+        std::stringstream errorText;
+        errorText << "Texture font file contains invalid JSON: " << e.what();
+        throw std::runtime_error(errorText.str());
+    }
+}
+
+void TextureFontReader::checkFormatFeatures() {
+    if (m_formatFeatures & ~FORMAT_FEATURES_KNOWN) {
+        std::stringstream errorText;
+        errorText << "Texture font file uses unsupported features 0x" << std::hex << (m_formatFeatures & ~FORMAT_FEATURES_KNOWN) << ".";
+        throw std::runtime_error(errorText.str());
+    }
+}
+
+void TextureFontReader::checkCharacters() {
+    for (const TextureFontVariant& variant : m_variants) {
+        if (variant.subpixelPhases < 1 || variant.subpixelPhases > 64) {
+            throw std::runtime_error("Texture font file contains an invalid number of sub pixel phases.");
+        }
+
+        for (const TextureFontCharacter& character : variant.characters) {
+            if (character.page > 1 || (character.page == 1 && !hasColorPage())) {
+                std::stringstream errorText;
+                errorText << "Character " << character.unicode << " refers to an invalid page.";
+                throw std::runtime_error(errorText.str());
+            }
+            uint32_t width = (character.page == 1) ? m_colorPage.width : m_width;
+            uint32_t height = (character.page == 1) ? m_colorPage.height : m_height;
+            if (character.left < 0 || character.top < 0
+                    || static_cast<int64_t>(character.left) + character.width > width
+                    || static_cast<int64_t>(character.top) + character.height > height) {
+                std::stringstream errorText;
+                errorText << "Character " << character.unicode << " lies outside of the image.";
+                throw std::runtime_error(errorText.str());
+            }
+            if (character.phase >= variant.subpixelPhases || (!variant.faceNames.empty() && character.face >= variant.faceNames.size())) {
+                std::stringstream errorText;
+                errorText << "Character " << character.unicode << " refers to an invalid font face or sub pixel phase.";
+                throw std::runtime_error(errorText.str());
+            }
+        }
+    }
+}
+
+std::vector<uint8_t> TextureFontReader::getPixelData(uint32_t level) {
+    const ImageLevel& imageLevel = m_levels.at(level);
+    return std::vector<uint8_t>(m_data + imageLevel.offset, m_data + imageLevel.offset + imageLevel.size);
+}
+
+std::shared_ptr<ColorImage> TextureFontReader::getImage(uint32_t level) {
+    ImageLevel& imageLevel = m_levels.at(level);
+    if (m_format != TextureFontFormat::Json && m_blockFormat != BlockFormat::None) {
+        throw std::runtime_error("Block compressed images cannot be decoded, use getPixelData().");
+    }
+    return decodeImage(imageLevel, m_channels, (m_format == TextureFontFormat::Json) ? &m_pngData.at(level) : nullptr);
+}
+
+std::shared_ptr<ColorImage> TextureFontReader::getColorPage() {
+    if (!hasColorPage()) {
+        throw std::runtime_error("The texture font has no color page.");
+    }
+    return decodeImage(m_colorPage, 4, (m_format == TextureFontFormat::Json) ? &m_colorPagePng : nullptr);
+}
+
+std::shared_ptr<ColorImage> TextureFontReader::decodeImage(ImageLevel& imageLevel, uint32_t channels, const std::vector<uint8_t>* png) {
+    if (imageLevel.image) {
+        return imageLevel.image;
+    }
+
+    if (png) {
+        std::shared_ptr<ColorImage> image = decodePng(png->data(), png->size());
+        if (image->getWidth() != imageLevel.width || image->getHeight() != imageLevel.height || image->getChannels() != channels) {
+            throw std::runtime_error("The size of the image does not match the texture font.");
+        }
+        imageLevel.image = image;
+        return image;
+    }
+
+    std::shared_ptr<ColorImage> image(new ColorImage(imageLevel.width, imageLevel.height, channels));
+    size_t rowLength = static_cast<size_t>(imageLevel.width) * channels;
+    for (uint32_t row = 0; row < imageLevel.height; row++) {
+        memcpy(image->getRow(row), m_data + imageLevel.offset + static_cast<size_t>(row) * rowLength, rowLength);
+    }
+    imageLevel.image = image;
+    return image;
+}
+
+std::shared_ptr<GrayImage> TextureFontReader::getGrayImage(uint32_t level) {
+    return getImage(level)->getGrayImage();
+}
+
+void TextureFontReader::validate() {
+    if (hasColorPage()) {
+        getColorPage();
+    }
+    if (m_blockFormat != BlockFormat::None) {
+        return; // sizes of compressed data have been checked while parsing
+    }
+    for (uint32_t level = 0; level < getMipLevelCount(); level++) {
+        getImage(level);
+    }
+}
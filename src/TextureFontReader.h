@@ -0,0 +1,198 @@
+/*
+ * TextureFontReader.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef TEXTUREFONTREADER_H_
+#define TEXTUREFONTREADER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <filesystem>
+
+#include "GrayImage.h"
+#include "ColorImage.h"
+#include "GlyphMetrics.h"
+#include "BlockCompression.h"
+
+class MappedFile;
+
+/*! \brief File formats of texture fonts */
+enum class TextureFontFormat {
+    Binary, //!< ytf252 binary format written by TextureFontCreator::writeToFile()
+    Simple, //!< stf252 format written by TextureFontCreator::writeToSimpleFile()
+    Json    //!< JSON format written by TextureFontCreator::writeToJsonFile()
+};
+
+/*! \brief version of the binary and JSON format for a single font variant without mip maps */
+constexpr uint16_t LEGACY_FORMAT_VERSION = 4;
+
+/*! \brief version of the binary and JSON format supporting several font variants, mip maps,
+ *         block compression, compact metrics and the optional features below */
+constexpr uint16_t EXTENDED_FORMAT_VERSION = 5;
+
+/*! \brief the file contains a color page, and every character the page it is stored in
+ *
+ *  Optional features of the extended format are stored as a bit mask in
+ *  the header, readers reject files using features they do not know.
+ */
+constexpr uint32_t FORMAT_FEATURE_COLOR_PAGE = 1 << 0;
+constexpr uint32_t FORMAT_FEATURES_KNOWN = FORMAT_FEATURE_COLOR_PAGE; //!< all features this version of the reader supports
+
+/*! \brief A character read from a texture font file */
+struct TextureFontCharacter {
+    uint32_t unicode; //!< unicode codepoint, for the simple format the code of the character in the code page of the file
+    int32_t bitmapLeft; //!< left bearing of the character
+    int32_t bitmapTop; //!< top bearing of the character
+    double horiAdvance; //!< horizontal advance of the character
+    double vertAdvance; //!< vertical advance of the character
+    int32_t left; //!< left offset of the character in the image
+    int32_t top; //!< top offset of the character in the image
+    uint32_t width; //!< width of the character
+    uint32_t height; //!< height of the character
+    uint32_t face = 0; //!< index of the font face the character was rendered from
+    uint32_t phase = 0; //!< sub pixel phase of the character
+    uint32_t page = 0; //!< 1 if the character is stored in the color page
+};
+
+/*! \brief A font variant read from a texture font file */
+struct TextureFontVariant {
+    std::string fontName;
+    double fontSize = 0; //!< size of the font in pixels, 0 if not stored in the file
+    bool antiAliased = true;
+    bool hinted = true;
+    std::vector<std::string> faceNames;
+    uint32_t subpixelPhases = 1;
+    bool lcd = false;
+    std::vector<TextureFontCharacter> characters;
+};
+
+/*! \brief Reader for texture font files
+ *
+ *  Reads the binary format in the legacy and the extended version, the simple format in
+ *  version 1 and the JSON format. All offsets and sizes are checked against
+ *  the size of the file, and all characters are checked to lie inside of
+ *  the image, so a successfully constructed reader describes a valid
+ *  texture font. Malformed files cause an exception.
+ *
+ *  Binary files are memory mapped and only the metrics are parsed on
+ *  construction, the pixels are read (or, for JSON files, decoded) the
+ *  first time an image is requested.
+ */
+class TextureFontReader {
+public:
+    /*! \brief reads a texture font file, the format is detected from its content */
+    TextureFontReader(const std::filesystem::path& path);
+
+    /*! \brief reads a texture font from memory
+     *
+     *  \param data the content of a texture font file, it is copied
+     *  \param size size of the data in bytes
+     */
+    TextureFontReader(const uint8_t* data, size_t size);
+
+    virtual ~TextureFontReader();
+
+    TextureFontFormat getFormat() { return m_format; }
+    uint16_t getFormatVersion() { return m_formatVersion; }
+    uint32_t getFormatFeatures() { return m_formatFeatures; } //!< bit mask of FORMAT_FEATURE_ flags, 0 for other than the extended version
+    std::string getFontName() { return m_fontName; }
+
+    uint32_t getWidth() { return m_width; }
+    uint32_t getHeight() { return m_height; }
+    uint32_t getChannels() { return m_channels; }
+    BlockFormat getBlockFormat() { return m_blockFormat; }
+    MetricsEncoding getMetricsEncoding() { return m_metricsEncoding; }
+    uint32_t getPadding() { return m_padding; }
+    uint32_t getExtrude() { return m_extrude; }
+
+    /*! \brief returns the number of images in the mip chain, including the full size image */
+    uint32_t getMipLevelCount() { return m_levels.size(); }
+    uint32_t getMipLevelWidth(uint32_t level) { return m_levels.at(level).width; }
+    uint32_t getMipLevelHeight(uint32_t level) { return m_levels.at(level).height; }
+
+    /*! \brief returns true if the file contains a color page, see FORMAT_FEATURE_COLOR_PAGE */
+    bool hasColorPage() { return m_colorPage.width > 0; }
+    uint32_t getColorPageWidth() { return m_colorPage.width; }
+    uint32_t getColorPageHeight() { return m_colorPage.height; }
+
+    /*! \brief returns the premultiplied RGBA image of the color glyphs, throws if there is no color page */
+    std::shared_ptr<ColorImage> getColorPage();
+
+    /*! \brief returns the font variants, only files in the extended version can contain several variants */
+    const std::vector<TextureFontVariant>& getVariants() { return m_variants; }
+
+    /*! \brief returns the stored pixel data of an image of the mip chain
+     *
+     *  For block compressed images these are the compressed blocks,
+     *  otherwise the interleaved pixels. JSON files do not store raw pixel
+     *  data, an empty vector is returned for them.
+     */
+    std::vector<uint8_t> getPixelData(uint32_t level = 0);
+
+    /*! \brief returns an uncompressed image of the mip chain
+     *
+     *  Images with several channels are returned with one channel per color,
+     *  see getGrayImage() for a grayscale version. Block compressed images
+     *  cannot be decoded and cause an exception.
+     */
+    std::shared_ptr<ColorImage> getImage(uint32_t level = 0);
+
+    /*! \brief returns an image of the mip chain as grayscale image, the maximum of all channels is used */
+    std::shared_ptr<GrayImage> getGrayImage(uint32_t level = 0);
+
+    /*! \brief reads all images, throws if the pixel data is invalid */
+    void validate();
+
+private:
+    /*! \brief position of an image of the mip chain in the file */
+    struct ImageLevel {
+        uint32_t width;
+        uint32_t height;
+        size_t offset;
+        size_t size;
+        std::shared_ptr<ColorImage> image; //!< the decoded image, created on first access
+    };
+
+    void parse();
+    void parseBinary();
+    void parseSimple();
+    void parseJson();
+    void checkFormatFeatures(); //!< throws if the file uses features unknown to the reader
+    void checkCharacters();
+
+    /*! \brief decodes an image of the file
+     *
+     *  \param channels number of channels of the image
+     *  \param png PNG image of JSON files, nullptr for binary files
+     */
+    std::shared_ptr<ColorImage> decodeImage(ImageLevel& imageLevel, uint32_t channels, const std::vector<uint8_t>* png);
+
+    std::unique_ptr<MappedFile> m_file;
+    std::vector<uint8_t> m_buffer; //!< content of files read from memory
+    const uint8_t* m_data;
+    size_t m_size;
+
+    TextureFontFormat m_format;
+    uint16_t m_formatVersion;
+    uint32_t m_formatFeatures;
+    std::string m_fontName;
+    uint32_t m_width;
+    uint32_t m_height;
+    uint32_t m_channels;
+    BlockFormat m_blockFormat;
+    MetricsEncoding m_metricsEncoding;
+    uint32_t m_padding;
+    uint32_t m_extrude;
+    std::vector<ImageLevel> m_levels;
+    std::vector<std::vector<uint8_t>> m_pngData; //!< PNG images of JSON files, one per mip level
+    ImageLevel m_colorPage; //!< color page, its width is 0 if the file has no color page
+    std::vector<uint8_t> m_colorPagePng; //!< PNG image of the color page of JSON files
+    std::vector<TextureFontVariant> m_variants;
+};
+
+#endif /* TEXTUREFONTREADER_H_ */
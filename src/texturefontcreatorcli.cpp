@@ -0,0 +1,499 @@
+/*
+ * texturefontcreatorcli.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <filesystem>
+
+#include <pthread.h>
+
+#include "AtlasJob.h"
+#include "AtlasReport.h"
+#include "AtlasServer.h"
+#include "BatchBuilder.h"
+#include "BuildManifest.h"
+#include "FileWatcher.h"
+#include "FontSession.h"
+#include "Instrumentation.h"
+#include "character_sets.h"
+
+namespace { // anonymous namespace
+
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options] FONT\n"
+              << "       " << program << " [options] --batch FILE\n"
+              << "       " << program << " [options] --serve SOCKET\n"
+              << "       " << program << " [options] --analyze ATLAS\n"
+              << "Creates a texture font from a TrueType font.\n"
+              << "\n"
+              << "Options:\n"
+              << "  -o, --output FILE     output file, the format is chosen by the extension\n"
+              << "                        (.ytf, .stf, .json, .png, .dds or .ktx), default font.ytf\n"
+              << "  -s, --size PIXELS     font size in pixels, default 16\n"
+              << "  -c, --chars TEXT      characters to render, default all printable ASCII characters\n"
+              << "      --charset FILE    read the characters to render from a UTF-8 file\n"
+              << "      --fallback FONT   font used for characters missing in FONT, may be repeated\n"
+              << "      --face-index N    face of FONT to use if it is a font collection (TTC), default 0\n"
+              << "      --instance SPEC   instance of FONT if it is a variable font, a named instance and/or\n"
+              << "                        axis values, e.g. \"Bold\", \"wght=650\" or \"Condensed,wght=300\".\n"
+              << "                        May be repeated to build a texture font per instance from one\n"
+              << "                        loaded font, the instance is appended to the output file name\n"
+              << "      --list-instances  print the named instances of FONT\n"
+              << "      --no-antialiasing render characters without anti aliasing\n"
+              << "      --no-hinting      render characters without hinting\n"
+              << "      --power-of-two    force the image size to a power of two\n"
+              << "      --optimize-packing\n"
+              << "                        search the smallest image with several packing algorithms\n"
+              << "      --optimize-time MS\n"
+              << "                        time the search for the smallest image may take, default no limit\n"
+              << "      --streaming       render the characters straight into the image in a second pass,\n"
+              << "                        bounds the memory of texture fonts with very many characters\n"
+              << "      --batch FILE      build all texture fonts described in a JSON file\n"
+              << "      --manifest FILE   skip texture fonts whose inputs did not change since they were\n"
+              << "                        recorded in FILE, default FILE.manifest for --batch FILE\n"
+              << "      --no-manifest     always build and do not write a manifest\n"
+              << "      --force           build all texture fonts and update the manifest\n"
+              << "      --watch           keep running and rebuild texture fonts when their fonts or\n"
+              << "                        character sets change\n"
+              << "      --debounce MS     time to wait for further changes before rebuilding, default 200\n"
+              << "      --threads N       number of threads building texture fonts, default all cores\n"
+              << "      --memory-budget MB\n"
+              << "                        estimated memory texture fonts built at the same time may use,\n"
+              << "                        default no limit\n"
+              << "      --serve SOCKET    build texture fonts for clients connecting to a Unix domain socket\n"
+              << "      --workers N       number of threads building texture fonts for clients, default all cores\n"
+              << "      --cache-size MB   size of the cache of built texture fonts, default 256\n"
+              << "      --server SOCKET   request the texture font from a server instead of building it,\n"
+              << "                        the output has to be a .ytf, .stf or .json file\n"
+              << "      --analyze ATLAS   print a JSON report on the packing of a texture font file and on\n"
+              << "                        the tiles touched when rendering the corpus, -o writes it to a file\n"
+              << "      --corpus FILE     UTF-8 text laid out by --analyze, every line is a string\n"
+              << "      --tile-size N     size of the tiles of --analyze in pixels, default 64\n"
+              << "      --cache-tiles N   number of tiles of the texture cache simulated by --analyze, default 16\n"
+              << "      --stats           print the time spent in every stage and the counters\n"
+              << "      --trace FILE      write the time spent in every stage as Chrome trace event JSON\n"
+              << "  -h, --help            show this help\n";
+}
+
+/*! \brief builds the selected texture fonts in parallel, failed jobs are reported and skipped
+ *
+ *  \return an error message for every job, empty for jobs built successfully
+ */
+std::vector<std::string> buildJobs(const std::vector<AtlasJob>& jobs, const std::vector<bool>& selected, const std::vector<std::shared_ptr<GlyphCache>>& glyphCaches,
+                                   const BatchOptions& options, bool& failed) {
+    std::vector<std::string> errors = buildBatch(jobs, options, selected, glyphCaches);
+    for (size_t index = 0; index < jobs.size(); index++) {
+        if (!selected[index]) {
+            continue;
+        }
+        if (errors[index].empty()) {
+            std::cout << "Wrote " << jobs[index].output.native() << std::endl;
+        } else {
+            std::cerr << "Error building " << jobs[index].output.native() << ": " << errors[index] << std::endl;
+            failed = true;
+        }
+    }
+    return errors;
+}
+
+/*! \brief rebuilds the texture fonts whose input files change, never returns */
+[[noreturn]] void watchJobs(std::vector<AtlasJob> jobs, const std::filesystem::path& batchPath, std::chrono::milliseconds debounce,
+                            const BatchOptions& options, bool printStats) {
+    // the fonts are edited while they are watched, mapped fonts could be truncated while they are used
+    FontSession::setCopyFiles(true);
+
+    std::vector<std::shared_ptr<GlyphCache>> glyphCaches;
+    auto createGlyphCaches = [&]() {
+        glyphCaches.clear();
+        for (size_t index = 0; index < jobs.size(); index++) {
+            glyphCaches.push_back(std::make_shared<GlyphCache>());
+        }
+    };
+    createGlyphCaches();
+
+    // the watcher is kept while the jobs stay the same, so changes made during a build are not lost
+    std::unique_ptr<FileWatcher> watcher;
+    auto createWatcher = [&]() {
+        std::vector<std::filesystem::path> watchedFiles;
+        if (!batchPath.empty()) {
+            watchedFiles.push_back(batchPath);
+        }
+        for (const AtlasJob& job : jobs) {
+            std::vector<std::filesystem::path> inputFiles = job.getInputFiles();
+            watchedFiles.insert(watchedFiles.end(), inputFiles.begin(), inputFiles.end());
+        }
+        watcher = std::make_unique<FileWatcher>(watchedFiles);
+    };
+    createWatcher();
+
+    // only the characters whose glyphs changed are rendered again after a font changed,
+    // the hashes of the glyphs are recorded before every build to compare them afterwards
+    auto removeChangedCharacters = [&](const std::vector<bool>& selected) {
+        for (size_t index = 0; index < jobs.size(); index++) {
+            if (!selected[index]) {
+                continue;
+            }
+            try {
+                size_t removed = glyphCaches[index]->removeChangedCharacters(getFontVariant(jobs[index]));
+                Instrumentation::addCount("glyphs changed", removed);
+            } catch (std::exception&) {
+                // building the job reports the error
+                glyphCaches[index]->clear();
+            }
+        }
+    };
+
+    bool failed = false;
+    std::vector<bool> all(jobs.size(), true);
+    removeChangedCharacters(all);
+    buildJobs(jobs, all, glyphCaches, options, failed);
+
+    while (true) {
+        std::set<std::filesystem::path> changed = watcher->waitForChanges(debounce);
+
+        std::vector<bool> selected(jobs.size(), false);
+        if (changed.count(batchPath)) {
+            try {
+                jobs = readBatchFile(batchPath);
+            } catch (std::exception& e) {
+                std::cerr << "Error: " << e.what() << std::endl;
+                continue;
+            }
+            createGlyphCaches();
+            createWatcher();
+            selected.assign(jobs.size(), true);
+        } else {
+            for (size_t index = 0; index < jobs.size(); index++) {
+                for (const std::filesystem::path& file : jobs[index].getInputFiles()) {
+                    if (changed.count(file)) {
+                        selected[index] = true;
+                    }
+                }
+            }
+        }
+
+        Instrumentation::reset();
+        removeChangedCharacters(selected);
+        buildJobs(jobs, selected, glyphCaches, options, failed);
+        if (printStats) {
+            std::cout << Instrumentation::getSummary() << std::flush;
+        }
+    }
+}
+
+/*! \brief runs a server until SIGINT or SIGTERM is received */
+void serve(const std::filesystem::path& socketPath, uint32_t workers, size_t cacheSize) {
+    // fonts replaced in place while the server runs must not crash it
+    FontSession::setCopyFiles(true);
+
+    // the signals are handled by a thread waiting for them, so the server
+    // can be stopped cleanly and removes its socket
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    AtlasServer server(socketPath, workers, cacheSize);
+    std::thread signalThread([&server, signals]() {
+        int signal;
+        sigwait(&signals, &signal);
+        server.stop();
+    });
+
+    std::cout << "Listening on " << socketPath.native() << std::endl;
+    try {
+        server.run();
+    } catch (...) {
+        pthread_kill(signalThread.native_handle(), SIGTERM);
+        signalThread.join();
+        throw;
+    }
+    signalThread.join();
+}
+
+/*! \brief returns the texture font format for the extension of a file */
+TextureFontFormat getFormatForPath(const std::filesystem::path& path) {
+    std::string extension = path.extension().string();
+    if (extension == ".ytf") {
+        return TextureFontFormat::Binary;
+    } else if (extension == ".stf") {
+        return TextureFontFormat::Simple;
+    } else if (extension == ".json") {
+        return TextureFontFormat::Json;
+    }
+    std::stringstream errorText;
+    errorText << "Servers only deliver .ytf, .stf and .json files, not \"" << path.native() << "\".";
+    throw std::runtime_error(errorText.str());
+}
+
+/*! \brief requests the texture font of a job from a server and writes it */
+void requestJob(const std::filesystem::path& socketPath, const AtlasJob& job) {
+    std::vector<uint8_t> data = requestTextureFont(socketPath, job, getFormatForPath(job.output));
+    writeFileAtomically(job.output, [&data](const std::filesystem::path& path) {
+        std::fstream fp(path, std::fstream::out | std::fstream::binary);
+        if (fp.fail()) {
+            std::stringstream errorText;
+            errorText << "Could not open file \"" << path.native() << "\" for writing. Aborting...";
+            throw std::runtime_error(errorText.str());
+        }
+        fp.write(reinterpret_cast<const char*>(data.data()), data.size());
+        fp.close();
+        if (fp.fail()) {
+            std::stringstream errorText;
+            errorText << "Could not write file \"" << path.native() << "\". Aborting...";
+            throw std::runtime_error(errorText.str());
+        }
+    });
+    std::cout << "Wrote " << job.output.native() << std::endl;
+}
+
+} // anonymous namespace
+
+int main(int argc, char *argv[])
+{
+    try {
+        std::filesystem::path tracePath;
+        std::filesystem::path batchPath;
+        bool printStats = false;
+        bool watch = false;
+        std::chrono::milliseconds debounce(200);
+        std::filesystem::path serveSocket;
+        std::filesystem::path serverSocket;
+        uint32_t workers = 0;
+        size_t cacheSize = 256;
+        BatchOptions batchOptions;
+        std::filesystem::path manifestPath;
+        bool useManifest = true;
+        bool force = false;
+        std::vector<FontVariation> instances;
+        bool listInstances = false;
+        std::filesystem::path analyzePath;
+        std::filesystem::path corpusPath;
+        AtlasReportOptions reportOptions;
+        bool outputGiven = false;
+
+        AtlasJob job;
+        job.output = "font.ytf";
+        job.chars = CHAR_SET_ASCII;
+
+        for (int i = 1; i < argc; i++) {
+            std::string argument = argv[i];
+            auto nextArgument = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    std::stringstream errorText;
+                    errorText << "Option " << argument << " requires a value.";
+                    throw std::runtime_error(errorText.str());
+                }
+                return argv[++i];
+            };
+
+            if (argument == "-h" || argument == "--help") {
+                printUsage(argv[0]);
+                return 0;
+            } else if (argument == "-o" || argument == "--output") {
+                job.output = nextArgument();
+                outputGiven = true;
+            } else if (argument == "-s" || argument == "--size") {
+                job.fontSize = std::stod(nextArgument());
+            } else if (argument == "-c" || argument == "--chars") {
+                std::string chars = nextArgument();
+                job.chars = std::u8string(chars.begin(), chars.end());
+            } else if (argument == "--charset") {
+                job.chars.clear();
+                job.charsetPath = nextArgument();
+            } else if (argument == "--fallback") {
+                job.fallbackFontpaths.push_back(nextArgument());
+            } else if (argument == "--face-index") {
+                job.faceIndex = std::stoul(nextArgument());
+            } else if (argument == "--instance") {
+                instances.push_back(parseFontVariation(nextArgument()));
+            } else if (argument == "--list-instances") {
+                listInstances = true;
+            } else if (argument == "--no-antialiasing") {
+                job.enableAntiAliasing = false;
+            } else if (argument == "--no-hinting") {
+                job.enableHinting = false;
+            } else if (argument == "--power-of-two") {
+                job.forcePowerOfTwo = true;
+            } else if (argument == "--optimize-packing") {
+                job.optimizePacking = true;
+            } else if (argument == "--optimize-time") {
+                job.optimizeTimeLimit = std::stoul(nextArgument());
+            } else if (argument == "--streaming") {
+                job.streaming = true;
+            } else if (argument == "--batch") {
+                batchPath = nextArgument();
+            } else if (argument == "--manifest") {
+                manifestPath = nextArgument();
+            } else if (argument == "--no-manifest") {
+                useManifest = false;
+            } else if (argument == "--force") {
+                force = true;
+            } else if (argument == "--watch") {
+                watch = true;
+            } else if (argument == "--debounce") {
+                debounce = std::chrono::milliseconds(std::stoul(nextArgument()));
+            } else if (argument == "--threads") {
+                batchOptions.threads = std::stoul(nextArgument());
+            } else if (argument == "--memory-budget") {
+                batchOptions.memoryBudget = std::stoull(nextArgument()) * 1024 * 1024;
+            } else if (argument == "--serve") {
+                serveSocket = nextArgument();
+            } else if (argument == "--workers") {
+                workers = std::stoul(nextArgument());
+            } else if (argument == "--cache-size") {
+                cacheSize = std::stoull(nextArgument());
+            } else if (argument == "--server") {
+                serverSocket = nextArgument();
+            } else if (argument == "--analyze") {
+                analyzePath = nextArgument();
+            } else if (argument == "--corpus") {
+                corpusPath = nextArgument();
+            } else if (argument == "--tile-size") {
+                reportOptions.tileSize = std::stoul(nextArgument());
+            } else if (argument == "--cache-tiles") {
+                reportOptions.cacheTiles = std::stoul(nextArgument());
+            } else if (argument == "--stats") {
+                printStats = true;
+            } else if (argument == "--trace") {
+                tracePath = nextArgument();
+            } else if (!argument.empty() && argument[0] == '-') {
+                std::stringstream errorText;
+                errorText << "Unknown option " << argument << ".";
+                throw std::runtime_error(errorText.str());
+            } else if (job.fontpath.empty()) {
+                job.fontpath = argument;
+            } else {
+                throw std::runtime_error("Only a single font can be given, use --fallback for further fonts.");
+            }
+        }
+
+        if (!serveSocket.empty()) {
+            Instrumentation::setEnabled(printStats || !tracePath.empty());
+            serve(serveSocket, workers, cacheSize * 1024 * 1024);
+            if (printStats) {
+                std::cout << Instrumentation::getSummary();
+            }
+            if (!tracePath.empty()) {
+                Instrumentation::writeChromeTrace(tracePath);
+            }
+            return 0;
+        }
+
+        if (!analyzePath.empty()) {
+            TextureFontReader reader(analyzePath);
+            std::vector<std::u8string> corpus;
+            if (!corpusPath.empty()) {
+                corpus = readCorpusFile(corpusPath);
+            }
+            std::string report = writeAtlasReport(createAtlasReport(reader, corpus, reportOptions), reportOptions);
+            if (outputGiven) {
+                writeFileAtomically(job.output, [&report](const std::filesystem::path& path) {
+                    std::fstream fp(path, std::fstream::out | std::fstream::binary);
+                    if (fp.fail()) {
+                        std::stringstream errorText;
+                        errorText << "Could not open file \"" << path.native() << "\" for writing. Aborting...";
+                        throw std::runtime_error(errorText.str());
+                    }
+                    fp << report << std::endl;
+                });
+                std::cout << "Wrote " << job.output.native() << std::endl;
+            } else {
+                std::cout << report << std::endl;
+            }
+            return 0;
+        }
+
+        if (listInstances && !job.fontpath.empty()) {
+            FontSession session({job.fontpath}, job.faceIndex);
+            for (const std::string& name : session.getNamedInstances()) {
+                std::cout << name << std::endl;
+            }
+            return 0;
+        }
+
+        std::vector<AtlasJob> jobs;
+        if (!batchPath.empty()) {
+            jobs = readBatchFile(batchPath);
+        } else if (!job.fontpath.empty() && instances.size() > 1) {
+            jobs = expandInstances(job, instances);
+        } else if (!job.fontpath.empty()) {
+            if (!instances.empty()) {
+                job.variation = instances.front();
+            }
+            jobs.push_back(job);
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        Instrumentation::setEnabled(printStats || !tracePath.empty());
+
+        if (watch) {
+            watchJobs(jobs, batchPath, debounce, batchOptions, printStats);
+        }
+
+        if (!serverSocket.empty()) {
+            for (const AtlasJob& job : jobs) {
+                requestJob(serverSocket, job);
+            }
+            return 0;
+        }
+
+        if (manifestPath.empty() && !batchPath.empty()) {
+            manifestPath = batchPath;
+            manifestPath += ".manifest";
+        }
+        std::unique_ptr<BuildManifest> manifest;
+        if (useManifest && !manifestPath.empty()) {
+            manifest = std::make_unique<BuildManifest>(manifestPath);
+        }
+
+        std::vector<bool> selected(jobs.size(), true);
+        if (manifest) {
+            for (size_t index = 0; index < jobs.size(); index++) {
+                if (manifest->isUpToDate(jobs[index]) && !force) {
+                    selected[index] = false;
+                    std::cout << "Up to date " << jobs[index].output.native() << std::endl;
+                }
+            }
+        }
+
+        bool failed = false;
+        std::vector<std::string> errors = buildJobs(jobs, selected, std::vector<std::shared_ptr<GlyphCache>>(), batchOptions, failed);
+
+        if (manifest) {
+            for (size_t index = 0; index < jobs.size(); index++) {
+                if (selected[index] && errors[index].empty()) {
+                    manifest->setBuilt(jobs[index]);
+                }
+            }
+            manifest->write();
+        }
+
+        if (printStats) {
+            std::cout << Instrumentation::getSummary();
+        }
+        if (!tracePath.empty()) {
+            Instrumentation::writeChromeTrace(tracePath);
+        }
+        return failed ? 1 : 0;
+    } catch (std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -1,7 +1,10 @@
 #include "texturefontcreatorgui.h"
 
 #include "FreeTypeRender.h"
+#include "AtlasReport.h"
+#include "QImageConversion.h"
 #include "character_sets.h"
+#include "Instrumentation.h"
 
 #include <QFileDialog>
 #include <QSettings>
@@ -47,6 +50,11 @@ std::shared_ptr<TextureFontCreator> createTextureFont(const GuiParameters& param
         charSets += JAPANESE_JOYO_KANJI;
     }
 
+    // statistics describe the last texture font created while recording
+    if (Instrumentation::isEnabled()) {
+        Instrumentation::reset();
+    }
+
     auto creator = std::make_shared<TextureFontCreator>(
         parameters.fontPath,
         parameters.fontSize,
@@ -87,6 +95,9 @@ TextureFontCreatorGUI::TextureFontCreatorGUI(QWidget *parent)
     m_ui.actionSave_Texture_Font->setIcon(QApplication::style()->standardIcon(QStyle::SP_DialogSaveButton));
     m_ui.actionSave_JSON_File->setIcon(QApplication::style()->standardIcon(QStyle::SP_DialogSaveButton));
     m_ui.actionSave_Simple_Font->setIcon(QApplication::style()->standardIcon(QStyle::SP_DialogSaveButton));
+    m_ui.actionSave_PNG_Image->setIcon(QApplication::style()->standardIcon(QStyle::SP_DialogSaveButton));
+    m_ui.actionSave_Trace->setIcon(QApplication::style()->standardIcon(QStyle::SP_DialogSaveButton));
+    m_ui.actionShow_Statistics->setIcon(QApplication::style()->standardIcon(QStyle::SP_FileDialogInfoView));
     m_ui.actionAbout->setIcon(QApplication::style()->standardIcon(QStyle::SP_MessageBoxInformation));
     m_ui.actionExit->setIcon(QApplication::style()->standardIcon(QStyle::SP_DialogCloseButton));
 
@@ -99,6 +110,10 @@ TextureFontCreatorGUI::TextureFontCreatorGUI(QWidget *parent)
     connect(m_ui.actionSave_Texture_Font, SIGNAL(triggered(bool)), this, SLOT(saveAs()));
     connect(m_ui.actionSave_JSON_File, SIGNAL(triggered(bool)), this, SLOT(saveAsJson()));
     connect(m_ui.actionSave_Simple_Font, SIGNAL(triggered(bool)), this, SLOT(saveAsSimple()));
+    connect(m_ui.actionSave_PNG_Image, SIGNAL(triggered(bool)), this, SLOT(saveAsPng()));
+    connect(m_ui.actionRecord_Trace, SIGNAL(toggled(bool)), this, SLOT(recordTrace(bool)));
+    connect(m_ui.actionShow_Statistics, SIGNAL(triggered(bool)), this, SLOT(showStatistics()));
+    connect(m_ui.actionSave_Trace, SIGNAL(triggered(bool)), this, SLOT(saveTrace()));
 
     connect(m_ui.actionAbout, SIGNAL(triggered(bool)), this, SLOT(showAboutDialog()));
 
@@ -168,8 +183,12 @@ void TextureFontCreatorGUI::updatePreview()
 
     std::shared_ptr<TextureFontCreator> creator = createTextureFont(*parameters);
 
-    std::shared_ptr<GrayImage> img = creator->getImage();
-    std::shared_ptr<QImage> image = img->getQImage();
+    std::shared_ptr<QImage> image;
+    if (creator->getColorImage()) {
+        image = toQImage(*creator->getColorImage());
+    } else {
+        image = toQImage(*creator->getImage());
+    }
     m_pixmap = QPixmap::fromImage(*image);
 
     int width = m_pixmap.width();
@@ -181,7 +200,13 @@ void TextureFontCreatorGUI::updatePreview()
         sizeText.insert(i, '.');
     }
 
-    m_ui.imageSizeLabel->setText(QString("%1x%2 (%3 pixels)").arg(width).arg(height).arg(sizeText));
+    // how well the image is filled and how many tiles the sample text touches
+    std::u8string sampleText = toU8String(m_ui.textPreviewLineEdit->text());
+    AtlasReport report = createAtlasReport(*creator, {sampleText});
+
+    m_ui.imageSizeLabel->setText(QString("%1x%2 (%3 pixels, %4% filled, sample text touches %5 tiles)")
+                                 .arg(width).arg(height).arg(sizeText)
+                                 .arg(report.pages[0].fillRatio * 100, 0, 'f', 1).arg(report.cache.workingSet));
 
     // scale pixmap by selected factor
     m_pixmap = m_pixmap.scaled(m_pixmap.width() * m_ui.zoomSlider->value(),
@@ -198,9 +223,8 @@ void TextureFontCreatorGUI::updatePreview()
     m_ui.fontNameLabel->setText(creator->getFontName().c_str());
 
 
-    std::u8string sampleText = toU8String(m_ui.textPreviewLineEdit->text());
     std::shared_ptr<GrayImage> sampleImage = creator->renderText(sampleText);
-    std::shared_ptr<QImage> sampleQImage = sampleImage->getQImage();
+    std::shared_ptr<QImage> sampleQImage = toQImage(*sampleImage);
 
     QPixmap samplePixmap = QPixmap::fromImage(*sampleQImage);
     samplePixmap = samplePixmap.scaled(samplePixmap.width() * m_ui.zoomSlider->value(),
@@ -262,6 +286,40 @@ void TextureFontCreatorGUI::saveAsSimple() {
     }
 }
 
+void TextureFontCreatorGUI::saveAsPng() {
+    QString filename = QFileDialog::getSaveFileName( this, "Save Texture Font Image", m_lastSavePath, "PNG Images (*.png);;All Files (*)");
+    if (!filename.isEmpty()) {
+        auto parameters = getGuiSettings();
+        if (!parameters)
+        {
+            return;
+        }
+        std::shared_ptr<TextureFontCreator> creator = createTextureFont(*parameters);
+        creator->writeToPngFile(toU8String(filename));
+        m_lastSavePath = filename;
+    }
+}
+
+void TextureFontCreatorGUI::recordTrace(bool record) {
+    // the recorded timings are kept after recording, so they can still be shown and saved
+    if (record) {
+        Instrumentation::reset();
+    }
+    Instrumentation::setEnabled(record);
+}
+
+void TextureFontCreatorGUI::showStatistics() {
+    QString summary = QString::fromStdString(Instrumentation::getSummary()).toHtmlEscaped();
+    QMessageBox::information(this, "Statistics", QString("<pre>%1</pre>").arg(summary));
+}
+
+void TextureFontCreatorGUI::saveTrace() {
+    QString filename = QFileDialog::getSaveFileName( this, "Save Trace", m_lastSavePath, "Chrome Trace Files (*.json);;All Files (*)");
+    if (!filename.isEmpty()) {
+        Instrumentation::writeChromeTrace(toU8String(filename));
+    }
+}
+
 
 
 TextureFontCreatorGUI::~TextureFontCreatorGUI()
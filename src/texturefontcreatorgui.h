@@ -40,6 +40,10 @@ public slots:
     void saveAs();
     void saveAsJson();
     void saveAsSimple();
+    void saveAsPng();
+    void recordTrace(bool record);
+    void showStatistics();
+    void saveTrace();
 
     void showAboutDialog();
 
@@ -0,0 +1,123 @@
+/*
+ * AtlasPackerTest.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <cmath>
+
+#include "TestUtils.h"
+#include "AtlasPacker.h"
+
+static const PackingOrder ORDERS[] = {PackingOrder::Height, PackingOrder::Width, PackingOrder::Area, PackingOrder::Perimeter};
+static const PackingAlgorithm ALGORITHMS[] = {
+    PackingAlgorithm::Shelf, PackingAlgorithm::Skyline, PackingAlgorithm::MaxRectsBestShortSideFit,
+    PackingAlgorithm::MaxRectsBestLongSideFit, PackingAlgorithm::MaxRectsBestAreaFit, PackingAlgorithm::MaxRectsBottomLeft
+};
+
+/*! \brief creates rectangles with the size distribution of characters: many small, few large and some thin ones */
+static std::vector<PackingRectangle> createRectangles(uint32_t count, uint32_t seed) {
+    std::vector<PackingRectangle> rectangles;
+    uint32_t random = seed;
+    auto next = [&random](uint32_t range) {
+        random = random * 1664525u + 1013904223u;
+        return (random >> 8) % range;
+    };
+    for (uint32_t i = 0; i < count; i++) {
+        PackingRectangle rectangle;
+        rectangle.width = 1 + next((i % 10 == 0) ? 60 : 14);
+        rectangle.height = (i % 7 == 0) ? 1 + next(3) : 1 + next(20);
+        rectangles.push_back(rectangle);
+    }
+    return rectangles;
+}
+
+/*! \brief checks that all rectangles lie inside of the image and are separated by the padding */
+static bool isValidPacking(const std::vector<PackingRectangle>& rectangles, uint32_t size, uint32_t padding) {
+    for (const PackingRectangle& rectangle : rectangles) {
+        if (rectangle.left < 0 || rectangle.top < 0
+                || rectangle.left + static_cast<int64_t>(rectangle.width) > size
+                || rectangle.top + static_cast<int64_t>(rectangle.height) > size) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < rectangles.size(); i++) {
+        for (size_t j = i + 1; j < rectangles.size(); j++) {
+            const PackingRectangle& a = rectangles[i];
+            const PackingRectangle& b = rectangles[j];
+            bool separated = a.left + static_cast<int64_t>(a.width) + padding <= b.left
+                          || b.left + static_cast<int64_t>(b.width) + padding <= a.left
+                          || a.top + static_cast<int64_t>(a.height) + padding <= b.top
+                          || b.top + static_cast<int64_t>(b.height) + padding <= a.top;
+            if (!separated) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void testPackRectangles() {
+    for (uint32_t padding : {0u, 1u, 3u}) {
+        std::vector<PackingRectangle> rectangles = createRectangles(300, padding + 1);
+        uint64_t area = 0;
+        for (const PackingRectangle& rectangle : rectangles) {
+            area += static_cast<uint64_t>(rectangle.width + padding) * (rectangle.height + padding);
+        }
+
+        for (PackingOrder order : ORDERS) {
+            std::vector<uint32_t> indices = getPackingOrder(rectangles, order);
+            CHECK(indices.size() == rectangles.size());
+            for (PackingAlgorithm algorithm : ALGORITHMS) {
+                // grow the image until the rectangles fit, starting at the size of their total area
+                uint32_t size = sqrt(area);
+                std::vector<PackingRectangle> packed = rectangles;
+                while (!packRectangles(packed, indices, size, padding, algorithm) && size < 4096) {
+                    size++;
+                }
+                CHECK(size < 4096);
+                if (!CHECK(isValidPacking(packed, size, padding))) {
+                    std::cerr << getPackingAlgorithmName(algorithm) << " with order " << getPackingOrderName(order)
+                              << " and padding " << padding << " produced overlapping rectangles" << std::endl;
+                }
+                for (size_t i = 0; i < packed.size(); i++) {
+                    CHECK(packed[i].width == rectangles[i].width && packed[i].height == rectangles[i].height);
+                }
+            }
+        }
+    }
+
+    // a rectangle larger than the image never fits
+    std::vector<PackingRectangle> large = {{10, 10}, {33, 5}};
+    for (PackingAlgorithm algorithm : ALGORITHMS) {
+        CHECK(!packRectangles(large, {0, 1}, 32, 0, algorithm));
+        CHECK(packRectangles(large, {0, 1}, 33, 0, algorithm));
+    }
+}
+
+static void testOptimizePacking() {
+    std::vector<PackingRectangle> rectangles = createRectangles(200, 42);
+    PackingResult result = optimizePacking(rectangles, 1, 512, false, std::chrono::milliseconds(0));
+    if (!CHECK(result.size > 0 && result.size <= 512)) {
+        return;
+    }
+    CHECK(result.rectangles.size() == rectangles.size());
+    CHECK(isValidPacking(result.rectangles, result.size, 1));
+
+    // the result does not depend on the scheduling of the candidates
+    PackingResult again = optimizePacking(rectangles, 1, 512, false, std::chrono::milliseconds(0));
+    CHECK(again.size == result.size && again.order == result.order && again.algorithm == result.algorithm);
+
+    PackingResult powerOfTwo = optimizePacking(rectangles, 1, 512, true, std::chrono::milliseconds(0));
+    CHECK(powerOfTwo.size >= result.size && (powerOfTwo.size & (powerOfTwo.size - 1)) == 0);
+    CHECK(isValidPacking(powerOfTwo.rectangles, powerOfTwo.size, 1));
+
+    PackingResult tooSmall = optimizePacking(rectangles, 1, 16, false, std::chrono::milliseconds(0));
+    CHECK(tooSmall.size == 0);
+}
+
+int main() {
+    testPackRectangles();
+    testOptimizePacking();
+    return testResult();
+}
@@ -0,0 +1,106 @@
+/*
+ * BatchBuilderTest.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <unistd.h>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include "TestUtils.h"
+#include "BatchBuilder.h"
+#include "BlockCompression.h"
+
+static std::vector<uint8_t> readFile(const std::filesystem::path& path) {
+    std::ifstream fp(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(fp), std::istreambuf_iterator<char>());
+}
+
+static uint32_t readLittleEndian(const std::vector<uint8_t>& buffer, size_t offset) {
+    return buffer[offset] | (buffer[offset + 1] << 8) | (buffer[offset + 2] << 16) | (uint32_t(buffer[offset + 3]) << 24);
+}
+
+/*! \brief block compressed files of a batch contain the blocks of the image of the job
+ *
+ *  The font sizes give images whose packed size is not a multiple of 4.
+ */
+static void testBlockCompressedOutputs(const std::filesystem::path& font, const std::filesystem::path& directory) {
+    std::vector<AtlasJob> jobs;
+    for (double fontSize : {9.0, 13.0, 23.0}) {
+        for (const char* extension : {".dds", ".ktx"}) {
+            AtlasJob job;
+            job.output = directory / ("font" + std::to_string(int(fontSize)) + extension);
+            job.fontpath = font;
+            job.fontSize = fontSize;
+            job.chars = u8"AVjJfy/_Åg{W";
+            jobs.push_back(job);
+        }
+    }
+
+    BatchOptions options;
+    options.threads = 2;
+    std::vector<std::string> errors = buildBatch(jobs, options);
+    for (size_t i = 0; i < jobs.size(); i++) {
+        if (!CHECK(errors[i].empty())) {
+            std::cerr << jobs[i].output << ": " << errors[i] << std::endl;
+            continue;
+        }
+        std::vector<uint8_t> file = readFile(jobs[i].output);
+        std::shared_ptr<GrayImage> image = createTextureFont(jobs[i])->getImage();
+        uint32_t width = image->getWidth();
+        uint32_t height = image->getHeight();
+        CHECK(width % 4 == 0 && height % 4 == 0);
+
+        bool dds = jobs[i].output.extension() == ".dds";
+        BlockFormat format = dds ? BlockFormat::BC4 : BlockFormat::EacR11;
+        size_t headerSize = dds ? 148 : 68;
+        if (!CHECK(file.size() == headerSize + getCompressedSize(width, height, format))) {
+            continue;
+        }
+        CHECK(readLittleEndian(file, dds ? 16 : 36) == width);
+        CHECK(readLittleEndian(file, dds ? 12 : 40) == height);
+        std::vector<uint8_t> blocks = compressImage(*image, format);
+        CHECK(std::memcmp(file.data() + headerSize, blocks.data(), blocks.size()) == 0);
+    }
+}
+
+/*! \brief a failed write keeps the previous file and leaves no temporary files */
+static void testAtomicWrites(const std::filesystem::path& font, const std::filesystem::path& directory) {
+    std::filesystem::path path = directory / "atomic.ytf";
+    TextureFontCreator creator(font, 13, false, u8"AVj", true, true);
+    writeTextureFont(creator, path);
+    std::vector<uint8_t> expected = readFile(path);
+    CHECK(!expected.empty());
+
+    CHECK_THROWS(writeFileAtomically(path, [&creator](const std::filesystem::path& temporaryPath) {
+        creator.writeToFile(temporaryPath);
+        throw std::runtime_error("write failed");
+    }));
+    CHECK(readFile(path) == expected);
+    CHECK(std::distance(std::filesystem::directory_iterator(directory), std::filesystem::directory_iterator()) == 1);
+
+    // writes to a full device fail when the buffered data is written
+    if (std::filesystem::exists("/dev/full")) {
+        CHECK_THROWS(creator.writeToFile("/dev/full"));
+        CHECK_THROWS(creator.writeToPngFile("/dev/full"));
+        CHECK_THROWS(creator.writeToJsonFile("/dev/full"));
+    }
+}
+
+int main() {
+    std::filesystem::path font = getTestFont();
+    if (font.empty()) {
+        std::cerr << "test font not found, skipping tests rendering characters" << std::endl;
+        return TEST_SKIPPED;
+    }
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / ("BatchBuilderTest-" + std::to_string(getpid()));
+    std::filesystem::create_directories(directory);
+    testBlockCompressedOutputs(font, directory);
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    testAtomicWrites(font, directory);
+    std::filesystem::remove_all(directory);
+    return testResult();
+}
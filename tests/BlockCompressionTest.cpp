@@ -0,0 +1,170 @@
+/*
+ * BlockCompressionTest.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <cstdlib>
+
+#include "TestUtils.h"
+#include "BlockCompression.h"
+
+/*! \brief decodes a BC4 block as described in the D3D11 functional specification */
+static void decodeBc4Block(const uint8_t* block, uint8_t pixels[16]) {
+    int32_t endpoint0 = block[0];
+    int32_t endpoint1 = block[1];
+    int32_t palette[8] = {endpoint0, endpoint1};
+    if (endpoint0 > endpoint1) {
+        for (int32_t i = 2; i < 8; i++) {
+            palette[i] = ((8 - i) * endpoint0 + (i - 1) * endpoint1) / 7;
+        }
+    } else {
+        for (int32_t i = 2; i < 6; i++) {
+            palette[i] = ((6 - i) * endpoint0 + (i - 1) * endpoint1) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+    uint64_t bits = 0;
+    for (uint32_t i = 0; i < 6; i++) {
+        bits |= static_cast<uint64_t>(block[2 + i]) << (8 * i);
+    }
+    for (uint32_t pixel = 0; pixel < 16; pixel++) {
+        pixels[pixel] = palette[(bits >> (3 * pixel)) & 7];
+    }
+}
+
+/*! \brief decodes an EAC R11 unsigned block as described in the OpenGL ES 3.0 specification, returns 11bit values */
+static void decodeEacBlock(const uint8_t* block, int32_t pixels[16]) {
+    static const int32_t modifiers[16][8] = {
+        {-3, -6,  -9, -15, 2, 5, 8, 14}, {-3, -7, -10, -13, 2, 6, 9, 12},
+        {-2, -5,  -8, -13, 1, 4, 7, 12}, {-2, -4,  -6, -13, 1, 3, 5, 12},
+        {-3, -6,  -8, -12, 2, 5, 7, 11}, {-3, -7,  -9, -11, 2, 6, 8, 10},
+        {-4, -7,  -8, -11, 3, 6, 7, 10}, {-3, -5,  -8, -11, 2, 4, 7, 10},
+        {-2, -6,  -8, -10, 1, 5, 7,  9}, {-2, -5,  -8, -10, 1, 4, 7,  9},
+        {-2, -4,  -8, -10, 1, 3, 7,  9}, {-2, -5,  -7, -10, 1, 4, 6,  9},
+        {-3, -4,  -7, -10, 2, 3, 6,  9}, {-1, -2,  -3, -10, 0, 1, 2,  9},
+        {-4, -6,  -8,  -9, 3, 5, 7,  8}, {-3, -5,  -7,  -9, 2, 4, 6,  8}
+    };
+    uint64_t bits = 0;
+    for (uint32_t i = 0; i < 8; i++) {
+        bits = (bits << 8) | block[i];
+    }
+    int32_t base = bits >> 56;
+    int32_t multiplier = (bits >> 52) & 15;
+    int32_t table = (bits >> 48) & 15;
+    // the indices are stored in column major order
+    for (uint32_t position = 0; position < 16; position++) {
+        int32_t modifier = modifiers[table][(bits >> (45 - 3 * position)) & 7];
+        int32_t value = (multiplier == 0) ? base * 8 + 4 + modifier : base * 8 + 4 + modifier * multiplier * 8;
+        pixels[(position % 4) * 4 + position / 4] = std::clamp(value, 0, 2047);
+    }
+}
+
+/*! \brief compresses a single 4x4 block and returns the largest difference of the decoded pixels */
+static int32_t getMaximumError(const uint8_t pixels[16], BlockFormat format) {
+    GrayImage image(4, 4);
+    for (uint32_t y = 0; y < 4; y++) {
+        std::copy(pixels + y * 4, pixels + y * 4 + 4, image.getRow(y));
+    }
+    std::vector<uint8_t> block = compressImage(image, format, 1);
+    if (!CHECK(block.size() == 8)) {
+        return 255;
+    }
+
+    int32_t maximumError = 0;
+    if (format == BlockFormat::BC4) {
+        uint8_t decoded[16];
+        decodeBc4Block(block.data(), decoded);
+        for (uint32_t pixel = 0; pixel < 16; pixel++) {
+            maximumError = std::max(maximumError, std::abs(decoded[pixel] - pixels[pixel]));
+        }
+    } else {
+        int32_t decoded[16];
+        decodeEacBlock(block.data(), decoded);
+        for (uint32_t pixel = 0; pixel < 16; pixel++) {
+            int32_t value = (decoded[pixel] * 255 + 1023) / 2047;
+            maximumError = std::max(maximumError, std::abs(value - pixels[pixel]));
+        }
+    }
+    return maximumError;
+}
+
+/*! \brief checks the reference decoders with blocks whose values are given by the specifications */
+static void testReferenceBlocks() {
+    // eight value mode, index 2 is 6/7 of the first endpoint
+    const uint8_t bc4[8] = {210, 70, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49};
+    uint8_t pixels[16];
+    decodeBc4Block(bc4, pixels);
+    CHECK(pixels[0] == 190 && pixels[15] == 190);
+
+    // six value mode with the constant 0 and 255 at index 6 and 7
+    const uint8_t bc4Six[8] = {10, 60, 0xfe, 0xff, 0xff, 0xff, 0xff, 0xff};
+    decodeBc4Block(bc4Six, pixels);
+    CHECK(pixels[0] == 0 && pixels[1] == 255 && pixels[2] == 255);
+
+    // base 128, multiplier 2, table 13 with modifiers -1 and 9 at index 0 and 7
+    const uint8_t eac[8] = {128, 0x2d, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07};
+    int32_t values[16];
+    decodeEacBlock(eac, values);
+    CHECK(values[0] == 128 * 8 + 4 - 16);
+    CHECK(values[15] == 128 * 8 + 4 + 9 * 16);
+}
+
+static void testBlocks() {
+    for (BlockFormat format : {BlockFormat::BC4, BlockFormat::EacR11}) {
+        // uniform blocks
+        for (uint8_t value : {0, 1, 127, 200, 255}) {
+            uint8_t pixels[16];
+            std::fill(pixels, pixels + 16, value);
+            CHECK(getMaximumError(pixels, format) <= ((format == BlockFormat::BC4) ? 0 : 1));
+        }
+
+        // edges of characters consist of empty and fully covered pixels
+        uint8_t edge[16] = {0, 0, 255, 255, 0, 0, 255, 255, 0, 255, 255, 255, 0, 0, 0, 255};
+        CHECK(getMaximumError(edge, format) <= ((format == BlockFormat::BC4) ? 0 : 1));
+
+        // anti aliased edge, empty and covered pixels are combined with intermediate values,
+        // the error is at most half the distance of the eight values between 0 and 255
+        uint8_t antiAliased[16] = {0, 0, 90, 255, 0, 40, 200, 255, 0, 120, 255, 255, 10, 180, 255, 255};
+        CHECK(getMaximumError(antiAliased, format) <= 19);
+
+        uint8_t gradient[16];
+        for (uint32_t pixel = 0; pixel < 16; pixel++) {
+            gradient[pixel] = 100 + pixel * 4;
+        }
+        CHECK(getMaximumError(gradient, format) <= 5);
+    }
+
+    const uint8_t uniform[16] = {77, 77, 77, 77, 77, 77, 77, 77, 77, 77, 77, 77, 77, 77, 77, 77};
+    GrayImage image(4, 4);
+    for (uint32_t y = 0; y < 4; y++) {
+        std::copy(uniform + y * 4, uniform + y * 4 + 4, image.getRow(y));
+    }
+    CHECK(compressImage(image, BlockFormat::BC4) == std::vector<uint8_t>({77, 77, 0, 0, 0, 0, 0, 0}));
+}
+
+static void testImages() {
+    GrayImage image(37, 18);
+    for (uint32_t y = 0; y < image.getHeight(); y++) {
+        for (uint32_t x = 0; x < image.getWidth(); x++) {
+            image.getRow(y)[x] = static_cast<uint8_t>((x * 31) ^ (y * 17));
+        }
+    }
+    for (BlockFormat format : {BlockFormat::BC4, BlockFormat::EacR11}) {
+        std::vector<uint8_t> blocks = compressImage(image, format, 1);
+        CHECK(blocks.size() == 10 * 5 * 8);
+        CHECK(blocks.size() == getCompressedSize(image.getWidth(), image.getHeight(), format));
+        CHECK(compressImage(image, format, 4) == blocks);
+        CHECK(compressImage(image, format, 0) == blocks);
+    }
+    CHECK(getCompressedSize(37, 18, BlockFormat::None) == 37 * 18);
+    CHECK_THROWS(compressImage(image, BlockFormat::None));
+}
+
+int main() {
+    testReferenceBlocks();
+    testBlocks();
+    testImages();
+    return testResult();
+}
@@ -0,0 +1,70 @@
+/*
+ * CodepageTest.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "TestUtils.h"
+#include "Codepage.h"
+
+/*! \brief checksums of the tables, computed with the codecs of Python
+ *
+ *  The checksum is the sum of (code + 1) * codepoint of all 256 codes
+ *  modulo 2^32, undefined codes have the codepoint 0, e.g. for CP437:
+ *  sum((i + 1) * ord(bytes([i]).decode("cp437")) for i in range(256))
+ */
+struct CodepageReference {
+    Codepage codepage;
+    const char* pythonCodec;
+    uint32_t checksum;
+    uint32_t undefinedCodes; //!< number of undefined codes besides 0x00
+};
+
+static const CodepageReference REFERENCES[] = {
+    {Codepage::CP437, "cp437", 0x07857a6d, 0},
+    {Codepage::CP850, "cp850", 0x03b0d67e, 0},
+    {Codepage::ISO_8859_1, "latin_1", 0x00555500, 0},
+    {Codepage::ISO_8859_2, "iso8859_2", 0x006fd3d4, 0},
+    {Codepage::ISO_8859_5, "iso8859_5", 0x01703432, 0},
+    {Codepage::ISO_8859_7, "iso8859_7", 0x0167290f, 3},
+    {Codepage::ISO_8859_9, "iso8859_9", 0x00570c9e, 0},
+    {Codepage::ISO_8859_15, "iso8859_15", 0x006d73aa, 0}
+};
+
+/*! \brief every code page decodes like its Python codec and encodes every decoded character back to its code */
+static void testTables() {
+    for (const CodepageReference& reference : REFERENCES) {
+        uint32_t checksum = 0;
+        uint32_t undefinedCodes = 0;
+        for (uint32_t code = 1; code < 256; code++) {
+            char32_t unicode = decodeCodepoint(code, reference.codepage);
+            checksum += (code + 1) * unicode;
+            if (unicode == 0) {
+                undefinedCodes++;
+                continue;
+            }
+            uint8_t encoded = 0;
+            if (!CHECK(encodeCodepoint(unicode, reference.codepage, encoded) && encoded == code)) {
+                std::cerr << getCodepageName(reference.codepage) << ": code " << code << std::endl;
+            }
+        }
+        if (!CHECK(checksum == reference.checksum && undefinedCodes == reference.undefinedCodes)) {
+            std::cerr << getCodepageName(reference.codepage) << " differs from the Python codec " << reference.pythonCodec << std::endl;
+        }
+    }
+}
+
+/*! \brief characters that do not exist in a code page are not encoded */
+static void testUnmappableCharacters() {
+    uint8_t code = 0;
+    CHECK(!encodeCodepoint(0x20AC, Codepage::CP437, code));
+    CHECK(!encodeCodepoint(0x0416, Codepage::ISO_8859_1, code));
+    CHECK(!encodeCodepoint(0x1F600, Codepage::ISO_8859_15, code));
+    CHECK(encodeCodepoint(0x20AC, Codepage::ISO_8859_15, code) && code == 0xA4);
+}
+
+int main() {
+    testTables();
+    testUnmappableCharacters();
+    return testResult();
+}
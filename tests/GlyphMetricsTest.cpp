@@ -0,0 +1,150 @@
+/*
+ * GlyphMetricsTest.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <cstring>
+#include <limits>
+
+#include "TestUtils.h"
+#include "GlyphMetrics.h"
+
+static CompactGlyphMetrics makeMetrics(uint32_t unicode, int32_t horiAdvance, int16_t bitmapLeft, uint16_t left, uint8_t phase, uint8_t page) {
+    CompactGlyphMetrics metrics = {};
+    metrics.unicode = unicode;
+    metrics.horiAdvance = horiAdvance;
+    metrics.vertAdvance = -horiAdvance / 3;
+    metrics.bitmapLeft = bitmapLeft;
+    metrics.bitmapTop = static_cast<int16_t>(-bitmapLeft / 2);
+    metrics.left = left;
+    metrics.top = static_cast<uint16_t>(left * 7);
+    metrics.width = static_cast<uint16_t>(unicode % 65536);
+    metrics.height = 65535;
+    metrics.face = static_cast<uint16_t>(unicode % 3);
+    metrics.phase = phase;
+    metrics.page = page;
+    return metrics;
+}
+
+static bool equalMetrics(const std::vector<CompactGlyphMetrics>& a, const std::vector<CompactGlyphMetrics>& b) {
+    return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(CompactGlyphMetrics)) == 0);
+}
+
+static std::vector<CompactGlyphMetrics> getTestMetrics() {
+    return {
+        makeMetrics(0x10FFFF, std::numeric_limits<int32_t>::max(), std::numeric_limits<int16_t>::max(), 65535, 0, 1),
+        makeMetrics('A', 10 << 16, -3, 0, 1, 0),
+        makeMetrics('A', (10 << 16) + 1, -3, 12, 0, 0),
+        makeMetrics(0, std::numeric_limits<int32_t>::min(), std::numeric_limits<int16_t>::min(), 1, 255, 1),
+        makeMetrics(0x1F600, -5, 0, 300, 2, 1),
+        makeMetrics(' ', 0, 1, 2, 0, 0)
+    };
+}
+
+static void testFixedPoint() {
+    for (double value : {0.0, 1.0, -1.0, 0.5, 13.375, -2.25, 32767.0, 1.0 / 65536}) {
+        CHECK(fromFixed16_16(toFixed16_16(value)) == value);
+    }
+    CHECK(toFixed16_16(1.0 / 131072 * 1.01) == 1); // rounded to the nearest value
+    CHECK(toFixed16_16(-1.0) == -65536);
+}
+
+static void testCompact() {
+    std::vector<CompactGlyphMetrics> glyphs = getTestMetrics();
+    std::vector<uint8_t> table = encodeGlyphMetrics(glyphs, MetricsEncoding::Compact);
+    CHECK(table.size() == glyphs.size() * 28);
+    CHECK(equalMetrics(decodeGlyphMetrics(table.data(), table.size(), glyphs.size(), MetricsEncoding::Compact), glyphs));
+    CHECK_THROWS(decodeGlyphMetrics(table.data(), table.size() - 1, glyphs.size(), MetricsEncoding::Compact));
+    CHECK(decodeGlyphMetrics(nullptr, 0, 0, MetricsEncoding::Compact).empty());
+}
+
+static void testCompactDelta() {
+    std::vector<CompactGlyphMetrics> glyphs = getTestMetrics();
+    std::vector<CompactGlyphMetrics> sorted = glyphs;
+    std::stable_sort(sorted.begin(), sorted.end(), [](const CompactGlyphMetrics& a, const CompactGlyphMetrics& b) {
+        return (a.unicode < b.unicode) || (a.unicode == b.unicode && a.phase < b.phase);
+    });
+
+    std::vector<uint8_t> table = encodeGlyphMetrics(glyphs, MetricsEncoding::CompactDelta, true);
+    CHECK(table.size() < glyphs.size() * sizeof(CompactGlyphMetrics));
+    CHECK(equalMetrics(decodeGlyphMetrics(table.data(), table.size(), glyphs.size(), MetricsEncoding::CompactDelta, true), sorted));
+
+    // without the page every record is decoded with page 0
+    std::vector<uint8_t> tableWithoutPage = encodeGlyphMetrics(glyphs, MetricsEncoding::CompactDelta, false);
+    CHECK(tableWithoutPage.size() == table.size() - glyphs.size());
+    for (CompactGlyphMetrics& glyph : sorted) {
+        glyph.page = 0;
+    }
+    CHECK(equalMetrics(decodeGlyphMetrics(tableWithoutPage.data(), tableWithoutPage.size(), glyphs.size(), MetricsEncoding::CompactDelta), sorted));
+
+    for (size_t size = 0; size < table.size(); size++) {
+        CHECK_THROWS(decodeGlyphMetrics(table.data(), size, glyphs.size(), MetricsEncoding::CompactDelta, true));
+    }
+    CHECK_THROWS(decodeGlyphMetrics(table.data(), table.size(), glyphs.size() + 1, MetricsEncoding::CompactDelta, true));
+}
+
+/*! \brief checks the encoded bytes of a record, the format is fixed by files already written */
+static void testCompactDeltaBytes() {
+    CompactGlyphMetrics glyph = {};
+    glyph.unicode = 'A';
+    glyph.horiAdvance = 1 << 16;
+    glyph.bitmapLeft = -1;
+    glyph.bitmapTop = 2;
+    glyph.left = 3;
+    glyph.top = 4;
+    glyph.width = 5;
+    glyph.height = 300;
+    glyph.page = 1;
+    std::vector<uint8_t> expected = {0x41, 0x80, 0x80, 0x08, 0x00, 0x01, 0x04, 0x03, 0x04, 0x05, 0xac, 0x02, 0x00, 0x00, 0x01};
+    CHECK(encodeGlyphMetrics({glyph}, MetricsEncoding::CompactDelta, true) == expected);
+
+    // values exceeding their field and overlong integers are malformed
+    std::vector<uint8_t> outOfRange = expected;
+    outOfRange[5] = 0x80;
+    outOfRange.insert(outOfRange.begin() + 6, {0x80, 0x04});
+    CHECK_THROWS(decodeGlyphMetrics(outOfRange.data(), outOfRange.size(), 1, MetricsEncoding::CompactDelta, true));
+    std::vector<uint8_t> overlong(40, 0xff);
+    CHECK_THROWS(decodeGlyphMetrics(overlong.data(), overlong.size(), 1, MetricsEncoding::CompactDelta, true));
+}
+
+static void testMakeCompactGlyphMetrics() {
+    ImageCharacter character;
+    character.unicode = 'g';
+    character.horiAdvance = 7.5;
+    character.vertAdvance = 12;
+    character.bitmap_left = -1;
+    character.bitmap_top = 9;
+    character.width = 8;
+    character.height = 13;
+    character.face = 1;
+    character.phase = 2;
+    CompactGlyphMetrics metrics = makeCompactGlyphMetrics(character, 100, 200, 1);
+    CHECK(metrics.unicode == 'g' && metrics.horiAdvance == 7 * 65536 + 32768 && metrics.vertAdvance == 12 * 65536);
+    CHECK(metrics.bitmapLeft == -1 && metrics.bitmapTop == 9 && metrics.left == 100 && metrics.top == 200);
+    CHECK(metrics.width == 8 && metrics.height == 13 && metrics.face == 1 && metrics.phase == 2 && metrics.page == 1);
+
+    CHECK_THROWS(makeCompactGlyphMetrics(character, 70000, 0));
+    CHECK_THROWS(makeCompactGlyphMetrics(character, -1, 0));
+    character.bitmap_left = -40000;
+    CHECK_THROWS(makeCompactGlyphMetrics(character, 0, 0));
+    character.bitmap_left = -1;
+
+    // advances are 16.16 fixed point values
+    character.horiAdvance = 32767.5;
+    CHECK(makeCompactGlyphMetrics(character, 0, 0).horiAdvance == 32767 * 65536 + 32768);
+    character.horiAdvance = 32768;
+    CHECK_THROWS(makeCompactGlyphMetrics(character, 0, 0));
+    character.horiAdvance = 7.5;
+    character.vertAdvance = -40000;
+    CHECK_THROWS(makeCompactGlyphMetrics(character, 0, 0));
+}
+
+int main() {
+    testFixedPoint();
+    testCompact();
+    testCompactDelta();
+    testCompactDeltaBytes();
+    testMakeCompactGlyphMetrics();
+    return testResult();
+}
@@ -0,0 +1,104 @@
+/*
+ * PngEncoderTest.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "TestUtils.h"
+#include "PngEncoder.h"
+
+/*! \brief fills the image with a pattern that contains smooth and noisy areas */
+static void fillPattern(uint8_t* row, size_t length, uint32_t y) {
+    uint32_t noise = y * 2654435761u;
+    for (size_t x = 0; x < length; x++) {
+        noise = noise * 1664525u + 1013904223u;
+        row[x] = (x < length / 2) ? static_cast<uint8_t>(x + y) : static_cast<uint8_t>(noise >> 24);
+    }
+}
+
+static void testGrayRoundTrip() {
+    GrayImage image(301, 217);
+    for (uint32_t y = 0; y < image.getHeight(); y++) {
+        fillPattern(image.getRow(y), image.getWidth(), y);
+    }
+
+    std::vector<uint8_t> reference;
+    for (int compressionLevel : {0, 1, 6, 9}) {
+        for (uint32_t threads : {1u, 3u, 0u}) {
+            PngOptions options;
+            options.compressionLevel = compressionLevel;
+            options.threads = threads;
+            std::vector<uint8_t> png = encodePng(image, options);
+
+            std::shared_ptr<ColorImage> decoded = decodePng(png.data(), png.size());
+            CHECK(decoded->getChannels() == 1);
+            CHECK(equalImages(*decoded->getGrayImage(), image));
+
+            // the file must not depend on the number of threads
+            if (threads == 1) {
+                reference = png;
+            } else {
+                CHECK(png == reference);
+            }
+        }
+    }
+}
+
+static void testColorRoundTrip() {
+    for (uint32_t channels : {3u, 4u}) {
+        ColorImage image(129, 65, channels);
+        for (uint32_t y = 0; y < image.getHeight(); y++) {
+            fillPattern(image.getRow(y), static_cast<size_t>(image.getWidth()) * channels, y);
+        }
+        std::vector<uint8_t> png = encodePng(image);
+        std::shared_ptr<ColorImage> decoded = decodePng(png.data(), png.size());
+        CHECK(equalImages(*decoded, image));
+    }
+
+    GrayImage single(1, 1, 42);
+    std::vector<uint8_t> png = encodePng(single);
+    std::shared_ptr<ColorImage> decoded = decodePng(png.data(), png.size());
+    CHECK(decoded->getWidth() == 1 && decoded->getHeight() == 1 && decoded->getRow(0)[0] == 42);
+}
+
+/*! \brief decodes an RGB image written by another encoder, its rows use all five filter types */
+static void testReferenceImage() {
+    const uint8_t png[] = {
+        0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52,
+        0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x05, 0x08, 0x02, 0x00, 0x00, 0x00, 0x0f, 0x13, 0xc1,
+        0xf5, 0x00, 0x00, 0x00, 0x2b, 0x49, 0x44, 0x41, 0x54, 0x78, 0xda, 0x63, 0x60, 0x28, 0x7e, 0xc6,
+        0x5c, 0xf6, 0x92, 0xad, 0xf2, 0x0d, 0x63, 0xed, 0x87, 0x64, 0x66, 0x30, 0x60, 0xaa, 0x85, 0x01,
+        0xe6, 0x5f, 0x5b, 0xde, 0x1e, 0x70, 0x38, 0xe0, 0xe0, 0x70, 0x80, 0x05, 0xc4, 0x03, 0x03, 0x00,
+        0xd1, 0xab, 0x11, 0x9c, 0xa6, 0x54, 0x69, 0x80, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44,
+        0xae, 0x42, 0x60, 0x82
+    };
+    const uint8_t pixels[] = {
+        0, 115, 230, 3, 118, 233, 6, 121, 236,
+        125, 240, 99, 128, 243, 102, 131, 246, 105,
+        250, 109, 224, 253, 112, 227, 0, 115, 230,
+        119, 234, 93, 122, 237, 96, 125, 240, 99,
+        244, 103, 218, 247, 106, 221, 250, 109, 224
+    };
+
+    std::shared_ptr<ColorImage> image = decodePng(png, sizeof(png));
+    if (!CHECK(image->getWidth() == 3 && image->getHeight() == 5 && image->getChannels() == 3)) {
+        return;
+    }
+    for (uint32_t y = 0; y < 5; y++) {
+        CHECK(std::equal(image->getRow(y), image->getRow(y) + 9, pixels + y * 9));
+    }
+
+    std::vector<uint8_t> corrupted(png, png + sizeof(png));
+    corrupted[50] ^= 1; // image data, the checksum of the chunk does not match anymore
+    CHECK_THROWS(decodePng(corrupted.data(), corrupted.size()));
+    for (size_t size = 0; size < sizeof(png) - 12; size++) {
+        CHECK_THROWS(decodePng(png, size));
+    }
+}
+
+int main() {
+    testGrayRoundTrip();
+    testColorRoundTrip();
+    testReferenceImage();
+    return testResult();
+}
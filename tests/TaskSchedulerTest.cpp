@@ -0,0 +1,101 @@
+/*
+ * TaskSchedulerTest.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <atomic>
+#include <chrono>
+
+#include "TestUtils.h"
+#include "TaskScheduler.h"
+
+static void testCompletion() {
+    for (uint32_t threads : {1u, 4u, 0u}) {
+        TaskScheduler scheduler(threads);
+        CHECK(scheduler.getThreadCount() > 0);
+        CHECK(threads == 0 || scheduler.getThreadCount() == threads);
+
+        std::atomic<uint32_t> finished(0);
+        for (uint32_t i = 0; i < 10000; i++) {
+            scheduler.submit([&finished]() { finished++; });
+        }
+        scheduler.wait();
+        CHECK(finished == 10000);
+
+        // the scheduler can be used again after waiting
+        scheduler.submit([&finished]() { finished++; });
+        scheduler.wait();
+        CHECK(finished == 10001);
+
+        // waiting without tasks returns immediately
+        scheduler.wait();
+    }
+}
+
+/*! \brief submits a binary tree of tasks, every task submits its children */
+static void submitTree(TaskScheduler& scheduler, std::atomic<uint32_t>& finished, uint32_t depth) {
+    scheduler.submit([&scheduler, &finished, depth]() {
+        if (depth > 0) {
+            submitTree(scheduler, finished, depth - 1);
+            submitTree(scheduler, finished, depth - 1);
+        }
+        finished++;
+    });
+}
+
+static void testNestedTasks() {
+    for (uint32_t threads : {1u, 3u}) {
+        TaskScheduler scheduler(threads);
+        std::atomic<uint32_t> finished(0);
+        submitTree(scheduler, finished, 12);
+        scheduler.wait();
+        CHECK(finished == (1u << 13) - 1);
+    }
+}
+
+static void testDestructorWaits() {
+    std::atomic<uint32_t> finished(0);
+    {
+        TaskScheduler scheduler(2);
+        for (uint32_t i = 0; i < 100; i++) {
+            scheduler.submit([&finished]() {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                finished++;
+            });
+        }
+    }
+    CHECK(finished == 100);
+}
+
+/*! \brief all threads have to run tasks at the same time, a task only finishes when all tasks have started */
+static void testParallelism() {
+    const uint32_t threads = 4;
+    TaskScheduler scheduler(threads);
+    std::atomic<uint32_t> started(0);
+    std::atomic<uint32_t> timedOut(0);
+    for (uint32_t i = 0; i < threads; i++) {
+        scheduler.submit([&started, &timedOut, threads]() {
+            started++;
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            while (started < threads) {
+                if (std::chrono::steady_clock::now() > deadline) {
+                    timedOut++;
+                    return;
+                }
+                std::this_thread::yield();
+            }
+        });
+    }
+    scheduler.wait();
+    CHECK(started == threads);
+    CHECK(timedOut == 0);
+}
+
+int main() {
+    testCompletion();
+    testNestedTasks();
+    testDestructorWaits();
+    testParallelism();
+    return testResult();
+}
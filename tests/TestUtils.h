@@ -0,0 +1,89 @@
+/*
+ * TestUtils.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef TESTUTILS_H_
+#define TESTUTILS_H_
+
+#include <stdint.h>
+#include <algorithm>
+#include <iostream>
+#include <filesystem>
+#include <stdexcept>
+
+#include "GrayImage.h"
+#include "ColorImage.h"
+
+/*! \brief exit code of a test that cannot run, e.g. because the test font is missing, see SKIP_RETURN_CODE */
+constexpr int TEST_SKIPPED = 77;
+
+inline int g_testFailures = 0; //!< number of failed checks of the running test
+
+/*! \brief records a failed check and prints where it happened */
+inline bool checkCondition(bool condition, const char* text, const char* file, int line) {
+    if (!condition) {
+        std::cerr << file << ":" << line << ": check failed: " << text << std::endl;
+        g_testFailures++;
+    }
+    return condition;
+}
+
+/*! \brief checks a condition, the test continues if it fails */
+#define CHECK(condition) checkCondition((condition), #condition, __FILE__, __LINE__)
+
+/*! \brief checks that the statement throws std::runtime_error */
+#define CHECK_THROWS(statement) \
+    do { \
+        bool thrown = false; \
+        try { statement; } catch (const std::runtime_error&) { thrown = true; } \
+        checkCondition(thrown, "throws: " #statement, __FILE__, __LINE__); \
+    } while (false)
+
+/*! \brief returns the exit code of the test */
+inline int testResult() {
+    if (g_testFailures > 0) {
+        std::cerr << g_testFailures << " checks failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+/*! \brief returns the font used by tests rendering characters, an empty path if there is none */
+inline std::filesystem::path getTestFont() {
+    std::filesystem::path path(TEXTUREFONT_TEST_FONT);
+    if (path.empty() || !std::filesystem::exists(path)) {
+        return std::filesystem::path();
+    }
+    return path;
+}
+
+/*! \brief returns true if both images have the same size and pixels */
+inline bool equalImages(GrayImage& a, GrayImage& b) {
+    if (a.getWidth() != b.getWidth() || a.getHeight() != b.getHeight()) {
+        return false;
+    }
+    for (uint32_t row = 0; row < a.getHeight(); row++) {
+        if (!std::equal(a.getRow(row), a.getRow(row) + a.getWidth(), b.getRow(row))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*! \brief returns true if both images have the same size, channels and pixels */
+inline bool equalImages(ColorImage& a, ColorImage& b) {
+    if (a.getWidth() != b.getWidth() || a.getHeight() != b.getHeight() || a.getChannels() != b.getChannels()) {
+        return false;
+    }
+    size_t rowLength = static_cast<size_t>(a.getWidth()) * a.getChannels();
+    for (uint32_t row = 0; row < a.getHeight(); row++) {
+        if (!std::equal(a.getRow(row), a.getRow(row) + rowLength, b.getRow(row))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif /* TESTUTILS_H_ */
@@ -0,0 +1,141 @@
+/*
+ * TextureFontCreatorTest.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <cmath>
+#include <sstream>
+
+#include "TestUtils.h"
+#include "TextureFontCreator.h"
+#include "AtlasReport.h"
+
+static const std::vector<std::u8string> CHARACTERS = {u8"A", u8"V", u8"j", u8"J", u8"f", u8"y", u8"/", u8"_", u8"Å", u8"g", u8"{", u8"W"};
+static const std::u8string TEXT = u8"AVjJfy/_Åg{W j";
+
+static uint64_t sumPixels(GrayImage& image) {
+    uint64_t sum = 0;
+    for (uint32_t y = 0; y < image.getHeight(); y++) {
+        for (uint32_t x = 0; x < image.getWidth(); x++) {
+            sum += image.getRow(y)[x];
+        }
+    }
+    return sum;
+}
+
+/*! \brief every character rendered alone contains all pixels of its rectangle in the image */
+static void testRenderTextExtents(const std::filesystem::path& font) {
+    TextureFontCreator creator(font, 24, false, TEXT, true, true);
+    GrayImage& atlas = *creator.getImage();
+
+    bool negativeBearing = false;
+    for (const std::u8string& text : CHARACTERS) {
+        TextQuads quads;
+        creator.layoutText({text}, quads);
+        if (!CHECK(quads.getQuadCount() == 1)) {
+            continue;
+        }
+        const float* quad = quads.vertices.data();
+        negativeBearing = negativeBearing || quad[0] < 0;
+
+        uint32_t left = std::lround(quad[4] * atlas.getWidth());
+        uint32_t top = std::lround(quad[5] * atlas.getHeight());
+        uint32_t width = quad[2] - quad[0];
+        uint32_t height = quad[3] - quad[1];
+        std::shared_ptr<GrayImage> rendered = creator.renderText(text);
+        CHECK(rendered->getWidth() >= width && rendered->getHeight() >= height);
+        CHECK(sumPixels(*rendered) == sumPixels(*atlas.crop(left, top, width, height)));
+    }
+    // the test needs a character reaching left of the pen, j in common fonts
+    CHECK(negativeBearing);
+
+    // strings of characters without pixels keep the height of the line
+    std::shared_ptr<GrayImage> space = creator.renderText(u8"  ");
+    CHECK(space->getWidth() > 0 && space->getHeight() > 0);
+}
+
+/*! \brief a streamed texture font renders the same text as one built in memory */
+static void testStreaming(const std::filesystem::path& font) {
+    for (uint32_t extrude : {0u, 2u}) {
+        FontVariant variant;
+        variant.fontpath = font;
+        variant.fontSize = 17;
+        variant.chars = TEXT;
+        variant.enableAntiAliasing = true;
+        variant.enableHinting = true;
+        AtlasOptions options;
+        options.extrude = extrude;
+        TextureFontCreator expected({variant}, false, options);
+        options.streaming = true;
+        TextureFontCreator streamed({variant}, false, options);
+        for (BlendMode mode : {BlendMode::Replace, BlendMode::Max}) {
+            CHECK(equalImages(*expected.renderText(TEXT, 0, mode), *streamed.renderText(TEXT, 0, mode)));
+        }
+    }
+}
+
+/*! \brief a single character wider than tall needs an image as wide as its extruded cell */
+static void testWideCharacter(const std::filesystem::path& font) {
+    for (bool lcd : {false, true}) {
+        FontVariant variant;
+        variant.fontpath = font;
+        variant.fontSize = 40;
+        variant.chars = u8"_";
+        variant.enableAntiAliasing = true;
+        variant.enableHinting = true;
+        variant.enableLcdRendering = lcd;
+        AtlasOptions options;
+        options.extrude = 2;
+        TextureFontCreator creator({variant}, false, options);
+
+        TextQuads quads;
+        creator.layoutText({u8"_"}, quads);
+        if (!CHECK(quads.getQuadCount() == 1)) {
+            continue;
+        }
+        uint32_t width = quads.vertices[2] - quads.vertices[0];
+        CHECK(width > quads.vertices[3] - quads.vertices[1]);
+        CHECK(creator.getImage()->getWidth() > width + 2 * options.extrude);
+    }
+}
+
+/*! \brief the report of a creator equals the report of the file it writes */
+static void testAtlasReport(const std::filesystem::path& font) {
+    FontVariant variant;
+    variant.fontpath = font;
+    variant.fontSize = 15;
+    variant.chars = TEXT;
+    variant.enableAntiAliasing = true;
+    variant.enableHinting = true;
+    variant.subpixelPhases = 3;
+    AtlasOptions options;
+    options.extrude = 1;
+    TextureFontCreator creator({variant, variant}, false, options);
+
+    std::stringstream file;
+    creator.writeToFile(file, MetricsEncoding::CompactDelta);
+    std::string data = file.str();
+    TextureFontReader reader(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+
+    AtlasReportOptions reportOptions;
+    reportOptions.tileSize = 16;
+    reportOptions.cacheTiles = 4;
+    reportOptions.variant = 1;
+    std::vector<std::u8string> corpus = {TEXT, u8"jaWj", u8"missing: ÄÖÜ"};
+    CHECK(writeAtlasReport(createAtlasReport(creator, corpus, reportOptions), reportOptions) ==
+          writeAtlasReport(createAtlasReport(reader, corpus, reportOptions), reportOptions));
+}
+
+int main() {
+    std::filesystem::path font = getTestFont();
+    if (font.empty()) {
+        std::cerr << "test font not found, skipping tests rendering characters" << std::endl;
+        return TEST_SKIPPED;
+    }
+    testRenderTextExtents(font);
+    testStreaming(font);
+    testWideCharacter(font);
+    testAtlasReport(font);
+    return testResult();
+}
@@ -0,0 +1,304 @@
+/*
+ * TextureFontReaderTest.cpp
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include <cmath>
+#include <cstring>
+#include <sstream>
+
+#include "TestUtils.h"
+#include "TextureFontCreator.h"
+#include "TextureFontReader.h"
+
+/*! \brief returns the content of a texture font written by the function */
+template<typename Function>
+static std::string writeTextureFont(Function write) {
+    std::stringstream stream;
+    write(stream);
+    return stream.str();
+}
+
+static std::shared_ptr<TextureFontReader> readTextureFont(const std::string& data) {
+    std::shared_ptr<TextureFontReader> reader(new TextureFontReader(reinterpret_cast<const uint8_t*>(data.data()), data.size()));
+    reader->validate();
+    return reader;
+}
+
+/*! \brief checks that both readers contain the same characters, advances may differ by the precision of compact metrics */
+static void checkSameCharacters(TextureFontReader& expected, TextureFontReader& actual) {
+    CHECK(expected.getVariants().size() == actual.getVariants().size());
+    for (size_t variant = 0; variant < std::min(expected.getVariants().size(), actual.getVariants().size()); variant++) {
+        const std::vector<TextureFontCharacter>& expectedCharacters = expected.getVariants()[variant].characters;
+        const std::vector<TextureFontCharacter>& actualCharacters = actual.getVariants()[variant].characters;
+        if (!CHECK(expectedCharacters.size() == actualCharacters.size())) {
+            continue;
+        }
+        for (const TextureFontCharacter& character : expectedCharacters) {
+            auto found = std::find_if(actualCharacters.begin(), actualCharacters.end(), [&character](const TextureFontCharacter& other) {
+                return other.unicode == character.unicode && other.phase == character.phase;
+            });
+            if (!CHECK(found != actualCharacters.end())) {
+                continue;
+            }
+            CHECK(found->bitmapLeft == character.bitmapLeft && found->bitmapTop == character.bitmapTop);
+            CHECK(std::abs(found->horiAdvance - character.horiAdvance) < 1.0 / 65536);
+            CHECK(std::abs(found->vertAdvance - character.vertAdvance) < 1.0 / 65536);
+            CHECK(found->left == character.left && found->top == character.top);
+            CHECK(found->width == character.width && found->height == character.height);
+            CHECK(found->face == character.face && found->page == character.page);
+        }
+    }
+}
+
+static void testLegacyFormat(const std::filesystem::path& font) {
+    TextureFontCreator creator(font, 24, false, u8"AgÄ{ }", true, true);
+
+    std::string binary = writeTextureFont([&](std::ostream& fp) { creator.writeToFile(fp); });
+    std::shared_ptr<TextureFontReader> reader = readTextureFont(binary);
+    CHECK(reader->getFormat() == TextureFontFormat::Binary);
+    CHECK(reader->getFormatVersion() == LEGACY_FORMAT_VERSION);
+    CHECK(reader->getFormatFeatures() == 0);
+    CHECK(reader->getMipLevelCount() == 1);
+    CHECK(reader->getVariants().size() == 1 && reader->getVariants()[0].characters.size() == 6);
+    CHECK(equalImages(*reader->getGrayImage(), *creator.getImage()));
+
+    std::string json = writeTextureFont([&](std::ostream& fp) { creator.writeToJsonFile(fp); });
+    std::shared_ptr<TextureFontReader> jsonReader = readTextureFont(json);
+    CHECK(jsonReader->getFormat() == TextureFontFormat::Json);
+    CHECK(jsonReader->getFormatVersion() == LEGACY_FORMAT_VERSION);
+    CHECK(equalImages(*jsonReader->getGrayImage(), *creator.getImage()));
+    checkSameCharacters(*reader, *jsonReader);
+}
+
+static void testExtendedFormat(const std::filesystem::path& font) {
+    FontVariant regular;
+    regular.fontpath = font;
+    regular.fontSize = 20;
+    regular.chars = u8"Hello, World!";
+    regular.enableAntiAliasing = true;
+    regular.enableHinting = true;
+    FontVariant phases = regular;
+    phases.fontSize = 13;
+    phases.subpixelPhases = 3;
+
+    AtlasOptions options;
+    options.padding = 4;
+    options.extrude = 2;
+    options.mipLevels = 3;
+    options.sizeAlignment = 4;
+    TextureFontCreator creator({regular, phases}, false, options);
+
+    std::string plain = writeTextureFont([&](std::ostream& fp) { creator.writeToFile(fp); });
+    std::shared_ptr<TextureFontReader> reader = readTextureFont(plain);
+    CHECK(reader->getFormatVersion() == EXTENDED_FORMAT_VERSION);
+    CHECK(reader->getFormatFeatures() == 0);
+    CHECK(!reader->hasColorPage());
+    CHECK(reader->getPadding() == 4 && reader->getExtrude() == 2);
+    CHECK(reader->getVariants().size() == 2);
+    CHECK(reader->getVariants()[1].subpixelPhases == 3);
+    if (CHECK(reader->getMipLevelCount() == 3)) {
+        for (uint32_t level = 0; level < 3; level++) {
+            CHECK(equalImages(*reader->getGrayImage(level), *creator.getMipLevel(level)));
+        }
+    }
+
+    for (MetricsEncoding encoding : {MetricsEncoding::Compact, MetricsEncoding::CompactDelta}) {
+        std::string compact = writeTextureFont([&](std::ostream& fp) { creator.writeToFile(fp, encoding); });
+        std::shared_ptr<TextureFontReader> compactReader = readTextureFont(compact);
+        CHECK(compactReader->getMetricsEncoding() == encoding);
+        checkSameCharacters(*reader, *compactReader);
+    }
+
+    std::string compressed = writeTextureFont([&](std::ostream& fp) { creator.writeToFile(fp, MetricsEncoding::Plain, BlockFormat::BC4); });
+    std::shared_ptr<TextureFontReader> compressedReader = readTextureFont(compressed);
+    CHECK(compressedReader->getBlockFormat() == BlockFormat::BC4);
+    CHECK(compressedReader->getPixelData(1).size() == getCompressedSize(creator.getMipLevel(1)->getWidth(), creator.getMipLevel(1)->getHeight(), BlockFormat::BC4));
+    CHECK_THROWS(compressedReader->getImage());
+
+    std::string json = writeTextureFont([&](std::ostream& fp) { creator.writeToJsonFile(fp); });
+    std::shared_ptr<TextureFontReader> jsonReader = readTextureFont(json);
+    CHECK(jsonReader->getFormatVersion() == EXTENDED_FORMAT_VERSION);
+    CHECK(jsonReader->getMipLevelCount() == 3);
+    CHECK(equalImages(*jsonReader->getGrayImage(2), *creator.getMipLevel(2)));
+    checkSameCharacters(*reader, *jsonReader);
+}
+
+static void testColorPage(const std::filesystem::path& font) {
+    FontVariant variant;
+    variant.fontpath = font;
+    variant.fontSize = 20;
+    variant.chars = u8"AB\U0001F600";
+    variant.enableAntiAliasing = true;
+    variant.enableHinting = true;
+
+    // the test font has no color glyphs, so a color glyph is put into the glyph cache
+    std::shared_ptr<ImageCharacter> emoji(new ImageCharacter());
+    emoji->rgbaImage.reset(new ColorImage(17, 15, 4));
+    for (uint32_t y = 0; y < 15; y++) {
+        for (uint32_t x = 0; x < 17; x++) {
+            uint8_t* pixel = emoji->rgbaImage->getRow(y) + 4 * x;
+            pixel[0] = x * 10;
+            pixel[1] = y * 10;
+            pixel[2] = 77;
+            pixel[3] = 255;
+        }
+    }
+    emoji->image = emoji->rgbaImage->getGrayImage();
+    emoji->unicode = 0x1F600;
+    emoji->bitmap_left = 1;
+    emoji->bitmap_top = 14;
+    emoji->horiAdvance = 20;
+    emoji->vertAdvance = 24;
+    emoji->width = 17;
+    emoji->height = 15;
+    variant.glyphCache.reset(new GlyphCache());
+    variant.glyphCache->insert(variant, {emoji});
+
+    TextureFontCreator creator({variant}, false);
+    if (!CHECK(creator.getColorPage() != nullptr)) {
+        return;
+    }
+
+    std::vector<std::string> files = {
+        writeTextureFont([&](std::ostream& fp) { creator.writeToFile(fp); }),
+        writeTextureFont([&](std::ostream& fp) { creator.writeToFile(fp, MetricsEncoding::CompactDelta); }),
+        writeTextureFont([&](std::ostream& fp) { creator.writeToJsonFile(fp); })
+    };
+    for (const std::string& file : files) {
+        std::shared_ptr<TextureFontReader> reader = readTextureFont(file);
+        CHECK(reader->getFormatVersion() == EXTENDED_FORMAT_VERSION);
+        CHECK(reader->getFormatFeatures() == FORMAT_FEATURE_COLOR_PAGE);
+        if (!CHECK(reader->hasColorPage())) {
+            continue;
+        }
+        CHECK(equalImages(*reader->getColorPage(), *creator.getColorPage()));
+        for (const TextureFontCharacter& character : reader->getVariants()[0].characters) {
+            CHECK(character.page == ((character.unicode == 0x1F600) ? 1u : 0u));
+            if (character.unicode == 0x1F600) {
+                const uint8_t* pixel = reader->getColorPage()->getRow(character.top + 3) + 4 * (character.left + 5);
+                CHECK(pixel[0] == 50 && pixel[1] == 30 && pixel[2] == 77 && pixel[3] == 255);
+            }
+        }
+    }
+    std::stringstream simple;
+    CHECK_THROWS(creator.writeToSimpleFile(simple));
+}
+
+static void testSimpleFormat(const std::filesystem::path& font) {
+    TextureFontCreator creator(font, 16, true, u8"ABCä", false, true);
+    std::string simple = writeTextureFont([&](std::ostream& fp) { creator.writeToSimpleFile(fp, Codepage::CP437); });
+    std::shared_ptr<TextureFontReader> reader = readTextureFont(simple);
+    CHECK(reader->getFormat() == TextureFontFormat::Simple);
+    CHECK(reader->getFormatVersion() == 1);
+    CHECK(equalImages(*reader->getGrayImage(), *creator.getImage()));
+
+    // characters are stored with their code in the code page, ä is 0x84 in CP437
+    std::vector<uint32_t> codes;
+    for (const TextureFontCharacter& character : reader->getVariants()[0].characters) {
+        codes.push_back(character.unicode);
+    }
+    std::sort(codes.begin(), codes.end());
+    CHECK(codes == std::vector<uint32_t>({'A', 'B', 'C', 0x84}));
+
+    std::shared_ptr<TextureFontReader> binaryReader = readTextureFont(writeTextureFont([&](std::ostream& fp) { creator.writeToFile(fp); }));
+    const TextureFontCharacter& binaryA = *std::find_if(binaryReader->getVariants()[0].characters.begin(), binaryReader->getVariants()[0].characters.end(),
+                                                        [](const TextureFontCharacter& character) { return character.unicode == 'A'; });
+    const TextureFontCharacter& simpleA = *std::find_if(reader->getVariants()[0].characters.begin(), reader->getVariants()[0].characters.end(),
+                                                        [](const TextureFontCharacter& character) { return character.unicode == 'A'; });
+    CHECK(simpleA.left == binaryA.left && simpleA.top == binaryA.top && simpleA.width == binaryA.width && simpleA.bitmapTop == binaryA.bitmapTop);
+}
+
+/*! \brief the substitute code keeps its own character, whatever the order of the unmappable characters */
+static void testSubstituteCharacters(const std::filesystem::path& font) {
+    for (const char8_t* chars : {u8"€A?Ж", u8"ЖA€?", u8"?€ЖA"}) {
+        TextureFontCreator creator(font, 16, true, chars, false, true);
+        std::shared_ptr<TextureFontReader> reader = readTextureFont(writeTextureFont([&](std::ostream& fp) {
+            creator.writeToSimpleFile(fp, Codepage::CP437, UnmappableCharacters::Substitute, '?');
+        }));
+        std::shared_ptr<TextureFontReader> binaryReader = readTextureFont(writeTextureFont([&](std::ostream& fp) { creator.writeToFile(fp); }));
+        const std::vector<TextureFontCharacter>& binaryCharacters = binaryReader->getVariants()[0].characters;
+        const TextureFontCharacter& binaryQuestionMark = *std::find_if(binaryCharacters.begin(), binaryCharacters.end(),
+                                                                       [](const TextureFontCharacter& character) { return character.unicode == '?'; });
+
+        const std::vector<TextureFontCharacter>& characters = reader->getVariants()[0].characters;
+        if (!CHECK(characters.size() == 2)) {
+            continue;
+        }
+        for (const TextureFontCharacter& character : characters) {
+            CHECK(character.unicode == 'A' || character.unicode == '?');
+            if (character.unicode == '?') {
+                CHECK(character.left == binaryQuestionMark.left && character.top == binaryQuestionMark.top);
+            }
+        }
+    }
+
+    // without the character of the substitute code, unmappable characters could not be drawn
+    TextureFontCreator creator(font, 16, true, u8"€A", false, true);
+    std::stringstream simple;
+    CHECK_THROWS(creator.writeToSimpleFile(simple, Codepage::CP437, UnmappableCharacters::Substitute, '?'));
+    CHECK_THROWS(creator.writeToSimpleFile(simple, Codepage::ISO_8859_7, UnmappableCharacters::Substitute, 0xAE));
+}
+
+/*! \brief every truncated or corrupted file has to be rejected with an exception */
+static void testMalformedFiles(const std::filesystem::path& font) {
+    AtlasOptions options;
+    options.mipLevels = 2;
+    FontVariant variant;
+    variant.fontpath = font;
+    variant.fontSize = 10;
+    variant.chars = u8"xy";
+    variant.enableAntiAliasing = true;
+    variant.enableHinting = true;
+    TextureFontCreator creator({variant}, false, options);
+
+    for (MetricsEncoding encoding : {MetricsEncoding::Plain, MetricsEncoding::CompactDelta}) {
+        std::string file = writeTextureFont([&](std::ostream& fp) { creator.writeToFile(fp, encoding); });
+        for (size_t size = 0; size < file.size(); size++) {
+            CHECK_THROWS(readTextureFont(file.substr(0, size)));
+        }
+    }
+
+    std::string file = writeTextureFont([&](std::ostream& fp) { creator.writeToFile(fp); });
+    std::string unknownFeature = file;
+    size_t featuresOffset = 6 + 2 + 4 + creator.getFontName().size() + 4 + 4 + 1 + 1;
+    unknownFeature[featuresOffset + 1] = 1;
+    CHECK_THROWS(readTextureFont(unknownFeature));
+
+    std::string unknownVersion = file;
+    unknownVersion[6] = 11;
+    CHECK_THROWS(readTextureFont(unknownVersion));
+}
+
+/*! \brief dimensions whose size in bytes overflows must not pass the bounds checks */
+static void testOverflowingDimensions() {
+    std::string file("ytf252", 6);
+    auto append = [&file](const auto& value) { file.append(reinterpret_cast<const char*>(&value), sizeof(value)); };
+    append(EXTENDED_FORMAT_VERSION);
+    append(uint32_t(0)); // font name
+    append(uint32_t(0x80000000)); // width
+    append(uint32_t(0x80000000)); // height
+    append(uint8_t(4)); // channels
+    append(BlockFormat::None);
+    append(uint32_t(0)); // features
+    file.resize(70, 1);
+    CHECK_THROWS(readTextureFont(file));
+}
+
+int main() {
+    testOverflowingDimensions();
+
+    std::filesystem::path font = getTestFont();
+    if (font.empty()) {
+        std::cerr << "test font not found, skipping tests rendering characters" << std::endl;
+        return (testResult() != 0) ? 1 : TEST_SKIPPED;
+    }
+    testLegacyFormat(font);
+    testExtendedFormat(font);
+    testColorPage(font);
+    testSimpleFormat(font);
+    testSubstituteCharacters(font);
+    testMalformedFiles(font);
+    return testResult();
+}